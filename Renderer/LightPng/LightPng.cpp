@@ -1,678 +1,1133 @@
-/** Part of the LightZPng library package, v1.02
- ** 2005-2006 Jere Sanisalo & Housemarque Inc
- **
- ** License for this file (MIT):
- **
- ** Copyright (c) 2005 Jere Sanisalo & Housemarque Inc
- **
- ** Permission is hereby granted, free of charge, to any person obtaining a
- ** copy of this software and associated documentation files (the "Software"),
- ** to deal in the Software without restriction, including without limitation
- ** the rights to use, copy, modify, merge, publish, distribute, sublicense,
- ** and/or sell copies of the Software, and to permit persons to whom the
- ** Software is furnished to do so, subject to the following conditions:
- **
- ** The above copyright notice and this permission notice shall be included in
- ** all copies or substantial portions of the Software.
- **
- ** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- ** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- ** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- ** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- ** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
- ** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
- ** DEALINGS IN THE SOFTWARE.
- **/
-#define LIGHTPNG_INTERNAL
-#define LIGHTZ_INTERNAL
-#include "LightPng.h"
-#include "LightZ.h"
-//#include <stdio.h>
-
-#ifdef _MSC_VER
-#if(_MSC_VER<=1200)
-#define for if (false) {} else for
-#endif
-#endif
-
-#define LZ_META_ASSERT(x) typedef char LZ_META_ASSERT_##__LINE__[ (x) ? 1 : -1 ];
-
-typedef unsigned char LZuchar;
-typedef unsigned short LZushort;
-typedef unsigned int LZuint;
-
-typedef PNGNAME(Image) LightPng_Image;
-
-LZ_META_ASSERT( sizeof( LZuchar ) == 1 );
-LZ_META_ASSERT( sizeof( LZushort ) == 2 );
-LZ_META_ASSERT( sizeof( LZuint ) == 4 );
-
-#define CRC_START 0xffffffff
-
-#define for if (false) {} else for
-
-// The PNG chunk id's
-enum LightPng_ChunkIds
-{
-	// Mandatory chunks
-	Chunk_IHDR = 0x49484452,
-	Chunk_PLTE = 0x504C5445,
-	Chunk_IDAT = 0x49444154,
-	Chunk_IEND = 0x49454E44,
-
-	// Optional chunks
-	Chunk_pHYs = 0x70485973,
-	Chunk_gAMA = 0x67414D41,
-	Chunk_cHRM = 0x6348524D,
-	Chunk_tEXt = 0x74455874,
-	Chunk_tRNS = 0x74524E53,
-};
-
-// The adaptive filter
-enum LightPng_Filters
-{
-	Filter_None,
-	Filter_Sub,
-	Filter_Up,
-	Filter_Average,
-	Filter_Paeth,
-};
-
-// Class that holds the IDAT chunk data until it's used.
-// There is little logic to this. If only one data chunk is added, then it is used in-place.
-// If more are added, then new memory is allocated and it's used to store the concatenated result.
-class LightPng_Data
-{
-public:
-	const LZuchar *data;
-	int data_size;
-	bool free_data;				// Is custom allocated?
-
-	LightPng_Data()
-		: data( 0 )
-		, data_size( 0 )
-		, free_data( false )
-	{
-	}
-
-	~LightPng_Data()
-	{
-		Reset();
-	}
-
-	// Resets the container
-	void Reset()
-	{
-		if ( free_data && data != 0 )
-			delete [] (LZuchar *)data;
-		data = 0;
-		data_size = 0;
-		free_data = false;
-	}
-
-	// Adds the given data to the data container
-	void AddData( const LZuchar *src, int src_size )
-	{
-		if ( src == 0 || src_size <= 0 )
-			return;
-
-		// First data block?
-		if ( data == 0 )
-		{
-			data = src;
-			data_size = src_size;
-			free_data = false;
-			return;
-		}
-
-		// Allocate a new buffer
-		int new_size = data_size + src_size;
-		LZuchar *new_data = new LZuchar[ new_size ];
-		if ( new_data == 0 )
-			return;
-
-		// Copy the data (old & new)
-		for ( int i = 0; i < data_size; ++i )
-			new_data[ i ] = data[ i ];
-		for ( int i = 0; i < src_size; ++i )
-			new_data[ data_size + i ] = src[ i ];
-
-		// Replace buffers
-		Reset();
-		data = new_data;
-		data_size = new_size;
-		free_data = true;
-	}
-};
-
-// The PNG load state
-struct LightPng_State
-{
-	// The source data
-	const LZuchar *src;
-	int src_left;
-
-	// The error flag
-	bool has_errors;
-
-	// The CRC table
-	LZuint crc_table[ 256 ];
-	// The current CRC
-	LZuint crc;
-
-	LightPng_State()
-		: src( 0 )
-		, src_left( 0 )
-		, has_errors( false )
-		, crc( CRC_START )
-	{
-		// Calculate the CRC table
-		for ( int n = 0; n < 256; ++n )
-		{
-			LZuint crc = n;
-			for ( int k = 0; k < 8; ++k )
-			{
-				if ( crc & 1 )
-					crc = 0xedb88320 ^ (crc >> 1);
-				else
-					crc >>= 1;
-			}
-			crc_table[ n ] = crc;
-		}
-	}
-
-	// Reads one byte of input
-	LZuchar Read()
-	{
-		if ( src_left <= 0 )
-		{
-			has_errors = true;
-			return 0;
-		}
-
-		crc = UpdateCrc( crc, *src );
-
-		--src_left;
-		return *src++;
-	}
-
-	// Reads an integer (4 bytes) of input
-	LZuint ReadInt()
-	{
-		LZuint ret = Read() << 24;
-		ret |= Read() << 16;
-		ret |= Read() << 8;
-		return ret | Read();
-	}
-
-	// Skips x bytes of input
-	void Skip( int amt )
-	{
-		while (amt-- > 0 )
-			Read();
-	}
-
-	// Updates the CRC by the given data value
-	LZuint UpdateCrc( LZuint crc, LZuchar data )
-	{
-		return crc_table[ (crc ^ data) & 0xff ] ^ (crc >> 8);
-	}
-};
-
-// The image guardian (frees the image on error/abrupt exit)
-class LightPng_Image_Guardian
-{
-public:
-	LightPng_Image *img;
-
-	LightPng_Image_Guardian(): img( new LightPng_Image() ) { }
-	~LightPng_Image_Guardian() { if ( img != 0 ) delete img; }
-
-	LightPng_Image *operator -> () { return img; }
-};
-
-// Absolute function
-static inline int LightPng_Abs( int v )
-{
-	return (v < 0) ? -v : v;
-}
-
-// Pow function
-static inline int LightPng_Pow( int base, int exp)
-{
-	int v = 1;
-	while ( exp-- > 0 )
-		v *= base;
-	return v;
-}
-
-// Paeth predictor
-static inline LZuchar PaethPredictor( int a, int b, int c )
-{
-	int p = a + b - c;
-	int pa = LightPng_Abs( p - a );
-	int pb = LightPng_Abs( p - b );
-	int pc = LightPng_Abs( p - c );
-
-	if ( pa <= pb && pa <= pc )
-		return (LZuchar) a;
-	if ( pb <= pc )
-		return (LZuchar) b;
-	return (LZuchar) c;
-}
-
-PNGNAME(Image)::PNGNAME(Image)()
-	: width( 0 )
-	, height( 0 )
-	, has_palette( false )
-	, palette( 0 )
-	, palette_size( 0 )
-	, data( 0 )
-{
-}
-
-PNGNAME(Image)::~PNGNAME(Image)()
-{
-	if ( palette != 0 )
-		delete [] palette;
-	if ( data != 0 )
-		delete [] data;
-}
-
-// Create a .png image from the given data.
-// Returns null on error.
-PNGNAME(Image) *PNGNAME(Create)( const void *data, int data_size, LightZ_Env *z_env )
-{
-	if ( data == 0 || data_size <= 0 )
-		return 0;
-
-	// Create the load state
-	LightPng_State state;
-	state.src = (const LZuchar *) data;
-	state.src_left = data_size;
-
-	LightPng_Image_Guardian img;
-
-	// Read the signature
-#define SIG(x) if ( state.Read() != x ) return 0;
-	SIG( 137 )
-	SIG( 80 )
-	SIG( 78 )
-	SIG( 71 )
-	SIG( 13 )
-	SIG( 10 )
-	SIG( 26 )
-	SIG( 10 )
-#undef SIG
-
-	// Read the chunks
-	bool need_ihdr = true;
-
-	int color;
-	int bitspp;
-	int filtered_size = -1;
-
-	// Image data (raw, compressed)
-	LightPng_Data compressed_data;
-
-	bool end_found = false;
-	while ( !end_found )
-	{
-		// Read the chunk header
-		int chunk_len = state.ReadInt();
-		state.crc = CRC_START;
-		int chunk_type = state.ReadInt();
-
-		if ( chunk_len > state.src_left )
-			return 0;
-		if ( state.has_errors )
-			return 0;
-
-//		printf( "Chunk type 0x%X: %c%c%c%c\n", chunk_type, (char)((chunk_type>>24)&0xff), (char)((chunk_type>>16)&0xff), (char)((chunk_type>>8)&0xff), (char)((chunk_type>>0)&0xff) );
-
-		// Need a specific chunk?
-		if ( need_ihdr )
-		{
-			if ( chunk_type != Chunk_IHDR )
-				return 0;
-			need_ihdr = false;
-		}
-
-		// Process the chunk
-		switch ( chunk_type )
-		{
-		case Chunk_IHDR: // Header
-			{
-				img->width = state.ReadInt();
-				img->height = state.ReadInt();
-				int bpp = state.Read();
-				color = state.Read();
-				int compression = state.Read();
-				int filter = state.Read();
-				int ilace = state.Read();
-
-				// Only 24/32bit and palettized images allowed
-				switch ( color )
-				{
-				case 2: // RGB
-					bitspp = 24;
-					break;
-
-				case 3: // Palettized
-				{
-					bitspp = bpp;
-					img->palette_size = LightPng_Pow( 2, bitspp );
-					img->has_palette = true;
-					img->palette = new LightPng_Image::Color[ img->palette_size ];
-					if ( img->palette == 0 )
-						return 0;
-					if ( bpp != 1 && bpp != 2 && bpp != 4 && bpp != 8 )
-						return 0;
-					for ( int i = 0; i < img->palette_size; ++i )
-						img->palette[ i ] = 0x00000000;
-					}
-				    break;
-
-				case 6: // ARGB
-					bitspp = 32;
-					break;
-
-				default:
-					return 0;
-				}
-
-				// Only inflate/deflate compression is supported
-				if ( compression != 0 )
-					return 0;
-
-				// Adaptive filtering required
-				if ( filter != 0 )
-					return 0;
-
-				// Interlace is not supported
-				if ( ilace != 0 )
-					return 0;
-
-				// Calculate the filtered image size
-				filtered_size = (int)( 1 + (bitspp * img->width + 7) / 8 ) * img->height;
-			}
-			break;
-
-		case Chunk_PLTE: // Palette
-			{
-				if ( chunk_len <= 0 || (chunk_len % 3) != 0 )
-					return 0;
-				if ( (chunk_len / 3) > img->palette_size )
-					return 0;
-				if ( img->palette == 0 )
-					return 0;
-
-				int idx = 0;
-				while ( chunk_len > 0 )
-				{
-					int col = 0xff000000 | (state.Read() << 16);
-					col |= state.Read() << 8;
-					col |= state.Read();
-
-					img->palette[ idx++ ] = col;
-					chunk_len -= 3;
-				}
-			}
-			break;
-
-		case Chunk_IDAT:
-			{
-				// Collect the IDAT compressed raw image data for later processing
-				compressed_data.AddData( state.src, chunk_len );
-				state.Skip( chunk_len );
-			}
-			break;
-
-		case Chunk_IEND: // End chunk
-			end_found = true;
-			break;
-
-		case Chunk_tRNS: // Transparency
-			if ( color != 3 )
-			{ // Supported only for palettized images
-				state.Skip( chunk_len );
-				break;
-			}
-			if ( chunk_len > 256 )
-				return 0;
-			if ( img->palette == 0 )
-				return 0;
-
-			for ( int i = 0; i < chunk_len; ++i )
-			{
-				LZuchar a = state.Read();
-				img->palette[ i ] = (img->palette[ i ] & 0x00ffffff) | (a << 24);
-			}
-			break;
-
-		default: // Unknown chunk
-			state.Skip( chunk_len );
-			break;
-		}
-
-		// Test the crc
-		int my_crc = state.crc ^ 0xffffffff;
-		int test_crc = state.ReadInt();
-		if ( my_crc != test_crc )
-			return 0;
-	}
-
-	/////////////////////////////////////////////
-
-	// Process the IDAT chunk(s). The image data comes from here.
-	if ( compressed_data.data_size <= 0 )
-		return 0;
-
-	{
-		int data8bits_size = 0;
-
-		// Allocate enough memory
-		int line_pitch = (int)(1 + (bitspp * img->width + 7) / 8);
-
-		int data_size = line_pitch;
-		if ( color == 2 )
-		{ // RGB; allocate room for ARGB
-			data_size += img->width;
-		}
-
-		data_size *= img->height;
-		if ( bitspp >= 8)
-			img->data = new LZuchar[ data_size ];
-		else
-		{
-			data8bits_size = (1 * img->width);
-			data8bits_size *= img->height;
-			img->data = new LZuchar[ data8bits_size ];
-		}
-		if ( img->data == 0 )
-			return 0;
-
-		// Unpack the image
-		const char *err = ZFN(Inflate)( compressed_data.data, compressed_data.data_size, &img->data, &data_size, z_env );
-		if ( err != 0 )
-			return 0;
-		if ( data_size != filtered_size )
-			return 0;
-
-		// Unfilter the images
-		for ( int y = 0; y < img->height; ++y )
-		{
-			LZuchar *pos = &img->data[ line_pitch * y ];
-			LZuchar filter = *pos++;
-			if ( filter == Filter_None )
-				continue;
-			else if (bitspp < 8) //less than 8 bits not supported
-				return 0;
-
-			for ( int x = 0; x < img->width; ++x )
-			{
-				for ( int byte = 0; byte < (int)((bitspp+7) / 8); ++byte, ++pos )
-				{
-					LZuchar val = *pos;
-					LZuchar prev = (x == 0) ? 0 : *(pos-(int)((bitspp+7) / 8));
-					LZuchar prior = (y == 0) ? 0 : *(pos-line_pitch);
-					LZuchar prior_prev = (x == 0 || y == 0) ? 0 : *(pos-(int)((bitspp+7) / 8)-line_pitch);
-
-					switch ( filter )
-					{
-					case Filter_Sub:
-						*pos = (val + prev) & 0xff;
-						break;
-
-					case Filter_Up:
-						*pos = (val + prior) & 0xff;
-						break;
-
-					case Filter_Average:
-						*pos = (val + ((prev+prior)>>1)) & 0xff;
-						break;
-
-					case Filter_Paeth:
-						*pos = (val + PaethPredictor( prev, prior, prior_prev )) & 0xff;
-						break;
-
-					default: // Unknown filter
-						return 0;
-					}
-				}
-			}
-		}
-
-		// Remove the filter bytes from each scanline
-		for ( int y = 0; y < img->height; ++y )
-		{
-			LZuchar *dest = &img->data[ (line_pitch-1) * y ];
-			LZuchar *src = &img->data[ 1 + (line_pitch * y) ];
-
-			int left = line_pitch - 1;
-			while ( left-- > 0 )
-				*dest++ = *src++;
-		}
-		--line_pitch; // no more filter bytes
-
-		// Make the buffer 1,2,4bits ->to-> 8bits
-		if (color == 3 && data8bits_size != 0)
-		{
-			int new_line_pitch = img->width;
-
-			for ( int y = img->height - 1; y >= 0; --y )
-			{
-				LZuchar *s = &img->data[ line_pitch * y ];
-				LZuchar *d = &img->data[ new_line_pitch * y ];
-
-				int divider = (8 / bitspp);
-				int skipBits = 0;
-				if (img->width % divider)
-					skipBits = 1;
-				for ( int x = (img->width / divider) - 1; x >= 0; --x )
-				{
-					if (bitspp == 4)
-					{
-						if (skipBits)
-						{
-							d[ x * divider + 2 ] = (s[ x + 1 ] >> 4) & 0xf;
-							skipBits = 0;
-						}
-						d[ x * divider + 1 ] = (s[ x ]) & 0xf;
-						d[ x * divider ] = (s[ x ] >> 4) & 0xf;
-					}
-					else if (bitspp == 2)
-					{
-						if (skipBits)
-						{
-							int shift = 0;
-							for (int i = 7; i >= 4; --i, shift +=2)
-							{
-								if (x * divider + i < img->width)
-									d[ x * divider + i ] = (s[ x + 1 ] >> shift) & 0x3;
-							}
-							skipBits = 0;
-						}
-						d[ x * divider + 3 ] = (s[ x ]) & 0x3;
-						d[ x * divider + 2 ] = (s[ x ] >> 2) & 0x3;
-						d[ x * divider + 1 ] = (s[ x ] >> 4) & 0x3;
-						d[ x * divider ] = (s[ x ] >> 6) & 0x3;
-					}
-					else if (bitspp == 1)
-					{
-						if (skipBits)
-						{
-							int shift = 0;
-							for (int i = 15; i >= 8; --i, shift ++)
-							{
-								if (x * divider + i < img->width)
-									d[ x * divider + i ] = (s[ x + 1 ] >> shift) & 0x1;
-							}
-							skipBits = 0;
-						}
-						d[ x * divider + 7 ] = (s[ x ]) & 0x1;
-						d[ x * divider + 6 ] = (s[ x ] >> 1) & 0x1;
-						d[ x * divider + 5 ] = (s[ x ] >> 2) & 0x1;
-						d[ x * divider + 4 ] = (s[ x ] >> 3) & 0x1;
-						d[ x * divider + 3 ] = (s[ x ] >> 4) & 0x1;
-						d[ x * divider + 2 ] = (s[ x ] >> 5) & 0x1;
-						d[ x * divider + 1 ] = (s[ x ] >> 6) & 0x1;
-						d[ x * divider ] = (s[ x ] >> 7) & 0x1;
-					}
-				}
-			}
-			line_pitch = new_line_pitch;
-		}
-
-		// Extend the RGB -> RGBA (copy backwards)
-		if ( color == 2 )
-		{
-			int new_line_pitch = img->width * 4;
-
-			for ( int y = img->height - 1; y >= 0; --y )
-			{
-				LZuchar *s = &img->data[ line_pitch * y ];
-				LZuchar *d = &img->data[ new_line_pitch * y ];
-
-				for ( int x = img->width - 1; x >= 0; --x )
-				{
-					int x1 = x * 3;
-					int x2 = x * 4;
-					d[ x2 + 3 ] = 0xff;
-					d[ x2 + 2 ] = s[ x1 + 2 ];
-					d[ x2 + 1 ] = s[ x1 + 1 ];
-					d[ x2 + 0 ] = s[ x1 + 0 ];
-				}
-			}
-
-			line_pitch = new_line_pitch;
-			color = 6;
-		}
-
-		// Convert RGBA -> ARGB
-		if ( color == 2 || color == 6 )
-		{
-			for ( int y = 0; y < img->height; ++y )
-			{
-				LZuchar *pos = &img->data[ line_pitch * y ];
-				int left = img->width;
-				while ( left-- > 0 )
-				{
-					LZuchar r = *(pos + 0);
-					LZuchar g = *(pos + 1);
-					LZuchar b = *(pos + 2);
-					LZuchar a = *(pos + 3);
-					*pos++ = a;
-					*pos++ = r;
-					*pos++ = g;
-					*pos++ = b;
-				}
-			}
-		}
-	}
-
-	// Release the image and return it
-	LightPng_Image *ret = img.img;
-	img.img = 0;
-	return ret;
-}
+/** Part of the LightZPng library package, v1.02
+ ** 2005-2006 Jere Sanisalo & Housemarque Inc
+ **
+ ** License for this file (MIT):
+ **
+ ** Copyright (c) 2005 Jere Sanisalo & Housemarque Inc
+ **
+ ** Permission is hereby granted, free of charge, to any person obtaining a
+ ** copy of this software and associated documentation files (the "Software"),
+ ** to deal in the Software without restriction, including without limitation
+ ** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ ** and/or sell copies of the Software, and to permit persons to whom the
+ ** Software is furnished to do so, subject to the following conditions:
+ **
+ ** The above copyright notice and this permission notice shall be included in
+ ** all copies or substantial portions of the Software.
+ **
+ ** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ ** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ ** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ ** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ ** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ ** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ ** DEALINGS IN THE SOFTWARE.
+ **/
+#define LIGHTPNG_INTERNAL
+#define LIGHTZ_INTERNAL
+#include "LightPng.h"
+#include "LightZ.h"
+//#include <stdio.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIGHTPNG_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(LIGHTPNG_SSE2) && (defined(__SSSE3__) || defined(__AVX__))
+#define LIGHTPNG_SSSE3
+#include <tmmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#if(_MSC_VER<=1200)
+#define for if (false) {} else for
+#endif
+#endif
+
+#define LZ_META_ASSERT(x) typedef char LZ_META_ASSERT_##__LINE__[ (x) ? 1 : -1 ];
+
+typedef unsigned char LZuchar;
+typedef unsigned short LZushort;
+typedef unsigned int LZuint;
+
+typedef PNGNAME(Image) LightPng_Image;
+typedef PNGNAME(Format) LightPng_Format;
+typedef PNGNAME(Stream) LightPng_Stream;
+typedef PNGNAME(RowFunc) LightPng_RowFunc;
+
+LZ_META_ASSERT( sizeof( LZuchar ) == 1 );
+LZ_META_ASSERT( sizeof( LZushort ) == 2 );
+LZ_META_ASSERT( sizeof( LZuint ) == 4 );
+
+#define CRC_START 0xffffffff
+
+#define for if (false) {} else for
+
+// The PNG chunk id's
+enum LightPng_ChunkIds
+{
+	// Mandatory chunks
+	Chunk_IHDR = 0x49484452,
+	Chunk_PLTE = 0x504C5445,
+	Chunk_IDAT = 0x49444154,
+	Chunk_IEND = 0x49454E44,
+
+	// Optional chunks
+	Chunk_pHYs = 0x70485973,
+	Chunk_gAMA = 0x67414D41,
+	Chunk_cHRM = 0x6348524D,
+	Chunk_tEXt = 0x74455874,
+	Chunk_tRNS = 0x74524E53,
+};
+
+// The adaptive filter
+enum LightPng_Filters
+{
+	Filter_None,
+	Filter_Sub,
+	Filter_Up,
+	Filter_Average,
+	Filter_Paeth,
+};
+
+// The CRC tables for slice-by-8 CRC calculation. Built once at startup, read only after that.
+struct LightPng_CrcTable
+{
+	// table[ 0 ] is the normal byte-at-a-time table, table[ k ] advances a byte over k more zero bytes
+	LZuint table[ 8 ][ 256 ];
+
+	LightPng_CrcTable()
+	{
+		for ( int n = 0; n < 256; ++n )
+		{
+			LZuint crc = n;
+			for ( int k = 0; k < 8; ++k )
+			{
+				if ( crc & 1 )
+					crc = 0xedb88320 ^ (crc >> 1);
+				else
+					crc >>= 1;
+			}
+			table[ 0 ][ n ] = crc;
+		}
+
+		for ( int n = 0; n < 256; ++n )
+		{
+			for ( int k = 1; k < 8; ++k )
+				table[ k ][ n ] = table[ 0 ][ table[ k - 1 ][ n ] & 0xff ] ^ (table[ k - 1 ][ n ] >> 8);
+		}
+	}
+};
+
+static const LightPng_CrcTable g_crc;
+
+// Updates the CRC by the given data, 8 bytes at a time
+static LZuint UpdateCrc( LZuint crc, const LZuchar *data, int len )
+{
+	const LZuint (*t)[ 256 ] = g_crc.table;
+
+	while ( len >= 8 )
+	{
+		LZuint lo = crc ^ ( data[ 0 ] | (data[ 1 ] << 8) | (data[ 2 ] << 16) | ((LZuint) data[ 3 ] << 24) );
+		LZuint hi = data[ 4 ] | (data[ 5 ] << 8) | (data[ 6 ] << 16) | ((LZuint) data[ 7 ] << 24);
+
+		crc = t[ 7 ][ lo & 0xff ] ^ t[ 6 ][ (lo >> 8) & 0xff ] ^ t[ 5 ][ (lo >> 16) & 0xff ] ^ t[ 4 ][ lo >> 24 ] ^
+			  t[ 3 ][ hi & 0xff ] ^ t[ 2 ][ (hi >> 8) & 0xff ] ^ t[ 1 ][ (hi >> 16) & 0xff ] ^ t[ 0 ][ hi >> 24 ];
+
+		data += 8;
+		len -= 8;
+	}
+
+	while ( len-- > 0 )
+		crc = t[ 0 ][ (crc ^ *data++) & 0xff ] ^ (crc >> 8);
+
+	return crc;
+}
+
+// The PNG load state
+struct LightPng_State
+{
+	// The source data
+	const LZuchar *src;
+	int src_left;
+
+	// The error flag
+	bool has_errors;
+
+	LightPng_State()
+		: src( 0 )
+		, src_left( 0 )
+		, has_errors( false )
+	{
+	}
+
+	// Reads one byte of input
+	LZuchar Read()
+	{
+		if ( src_left <= 0 )
+		{
+			has_errors = true;
+			return 0;
+		}
+
+		--src_left;
+		return *src++;
+	}
+
+	// Reads an integer (4 bytes) of input
+	LZuint ReadInt()
+	{
+		LZuint ret = Read() << 24;
+		ret |= Read() << 16;
+		ret |= Read() << 8;
+		return ret | Read();
+	}
+
+	// Skips x bytes of input
+	void Skip( int amt )
+	{
+		if ( amt <= 0 )
+			return;
+		if ( amt > src_left )
+		{
+			has_errors = true;
+			amt = src_left;
+		}
+
+		src += amt;
+		src_left -= amt;
+	}
+};
+
+// The image guardian (frees the image on error/abrupt exit)
+class LightPng_Image_Guardian
+{
+public:
+	LightPng_Image *img;
+
+	LightPng_Image_Guardian(): img( new LightPng_Image() ) { }
+	~LightPng_Image_Guardian() { if ( img != 0 ) delete img; }
+
+	LightPng_Image *operator -> () { return img; }
+};
+
+// Absolute function
+static inline int LightPng_Abs( int v )
+{
+	return (v < 0) ? -v : v;
+}
+
+// Pow function
+static inline int LightPng_Pow( int base, int exp)
+{
+	int v = 1;
+	while ( exp-- > 0 )
+		v *= base;
+	return v;
+}
+
+// Paeth predictor
+static inline LZuchar PaethPredictor( int a, int b, int c )
+{
+	int p = a + b - c;
+	int pa = LightPng_Abs( p - a );
+	int pb = LightPng_Abs( p - b );
+	int pc = LightPng_Abs( p - c );
+
+	if ( pa <= pb && pa <= pc )
+		return (LZuchar) a;
+	if ( pb <= pc )
+		return (LZuchar) b;
+	return (LZuchar) c;
+}
+
+///////////////////////////////////
+// Unfilter row kernels.
+// row points to the row data (after the filter byte), prior to the previous (already
+// unfiltered) row, len is the row length in bytes and bpp the bytes per pixel.
+
+typedef void (*LightPng_UnfilterFunc)( LZuchar *row, const LZuchar *prior, int len, int bpp );
+
+// None, and Up on the first row (the prior row is all zeros): the row is as it is
+static void UnfilterNone( LZuchar *, const LZuchar *, int, int )
+{
+}
+
+static void UnfilterSub( LZuchar *row, const LZuchar *, int len, int bpp )
+{
+	for ( int i = bpp; i < len; ++i )
+		row[ i ] = (LZuchar)( row[ i ] + row[ i - bpp ] );
+}
+
+static void UnfilterUp( LZuchar *row, const LZuchar *prior, int len, int )
+{
+	int i = 0;
+#ifdef LIGHTPNG_SSE2
+	for ( ; i + 16 <= len; i += 16 )
+	{
+		__m128i v = _mm_loadu_si128( (const __m128i *) &row[ i ] );
+		__m128i b = _mm_loadu_si128( (const __m128i *) &prior[ i ] );
+		_mm_storeu_si128( (__m128i *) &row[ i ], _mm_add_epi8( v, b ) );
+	}
+#endif
+	for ( ; i < len; ++i )
+		row[ i ] = (LZuchar)( row[ i ] + prior[ i ] );
+}
+
+static void UnfilterAverage( LZuchar *row, const LZuchar *prior, int len, int bpp )
+{
+	for ( int i = 0; i < bpp; ++i )
+		row[ i ] = (LZuchar)( row[ i ] + (prior[ i ] >> 1) );
+	for ( int i = bpp; i < len; ++i )
+		row[ i ] = (LZuchar)( row[ i ] + ((row[ i - bpp ] + prior[ i ]) >> 1) );
+}
+
+static void UnfilterPaeth( LZuchar *row, const LZuchar *prior, int len, int bpp )
+{
+	for ( int i = 0; i < bpp; ++i )
+		row[ i ] = (LZuchar)( row[ i ] + prior[ i ] );
+	for ( int i = bpp; i < len; ++i )
+		row[ i ] = (LZuchar)( row[ i ] + PaethPredictor( row[ i - bpp ], prior[ i ], prior[ i - bpp ] ) );
+}
+
+// Average filter for the first row (the prior row is all zeros)
+static void UnfilterAverageFirst( LZuchar *row, const LZuchar *, int len, int bpp )
+{
+	for ( int i = bpp; i < len; ++i )
+		row[ i ] = (LZuchar)( row[ i ] + (row[ i - bpp ] >> 1) );
+}
+
+#ifdef LIGHTPNG_SSE2
+// 3 and 4 byte pixel kernels. Sub, Average and Paeth depend on the previous pixel, so
+// these work one pixel at a time with all of its channels in one register.
+
+static inline __m128i LoadPixel3( const LZuchar *p )
+{
+	int v = 0;
+	memcpy( &v, p, 3 );
+	return _mm_cvtsi32_si128( v );
+}
+
+static inline void StorePixel3( LZuchar *p, __m128i v )
+{
+	int i = _mm_cvtsi128_si32( v );
+	memcpy( p, &i, 3 );
+}
+
+static inline __m128i LoadPixel4( const LZuchar *p )
+{
+	int v;
+	memcpy( &v, p, 4 );
+	return _mm_cvtsi32_si128( v );
+}
+
+static inline void StorePixel4( LZuchar *p, __m128i v )
+{
+	int i = _mm_cvtsi128_si32( v );
+	memcpy( p, &i, 4 );
+}
+
+// Sub: x += a
+template < int BPP >
+static void UnfilterSubSSE2( LZuchar *row, const LZuchar *, int len, int )
+{
+	__m128i a = _mm_setzero_si128();
+	for ( int i = 0; i < len; i += BPP )
+	{
+		__m128i x = (BPP == 3) ? LoadPixel3( &row[ i ] ) : LoadPixel4( &row[ i ] );
+		a = _mm_add_epi8( x, a );
+		if ( BPP == 3 ) StorePixel3( &row[ i ], a ); else StorePixel4( &row[ i ], a );
+	}
+}
+
+// Average: x += (a + b) >> 1 (pavgb rounds up, so the lost low bit is subtracted)
+template < int BPP >
+static void UnfilterAverageSSE2( LZuchar *row, const LZuchar *prior, int len, int )
+{
+	const __m128i one = _mm_set1_epi8( 1 );
+	__m128i a = _mm_setzero_si128();
+	for ( int i = 0; i < len; i += BPP )
+	{
+		__m128i x = (BPP == 3) ? LoadPixel3( &row[ i ] ) : LoadPixel4( &row[ i ] );
+		__m128i b = (BPP == 3) ? LoadPixel3( &prior[ i ] ) : LoadPixel4( &prior[ i ] );
+
+		__m128i avg = _mm_avg_epu8( a, b );
+		avg = _mm_sub_epi8( avg, _mm_and_si128( _mm_xor_si128( a, b ), one ) );
+
+		a = _mm_add_epi8( x, avg );
+		if ( BPP == 3 ) StorePixel3( &row[ i ], a ); else StorePixel4( &row[ i ], a );
+	}
+}
+
+static inline __m128i AbsEpi16( __m128i v )
+{
+	return _mm_max_epi16( v, _mm_sub_epi16( _mm_setzero_si128(), v ) );
+}
+
+static inline __m128i Select( __m128i mask, __m128i if_set, __m128i if_clear )
+{
+	return _mm_or_si128( _mm_and_si128( mask, if_set ), _mm_andnot_si128( mask, if_clear ) );
+}
+
+// Paeth, on 16 bit channels: pa = |b - c|, pb = |a - c|, pc = |a + b - 2c|; ties prefer a, then b
+template < int BPP >
+static void UnfilterPaethSSE2( LZuchar *row, const LZuchar *prior, int len, int )
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i a = zero;
+	__m128i c = zero;
+	for ( int i = 0; i < len; i += BPP )
+	{
+		__m128i x = (BPP == 3) ? LoadPixel3( &row[ i ] ) : LoadPixel4( &row[ i ] );
+		__m128i b = _mm_unpacklo_epi8( (BPP == 3) ? LoadPixel3( &prior[ i ] ) : LoadPixel4( &prior[ i ] ), zero );
+
+		__m128i pa = _mm_sub_epi16( b, c );
+		__m128i pb = _mm_sub_epi16( a, c );
+		__m128i pc = AbsEpi16( _mm_add_epi16( pa, pb ) );
+		pa = AbsEpi16( pa );
+		pb = AbsEpi16( pb );
+
+		__m128i smallest = _mm_min_epi16( pc, _mm_min_epi16( pa, pb ) );
+		__m128i pred = Select( _mm_cmpeq_epi16( smallest, pa ), a,
+							   Select( _mm_cmpeq_epi16( smallest, pb ), b, c ) );
+
+		a = _mm_unpacklo_epi8( _mm_add_epi8( x, _mm_packus_epi16( pred, pred ) ), zero );
+		c = b;
+		if ( BPP == 3 ) StorePixel3( &row[ i ], _mm_packus_epi16( a, a ) ); else StorePixel4( &row[ i ], _mm_packus_epi16( a, a ) );
+	}
+}
+#endif
+
+// Picks the unfilter kernel for a row. Null means the filter is unknown; the filters that
+// leave the row as it is get UnfilterNone.
+static LightPng_UnfilterFunc GetUnfilterFunc( int filter, int bpp, bool first_row )
+{
+	if ( filter == Filter_None )
+		return UnfilterNone;
+	if ( first_row )
+	{ // The prior row is all zeros: Up does nothing and Paeth always predicts from the left
+		switch ( filter )
+		{
+		case Filter_Up:			return UnfilterNone;
+		case Filter_Average:	return UnfilterAverageFirst;
+		case Filter_Paeth:		filter = Filter_Sub; break;
+		}
+	}
+
+#ifdef LIGHTPNG_SSE2
+	if ( bpp == 3 || bpp == 4 )
+	{
+		switch ( filter )
+		{
+		case Filter_Sub:		return (bpp == 3) ? UnfilterSubSSE2< 3 > : UnfilterSubSSE2< 4 >;
+		case Filter_Up:			return UnfilterUp;
+		case Filter_Average:	return (bpp == 3) ? UnfilterAverageSSE2< 3 > : UnfilterAverageSSE2< 4 >;
+		case Filter_Paeth:		return (bpp == 3) ? UnfilterPaethSSE2< 3 > : UnfilterPaethSSE2< 4 >;
+		}
+	}
+#endif
+
+	switch ( filter )
+	{
+	case Filter_Sub:		return UnfilterSub;
+	case Filter_Up:			return UnfilterUp;
+	case Filter_Average:	return UnfilterAverage;
+	case Filter_Paeth:		return UnfilterPaeth;
+	}
+	return 0;
+}
+
+///////////////////////////////////
+// Color conversion from the unfiltered row data (after the filter byte). Both also work
+// in place, converting the rows of a whole image buffer.
+
+static inline void StoreColor( LZuchar *d, LZuint a, LZuint r, LZuint g, LZuint b, LightPng_Format format )
+{
+	if ( format == PNGNAME(Format_XRGB32) )
+	{
+		LZuint col = (a << 24) | (r << 16) | (g << 8) | b;
+		memcpy( d, &col, 4 );
+	}
+	else
+	{
+		d[ 0 ] = (LZuchar) a;
+		d[ 1 ] = (LZuchar) r;
+		d[ 2 ] = (LZuchar) g;
+		d[ 3 ] = (LZuchar) b;
+	}
+}
+
+// RGB -> 32 bit colors. The destination grows, so this runs backwards.
+static void ConvertRowRGB( LZuchar *d, const LZuchar *s, int width, LightPng_Format format )
+{
+	int x = width - 1;
+
+#ifdef LIGHTPNG_SSSE3
+	// 4 pixels per step; the 16 byte loads must stay within the row
+	int simd_pixels = (width * 3 >= 16) ? ((width * 3 - 4) / 12) * 4 : 0;
+	for ( ; x >= simd_pixels; --x )
+		StoreColor( &d[ x * 4 ], 0xff, s[ x * 3 + 0 ], s[ x * 3 + 1 ], s[ x * 3 + 2 ], format );
+
+	__m128i shuffle, alpha;
+	if ( format == PNGNAME(Format_XRGB32) )
+	{
+		shuffle = _mm_setr_epi8( 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1 );
+		alpha = _mm_set1_epi32( (int) 0xff000000 );
+	}
+	else
+	{
+		shuffle = _mm_setr_epi8( -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11 );
+		alpha = _mm_set1_epi32( 0x000000ff );
+	}
+
+	for ( x = simd_pixels - 4; x >= 0; x -= 4 )
+	{
+		__m128i v = _mm_loadu_si128( (const __m128i *) &s[ x * 3 ] );
+		v = _mm_or_si128( _mm_shuffle_epi8( v, shuffle ), alpha );
+		_mm_storeu_si128( (__m128i *) &d[ x * 4 ], v );
+	}
+#endif
+
+	for ( ; x >= 0; --x )
+		StoreColor( &d[ x * 4 ], 0xff, s[ x * 3 + 0 ], s[ x * 3 + 1 ], s[ x * 3 + 2 ], format );
+}
+
+// RGBA -> 32 bit colors. The destination shrinks (by the filter byte), so this runs forwards.
+static void ConvertRowRGBA( LZuchar *d, const LZuchar *s, int width, LightPng_Format format )
+{
+	int x = 0;
+
+#ifdef LIGHTPNG_SSE2
+	// As little endian words RGBA is 0xAABBGGRR; swap R and B for 0xAARRGGBB or rotate
+	// left by 8 bits for A, R, G, B bytes
+	const __m128i mask_ag = _mm_set1_epi32( (int) 0xff00ff00 );
+	const __m128i mask_rb = _mm_set1_epi32( 0x00ff00ff );
+	for ( ; x + 4 <= width; x += 4 )
+	{
+		__m128i v = _mm_loadu_si128( (const __m128i *) &s[ x * 4 ] );
+		if ( format == PNGNAME(Format_XRGB32) )
+		{
+			__m128i rb = _mm_and_si128( v, mask_rb );
+			rb = _mm_or_si128( _mm_slli_epi32( rb, 16 ), _mm_srli_epi32( rb, 16 ) );
+			v = _mm_or_si128( _mm_and_si128( v, mask_ag ), rb );
+		}
+		else
+			v = _mm_or_si128( _mm_slli_epi32( v, 8 ), _mm_srli_epi32( v, 24 ) );
+		_mm_storeu_si128( (__m128i *) &d[ x * 4 ], v );
+	}
+#endif
+
+	for ( ; x < width; ++x )
+	{
+		const LZuchar *p = &s[ x * 4 ];
+		StoreColor( &d[ x * 4 ], p[ 3 ], p[ 0 ], p[ 1 ], p[ 2 ], format );
+	}
+}
+
+// Expands 1, 2 or 4 bit palette indices to 8 bits. Runs backwards, so d may be s.
+static void ExpandRowIndices( LZuchar *d, const LZuchar *s, int width, int bitspp )
+{
+	int per_byte = 8 / bitspp;
+	int mask = (1 << bitspp) - 1;
+
+	for ( int x = width - 1; x >= 0; --x )
+	{
+		int shift = 8 - bitspp * (1 + (x % per_byte));
+		d[ x ] = (LZuchar)( (s[ x / per_byte ] >> shift) & mask );
+	}
+}
+
+// Unfilters one scanline (starting with the filter byte) given the prior one (null for
+// the first row). Returns false for unsupported filters.
+static bool UnfilterRow( LZuchar *row, const LZuchar *prior, int line_pitch, int bitspp )
+{
+	LZuchar filter = row[ 0 ];
+	if ( filter == Filter_None )
+		return true;
+	else if (bitspp < 8) //less than 8 bits not supported
+		return false;
+
+	int bytespp = (bitspp + 7) / 8;
+	LightPng_UnfilterFunc unfilter = GetUnfilterFunc( filter, bytespp, prior == 0 );
+	if ( unfilter == 0 ) // Unknown filter
+		return false;
+	unfilter( row + 1, (prior != 0) ? prior + 1 : 0, line_pitch - 1, bytespp );
+	return true;
+}
+
+///////////////////////////////////
+// Chunk readers
+
+// Reads the IHDR chunk. Returns false if the image can't be loaded.
+static bool ReadHeader( LightPng_State &state, LightPng_Image *img, int &color, int &bitspp )
+{
+	img->width = state.ReadInt();
+	img->height = state.ReadInt();
+	int bpp = state.Read();
+	color = state.Read();
+	int compression = state.Read();
+	int filter = state.Read();
+	int ilace = state.Read();
+
+	if ( state.has_errors )
+		return false;
+
+	// The largest buffer ((1 + width * 4) * height bytes) and row bit count must fit an int
+	if ( img->width <= 0 || img->height <= 0 || img->width > 0x7fffffff / 32 )
+		return false;
+	if ( img->width > (0x7fffffff / img->height - 1) / 4 )
+		return false;
+
+	// Only 24/32bit and palettized images allowed
+	switch ( color )
+	{
+	case 2: // RGB
+		bitspp = 24;
+		break;
+
+	case 3: // Palettized
+	{
+		if ( bpp != 1 && bpp != 2 && bpp != 4 && bpp != 8 )
+			return false;
+		bitspp = bpp;
+		img->palette_size = LightPng_Pow( 2, bitspp );
+		img->has_palette = true;
+		img->palette = new LightPng_Image::Color[ img->palette_size ];
+		if ( img->palette == 0 )
+			return false;
+		for ( int i = 0; i < img->palette_size; ++i )
+			img->palette[ i ] = 0x00000000;
+		}
+	    break;
+
+	case 6: // ARGB
+		bitspp = 32;
+		break;
+
+	default:
+		return false;
+	}
+
+	// Only inflate/deflate compression is supported
+	if ( compression != 0 )
+		return false;
+
+	// Adaptive filtering required
+	if ( filter != 0 )
+		return false;
+
+	// Interlace is not supported
+	if ( ilace != 0 )
+		return false;
+
+	return true;
+}
+
+// Reads the PLTE chunk
+static bool ReadPalette( LightPng_State &state, LightPng_Image *img, int chunk_len )
+{
+	if ( chunk_len <= 0 || (chunk_len % 3) != 0 )
+		return false;
+	if ( (chunk_len / 3) > img->palette_size )
+		return false;
+	if ( img->palette == 0 )
+		return false;
+
+	int idx = 0;
+	while ( chunk_len > 0 )
+	{
+		int col = 0xff000000 | (state.Read() << 16);
+		col |= state.Read() << 8;
+		col |= state.Read();
+
+		img->palette[ idx++ ] = col;
+		chunk_len -= 3;
+	}
+
+	return !state.has_errors;
+}
+
+// Reads the tRNS chunk
+static bool ReadTransparency( LightPng_State &state, LightPng_Image *img, int color, int chunk_len )
+{
+	if ( color != 3 )
+	{ // Supported only for palettized images
+		state.Skip( chunk_len );
+		return true;
+	}
+	if ( chunk_len > 256 || chunk_len > img->palette_size )
+		return false;
+	if ( img->palette == 0 )
+		return false;
+
+	for ( int i = 0; i < chunk_len; ++i )
+	{
+		LZuchar a = state.Read();
+		img->palette[ i ] = (img->palette[ i ] & 0x00ffffff) | (a << 24);
+	}
+
+	return !state.has_errors;
+}
+
+PNGNAME(Image)::PNGNAME(Image)()
+	: width( 0 )
+	, height( 0 )
+	, has_palette( false )
+	, palette( 0 )
+	, palette_size( 0 )
+	, data( 0 )
+	, format( PNGNAME(Format_ARGB) )
+{
+}
+
+PNGNAME(Image)::~PNGNAME(Image)()
+{
+	if ( palette != 0 )
+		delete [] palette;
+	if ( data != 0 )
+		delete [] data;
+}
+
+///////////////////////////////////
+// Streaming decoder
+
+enum LightPng_StreamMode
+{
+	PngStream_Signature,
+	PngStream_ChunkHeader,
+	PngStream_ChunkData,
+	PngStream_ChunkCrc,
+	PngStream_Done
+};
+
+// Largest chunk that is collected before processing (PLTE)
+#define STREAM_CHUNK_BUFFER (256 * 3)
+
+struct PNGNAME(Stream)
+{
+	// The image info; the data stays null
+	LightPng_Image info;
+	bool has_info;
+	int color;
+	int bitspp;
+
+	LightPng_RowFunc row_func;
+	void *user;
+	bool keep_image;		// Collect the image to info.data instead (for Create)
+
+	LightZ_Env *z_env;
+	bool trusted;
+	LightZ_Stream *z_stream;
+
+	// Chunk parsing
+	LightPng_StreamMode mode;
+	LZuchar buffer[ STREAM_CHUNK_BUFFER ];
+	int buffer_len;
+	int chunk_type;
+	int chunk_left;
+	LZuint crc;
+	bool idat_found;
+	bool idat_ended;
+
+	// The scanlines: the one being filled, the previous one and the converted output
+	LZuchar *row_memory;
+	LZuchar *row;
+	LZuchar *prior;
+	LZuchar *out;
+	int line_pitch;
+	int row_fill;
+	int y;
+
+	bool has_errors;
+
+	PNGNAME(Stream)()
+		: has_info( false )
+		, color( 0 )
+		, bitspp( 0 )
+		, row_func( 0 )
+		, user( 0 )
+		, keep_image( false )
+		, z_env( 0 )
+		, trusted( false )
+		, z_stream( 0 )
+		, mode( PngStream_Signature )
+		, buffer_len( 0 )
+		, chunk_type( 0 )
+		, chunk_left( 0 )
+		, crc( CRC_START )
+		, idat_found( false )
+		, idat_ended( false )
+		, row_memory( 0 )
+		, row( 0 )
+		, prior( 0 )
+		, out( 0 )
+		, line_pitch( 0 )
+		, row_fill( 0 )
+		, y( 0 )
+		, has_errors( false )
+	{
+	}
+
+	~PNGNAME(Stream)()
+	{
+		ZFN(DeleteStream)( z_stream );
+		delete [] row_memory;
+	}
+};
+
+// Unfilters, converts and passes on a completed scanline
+static void StreamEmitRow( LightPng_Stream &stream )
+{
+	if ( !UnfilterRow( stream.row, (stream.y > 0) ? stream.prior : 0, stream.line_pitch, stream.bitspp ) )
+	{
+		stream.has_errors = true;
+		return;
+	}
+
+	int width = stream.info.width;
+	LZuchar *out = stream.out;
+	if ( stream.keep_image )
+		out = &stream.info.data[ stream.y * ((stream.color == 3) ? width : width * 4) ];
+
+	if ( stream.color == 2 )
+		ConvertRowRGB( out, stream.row + 1, width, stream.info.format );
+	else if ( stream.color == 6 )
+		ConvertRowRGBA( out, stream.row + 1, width, stream.info.format );
+	else if ( stream.bitspp < 8 )
+		ExpandRowIndices( out, stream.row + 1, width, stream.bitspp );
+	else if ( stream.keep_image )
+		memcpy( out, stream.row + 1, width );
+	else
+		out = stream.row + 1;
+
+	if ( stream.row_func != 0 )
+		stream.row_func( stream.user, &stream.info, stream.y, out );
+
+	LZuchar *tmp = stream.prior;
+	stream.prior = stream.row;
+	stream.row = tmp;
+	stream.row_fill = 0;
+	++stream.y;
+}
+
+// Receives the inflated image data (LightZ output function)
+static void StreamInflated( void *user, const unsigned char *data, int len )
+{
+	LightPng_Stream &stream = *(LightPng_Stream *) user;
+
+	while ( len > 0 && !stream.has_errors )
+	{
+		if ( stream.y >= stream.info.height )
+		{ // Too much data
+			stream.has_errors = true;
+			return;
+		}
+
+		int amt = stream.line_pitch - stream.row_fill;
+		if ( amt > len )
+			amt = len;
+		memcpy( &stream.row[ stream.row_fill ], data, amt );
+		stream.row_fill += amt;
+		data += amt;
+		len -= amt;
+
+		if ( stream.row_fill == stream.line_pitch )
+			StreamEmitRow( stream );
+	}
+}
+
+// Sets up the inflater and the scanline buffers once the header has been read
+static bool StreamStart( LightPng_Stream &stream )
+{
+	int width = stream.info.width;
+	stream.line_pitch = (int)( 1 + (stream.bitspp * width + 7) / 8 );
+	int out_pitch = (stream.color == 3) ? width : width * 4;
+
+	stream.row_memory = new LZuchar[ stream.line_pitch * 2 + out_pitch ];
+	if ( stream.row_memory == 0 )
+		return false;
+	stream.row = stream.row_memory;
+	stream.prior = stream.row + stream.line_pitch;
+	stream.out = stream.prior + stream.line_pitch;
+
+	if ( stream.keep_image )
+	{
+		stream.info.data = new LZuchar[ out_pitch * stream.info.height ];
+		if ( stream.info.data == 0 )
+			return false;
+	}
+
+	stream.z_stream = ZFN(NewStream)( StreamInflated, &stream, stream.z_env, stream.trusted );
+	return stream.z_stream != 0;
+}
+
+// Inflates the last of the image data
+static bool StreamFinishData( LightPng_Stream &stream )
+{
+	stream.idat_ended = true;
+	if ( stream.z_stream == 0 || ZFN(StreamInflate)( stream.z_stream, 0, 0, true ) != 0 )
+		return false;
+	return !stream.has_errors && stream.y == stream.info.height;
+}
+
+// Handles a chunk header (in the buffer)
+static bool StreamChunkHeader( LightPng_Stream &stream )
+{
+	const LZuchar *b = stream.buffer;
+	int chunk_len = (int)( ((LZuint) b[ 0 ] << 24) | (b[ 1 ] << 16) | (b[ 2 ] << 8) | b[ 3 ] );
+	stream.chunk_type = (int)( ((LZuint) b[ 4 ] << 24) | (b[ 5 ] << 16) | (b[ 6 ] << 8) | b[ 7 ] );
+	stream.chunk_left = chunk_len;
+	stream.crc = UpdateCrc( CRC_START, &b[ 4 ], 4 );
+
+	if ( chunk_len < 0 )
+		return false;
+	if ( !stream.has_info && stream.chunk_type != Chunk_IHDR )
+		return false;
+
+	// The image data ends at the first other chunk after it
+	if ( stream.chunk_type == Chunk_IDAT )
+	{
+		if ( stream.idat_ended || !stream.has_info )
+			return false;
+		stream.idat_found = true;
+	}
+	else if ( stream.idat_found && !stream.idat_ended )
+	{
+		if ( !StreamFinishData( stream ) )
+			return false;
+	}
+
+	// The chunks that are processed are collected first
+	switch ( stream.chunk_type )
+	{
+	case Chunk_IHDR:
+	case Chunk_PLTE:
+	case Chunk_tRNS:
+		if ( chunk_len > STREAM_CHUNK_BUFFER )
+			return false;
+		break;
+	}
+
+	return true;
+}
+
+// Handles a collected chunk (in the buffer)
+static bool StreamChunk( LightPng_Stream &stream )
+{
+	LightPng_State state;
+	state.src = stream.buffer;
+	state.src_left = stream.buffer_len;
+
+	switch ( stream.chunk_type )
+	{
+	case Chunk_IHDR: // Header
+		if ( stream.has_info )
+			return false;
+		if ( !ReadHeader( state, &stream.info, stream.color, stream.bitspp ) )
+			return false;
+		stream.has_info = true;
+		return StreamStart( stream );
+
+	case Chunk_PLTE: // Palette
+		return ReadPalette( state, &stream.info, stream.buffer_len );
+
+	case Chunk_tRNS: // Transparency
+		return ReadTransparency( state, &stream.info, stream.color, stream.buffer_len );
+	}
+
+	return true;
+}
+
+// Creates an incremental decoder
+PNGNAME(Stream) *PNGNAME(NewStream)( LightPng_RowFunc row_func, void *user, LightPng_Format format, LightZ_Env *z_env, bool trusted )
+{
+	if ( row_func == 0 )
+		return 0;
+
+	LightPng_Stream *stream = new LightPng_Stream();
+	if ( stream == 0 )
+		return 0;
+
+	stream->info.format = format;
+	stream->row_func = row_func;
+	stream->user = user;
+	stream->z_env = z_env;
+	stream->trusted = trusted;
+	return stream;
+}
+
+// Deallocates a decoder
+void PNGNAME(DeleteStream)( PNGNAME(Stream) *stream )
+{
+	if ( stream != 0 ) delete stream;
+}
+
+// Decodes the next piece of the file
+bool PNGNAME(StreamFeed)( PNGNAME(Stream) *stream, const void *data, int data_size )
+{
+	if ( stream == 0 || data_size < 0 || (data == 0 && data_size > 0) )
+		return false;
+
+	const LZuchar *src = (const LZuchar *) data;
+	int left = data_size;
+
+	while ( left > 0 && !stream->has_errors && stream->mode != PngStream_Done )
+	{
+		// The signature, chunk headers and CRCs are collected to the buffer
+		int need = 0;
+		switch ( stream->mode )
+		{
+		case PngStream_Signature:	need = 8; break;
+		case PngStream_ChunkHeader:	need = 8; break;
+		case PngStream_ChunkCrc:	need = 4; break;
+		default: break;
+		}
+
+		if ( need > 0 )
+		{
+			int amt = need - stream->buffer_len;
+			if ( amt > left )
+				amt = left;
+			memcpy( &stream->buffer[ stream->buffer_len ], src, amt );
+			stream->buffer_len += amt;
+			src += amt;
+			left -= amt;
+			if ( stream->buffer_len < need )
+				break;
+			stream->buffer_len = 0;
+		}
+
+		switch ( stream->mode )
+		{
+		case PngStream_Signature:
+			{
+				static const LZuchar signature[ 8 ] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+				if ( memcmp( stream->buffer, signature, 8 ) != 0 )
+					stream->has_errors = true;
+				stream->mode = PngStream_ChunkHeader;
+			}
+			break;
+
+		case PngStream_ChunkHeader:
+			if ( !StreamChunkHeader( *stream ) )
+				stream->has_errors = true;
+			stream->mode = PngStream_ChunkData;
+			break;
+
+		case PngStream_ChunkData:
+			{
+				int amt = stream->chunk_left;
+				if ( amt > left )
+					amt = left;
+
+				if ( !stream->trusted )
+					stream->crc = UpdateCrc( stream->crc, src, amt );
+
+				switch ( stream->chunk_type )
+				{
+				case Chunk_IDAT: // Image data is inflated right away
+					if ( ZFN(StreamInflate)( stream->z_stream, src, amt ) != 0 )
+						stream->has_errors = true;
+					break;
+
+				case Chunk_IHDR:
+				case Chunk_PLTE:
+				case Chunk_tRNS:
+					memcpy( &stream->buffer[ stream->buffer_len ], src, amt );
+					stream->buffer_len += amt;
+					break;
+				}
+
+				src += amt;
+				left -= amt;
+				stream->chunk_left -= amt;
+			}
+			break;
+
+		case PngStream_ChunkCrc:
+			{
+				const LZuchar *b = stream->buffer;
+				LZuint test_crc = ((LZuint) b[ 0 ] << 24) | (b[ 1 ] << 16) | (b[ 2 ] << 8) | b[ 3 ];
+				if ( !stream->trusted && (stream->crc ^ 0xffffffff) != test_crc )
+					stream->has_errors = true;
+				else if ( stream->chunk_type == Chunk_IEND )
+				{
+					if ( !stream->idat_ended )
+						stream->has_errors = true;
+					stream->mode = PngStream_Done;
+					break;
+				}
+				stream->mode = PngStream_ChunkHeader;
+			}
+			break;
+
+		default:
+			break;
+		}
+
+		// Chunk data done? (also for empty chunks, right after the header)
+		if ( stream->mode == PngStream_ChunkData && stream->chunk_left == 0 && !stream->has_errors )
+		{
+			if ( !StreamChunk( *stream ) )
+				stream->has_errors = true;
+			stream->buffer_len = 0;
+			stream->mode = PngStream_ChunkCrc;
+		}
+	}
+
+	return !stream->has_errors;
+}
+
+// Returns the image info once the header has been read
+const PNGNAME(Image) *PNGNAME(StreamInfo)( const PNGNAME(Stream) *stream )
+{
+	if ( stream == 0 || !stream->has_info )
+		return 0;
+	return &stream->info;
+}
+
+// Returns true once the whole image has been decoded
+bool PNGNAME(StreamDone)( const PNGNAME(Stream) *stream )
+{
+	return stream != 0 && !stream->has_errors && stream->mode == PngStream_Done;
+}
+
+///////////////////////////////////
+
+// Create a .png image from the given data.
+// The data is decoded with the stream in one piece, so the IDAT chunks are inflated straight
+// from the source data (and the rows converted straight into the image) without copying.
+PNGNAME(Image) *PNGNAME(Create)( const void *data, int data_size, LightPng_Format format, LightZ_Env *z_env, bool trusted )
+{
+	if ( data == 0 || data_size <= 0 )
+		return 0;
+
+	LightPng_Stream stream;
+	stream.info.format = format;
+	stream.keep_image = true;
+	stream.z_env = z_env;
+	stream.trusted = trusted;
+
+	if ( !PNGNAME(StreamFeed)( &stream, data, data_size ) || !PNGNAME(StreamDone)( &stream ) )
+		return 0;
+
+	// Take over the image from the stream
+	LightPng_Image_Guardian img;
+	img->width = stream.info.width;
+	img->height = stream.info.height;
+	img->has_palette = stream.info.has_palette;
+	img->palette = stream.info.palette;
+	img->palette_size = stream.info.palette_size;
+	img->data = stream.info.data;
+	img->format = stream.info.format;
+
+	stream.info.palette = 0;
+	stream.info.data = 0;
+
+	// Release the image and return it
+	LightPng_Image *ret = img.img;
+	img.img = 0;
+	return ret;
+}
@@ -1,76 +1,111 @@
-/** Part of the LightZPng library package, v1.02
- ** 2005-2006 Jere Sanisalo & Housemarque Inc
- **
- ** License for this file (MIT):
- **
- ** Copyright (c) 2005 Jere Sanisalo & Housemarque Inc
- **
- ** Permission is hereby granted, free of charge, to any person obtaining a
- ** copy of this software and associated documentation files (the "Software"),
- ** to deal in the Software without restriction, including without limitation
- ** the rights to use, copy, modify, merge, publish, distribute, sublicense,
- ** and/or sell copies of the Software, and to permit persons to whom the
- ** Software is furnished to do so, subject to the following conditions:
- **
- ** The above copyright notice and this permission notice shall be included in
- ** all copies or substantial portions of the Software.
- **
- ** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- ** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- ** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- ** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- ** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
- ** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
- ** DEALINGS IN THE SOFTWARE.
- **/
-// Very small & light .png loader
-#ifndef __LightZPng__LightPng_h
-#define __LightZPng__LightPng_h
-
-// Configure the function/struct name here
-#define PNGNAME(x) LPNG_##x
-
-///////////////////////////////
-
-// Disable annoying warning message 4127 "conditional expression is constant"
-#ifdef _MSC_VER
-#pragma warning( disable : 4127 )
-#endif
-
-
-// One .png image
-struct PNGNAME(Image)
-{
-	typedef unsigned int Color;
-
-	int width;
-	int height;
-	bool has_palette;
-
-	// ARGB colors; either null or "paletteEntries" entries
-	Color *palette;
-    // Number of entries in the palette
-    int palette_size;
-
-	// The color data; either 8 bit palette indices or ARGB 32bit colors
-	unsigned char *data;
-
-	PNGNAME(Image)();
-	~PNGNAME(Image)();
-};
-
-// The unpacker (LightZ) env
-struct LightZ_Env;
-
-// Create a .png image from the given data.
-// Returns null on error.
-PNGNAME(Image) *PNGNAME(Create)( const void *data, int data_size, LightZ_Env *z_env = 0 );
-
-
-///////////////////////////////
-// Clean up the header/define mess
-#ifndef LIGHTPNG_INTERNAL
-# undef ZFN
-#endif
-
-#endif
+/** Part of the LightZPng library package, v1.02
+ ** 2005-2006 Jere Sanisalo & Housemarque Inc
+ **
+ ** License for this file (MIT):
+ **
+ ** Copyright (c) 2005 Jere Sanisalo & Housemarque Inc
+ **
+ ** Permission is hereby granted, free of charge, to any person obtaining a
+ ** copy of this software and associated documentation files (the "Software"),
+ ** to deal in the Software without restriction, including without limitation
+ ** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ ** and/or sell copies of the Software, and to permit persons to whom the
+ ** Software is furnished to do so, subject to the following conditions:
+ **
+ ** The above copyright notice and this permission notice shall be included in
+ ** all copies or substantial portions of the Software.
+ **
+ ** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ ** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ ** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ ** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ ** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ ** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ ** DEALINGS IN THE SOFTWARE.
+ **/
+// Very small & light .png loader
+#ifndef __LightZPng__LightPng_h
+#define __LightZPng__LightPng_h
+
+// Configure the function/struct name here
+#define PNGNAME(x) LPNG_##x
+
+///////////////////////////////
+
+// Disable annoying warning message 4127 "conditional expression is constant"
+#ifdef _MSC_VER
+#pragma warning( disable : 4127 )
+#endif
+
+
+// Layouts for the 32 bit color data
+enum PNGNAME(Format)
+{
+	PNGNAME(Format_ARGB),		// Bytes in A, R, G, B order
+	PNGNAME(Format_XRGB32)	// Native 32 bit words 0xAARRGGBB (the MAKE_RGB32 layout, with alpha in the top byte)
+};
+
+// One .png image
+struct PNGNAME(Image)
+{
+	typedef unsigned int Color;
+
+	int width;
+	int height;
+	bool has_palette;
+
+	// ARGB colors; either null or "paletteEntries" entries
+	Color *palette;
+    // Number of entries in the palette
+    int palette_size;
+
+	// The color data; either 8 bit palette indices or 32bit colors in "format"
+	unsigned char *data;
+	PNGNAME(Format) format;
+
+	PNGNAME(Image)();
+	~PNGNAME(Image)();
+};
+
+// The unpacker (LightZ) env
+struct LightZ_Env;
+
+// Create a .png image from the given data, with 32 bit colors in the given format.
+// If trusted is set, the chunk CRCs and the image data Adler32 are not verified; use it
+// only for data that has been validated before (e.g. pack files checked at build time).
+// Returns null on error.
+PNGNAME(Image) *PNGNAME(Create)( const void *data, int data_size, PNGNAME(Format) format = PNGNAME(Format_ARGB), LightZ_Env *z_env = 0, bool trusted = false );
+
+
+// Receives the rows of a streamed image, top to bottom. The row is laid out like a row of the
+// image data from Create (8 bit palette indices or 32bit colors in info->format) and is only
+// valid during the call.
+typedef void (*PNGNAME(RowFunc))( void *user, const PNGNAME(Image) *info, int y, const unsigned char *row );
+
+// Incremental .png decoder
+struct PNGNAME(Stream);
+
+// Creates an incremental decoder. The file is given in pieces of any size with StreamFeed and
+// every row is passed to row_func as soon as it has been inflated, so only a few rows and the
+// 32KB inflate window are kept in memory. z_env, if given, must stay valid for the stream's
+// lifetime. Returns null on error.
+PNGNAME(Stream) *PNGNAME(NewStream)( PNGNAME(RowFunc) row_func, void *user, PNGNAME(Format) format = PNGNAME(Format_ARGB), LightZ_Env *z_env = 0, bool trusted = false );
+
+// Deallocates an incremental decoder
+void PNGNAME(DeleteStream)( PNGNAME(Stream) *stream );
+
+// Decodes the next piece of the file. Returns false on error; the stream can't be used after that.
+bool PNGNAME(StreamFeed)( PNGNAME(Stream) *stream, const void *data, int data_size );
+
+// Returns the image info (size and palette; data is null) once the header has been read, or null
+const PNGNAME(Image) *PNGNAME(StreamInfo)( const PNGNAME(Stream) *stream );
+
+// Returns true once the whole image has been decoded
+bool PNGNAME(StreamDone)( const PNGNAME(Stream) *stream );
+///////////////////////////////
+// Clean up the header/define mess
+#ifndef LIGHTPNG_INTERNAL
+# undef ZFN
+#endif
+
+#endif
@@ -1,1088 +1,2004 @@
-/** Part of the LightZPng library package, v1.02
- ** 2005-2006 Jere Sanisalo & Housemarque Inc
- **
- ** License for this file (MIT):
- **
- ** Copyright (c) 2005 Jere Sanisalo & Housemarque Inc
- **
- ** Permission is hereby granted, free of charge, to any person obtaining a
- ** copy of this software and associated documentation files (the "Software"),
- ** to deal in the Software without restriction, including without limitation
- ** the rights to use, copy, modify, merge, publish, distribute, sublicense,
- ** and/or sell copies of the Software, and to permit persons to whom the
- ** Software is furnished to do so, subject to the following conditions:
- **
- ** The above copyright notice and this permission notice shall be included in
- ** all copies or substantial portions of the Software.
- **
- ** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- ** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- ** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- ** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- ** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
- ** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
- ** DEALINGS IN THE SOFTWARE.
- **/
-#define LIGHTZ_INTERNAL
-#include "LightZ.h"
-//#include <stdio.h>
-
-
-#define LZ_META_ASSERT(x) typedef char LZ_META_ASSERT_##__LINE__[ (x) ? 1 : -1 ];
-
-typedef unsigned char LZuchar;
-typedef unsigned short LZushort;
-typedef unsigned int LZuint;
-
-LZ_META_ASSERT( sizeof( LZuchar ) == 1 );
-LZ_META_ASSERT( sizeof( LZushort ) == 2 );
-LZ_META_ASSERT( sizeof( LZuint ) == 4 );
-
-#define ADLER32_BASE 65521
-#define ADLER32_START 1
-#define MAX_BITS 15
-
-#define HUFFSIZE_LEN 2048
-#define HUFFSIZE_DIST 1024
-#define HUFFSIZE_CODES 512
-
-#define MAX_HUFFMAN_VALUES 300
-
-#define for if (false) {} else for
-
-// The error message to return
-#define LZ_ERRORMSG(x) x
-//#define LZ_ERRORMSG(x) "LightZ error!"
-
-// Length base values (codes 257-287)
-static const int g_len_base[] =
-{
-    3, 4, 5, 6, 7, 8, 9, 10, 11, 13,
-	15, 17, 19, 23, 27, 31, 35, 43, 51, 59,
-	67, 83, 99, 115, 131, 163, 195, 227, 258,
-	0, 0
-};
-// Extra bits for lengths (codes 257-287)
-static const int g_len_extra[] =
-{
-	0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
-	1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
-	4, 4, 4, 4, 5, 5, 5, 5, 0,
-	0, 0
-};
-// Distance base values (0-31)
-static const int g_dist_base[] =
-{
-	1, 2, 3, 4, 5, 7, 9, 13, 17, 25,
-	33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
-	1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
-	0, 0
-};
-// Extra bits for distance (0-31)
-static const int g_dist_extra[] =
-{
-	0, 0, 0, 0, 1, 1, 2, 2, 3, 3,
-	4, 4, 5, 5, 6, 6, 7, 7, 8, 8,
-	9, 9, 10, 10, 11, 11, 12, 12, 13,13,
-	0, 0
-};
-// Code length write order
-static const int g_codelen_order[] =
-{
-	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
-};
-
-// The adler32 update
-static inline LZuint UpdateAdler32( LZuint adler, LZuchar *buf, int len )
-{
-	LZuint s1 = adler & 0xffff;
-	LZuint s2 = (adler >> 16) & 0xffff;
-
-	for ( int n = 0; n < len; ++n )
-	{
-		s1 = (s1 + buf[ n ]) % ADLER32_BASE;
-		s2 = (s2 + s1)       % ADLER32_BASE;
-	}
-
-	return (s2 << 16) + s1;
-}
-
-static inline LZuint UpdateAdler32( LZuint adler, LZuchar chr )
-{
-	LZuint s1 = adler & 0xffff;
-	LZuint s2 = (adler >> 16) & 0xffff;
-
-	s1 = (s1 + chr) % ADLER32_BASE;
-	s2 = (s2 + s1)  % ADLER32_BASE;
-
-	return (s2 << 16) + s1;
-}
-
-// One Huffman tree node
-struct LightZ_HuffNode
-{
-	// The table index to jump to if the next bit is 1. If 0, then this is a literal node. If 0xffff, then this is an error node.
-	// If the next bit is 0, then the next table index is (this+1).
-	LZushort jump_if_1;
-
-	// If "jump_if_1" is 0, then this is the literal value for this node.
-	LZushort value;
-};
-
-// One Huffman value/code pair
-struct LightZ_HuffCode
-{
-	LZushort bits;
-	LZushort code;
-	LZushort value;
-};
-
-///////////////////////////////////
-///////////////////////////////////
-////////////   DEBUG   ////////////
-///////////////////////////////////
-///////////////////////////////////
-
-/*
-static void ShowBits( int num, int bits )
-{
-	for ( int i = 0; i < bits; ++i )
-	{
-		int shift = bits - i - 1;
-		int bit = (num >> shift) & 1;
-		printf( "%d", bit );
-	}
-}
-
-static void ShowBitLenList( const char *title, LZuchar *list, int size )
-{
-	printf( "%s\n", title );
-	for ( int i = 0; i < size; ++i )
-	{
-		printf( "%3d: %d\n", i, list[ i ] );
-	}
-}
-
-static void ShowHuffTree( LightZ_HuffNode *tree, const char *prefix, int node, int indent )
-{
-	LightZ_HuffNode *n = &tree[ node ];
-
-	for ( int i = 0; i < indent; ++i )
-		printf( " " );
-
-	printf( "%s[%d] ", prefix, node );
-	if ( n->jump_if_1 == 0 )
-		printf( "Value: %d\n", n->value );
-	else if ( n->jump_if_1 == 0xffff )
-		printf( "ERROR NODE\n" );
-	else
-	{
-		printf( "\n" );
-		ShowHuffTree( tree, "Zero-> ", node + 1, indent + 2 );
-		ShowHuffTree( tree, "One -> ", n->jump_if_1, indent + 2 );
-	}
-}
-*/
-
-///////////////////////////////////
-///////////////////////////////////
-///////////////////////////////////
-///////////////////////////////////
-///////////////////////////////////
-
-// Sorts a table of Huffman codes (increasing order by code&bits).
-static void SortHuffmanCodes( LightZ_HuffCode *codes, int amt )
-{
-	// TODO: Faster sort code!
-	for ( int i = 0; i < amt; ++i )
-	{
-		for ( int j = i + 1; j < amt; ++j )
-		{
-			if ( codes[ i ].code <= codes[ j ].code )
-				continue;
-
-			LightZ_HuffCode tmp = codes[ i ];
-			codes[ i ] = codes[ j ];
-			codes[ j ] = tmp;
-		}
-	}
-}
-
-// Builds the Huffman tree nodes from a tree-sorted Huffman code table
-static int BuildHuffmanNodes( int cur_bit, int code_idx, LightZ_HuffCode *codes, int code_amt, LightZ_HuffNode *dest_tree, int dest_tree_pos, int dest_tree_max_size )
-{
-	if ( dest_tree_pos >= dest_tree_max_size )
-		return -1;
-	if ( code_idx >= code_amt )
-		return -1;
-
-	if ( cur_bit == codes[ code_idx ].bits )
-	{ // Found an ending leaf node
-		dest_tree[ dest_tree_pos ].jump_if_1 = 0;
-		dest_tree[ dest_tree_pos ].value = codes[ code_idx ].value;
-		return dest_tree_pos + 1;
-	}
-
-	// Make a knot node (branch)
-	LightZ_HuffNode *knot = &dest_tree[ dest_tree_pos++ ];
-	knot->jump_if_1 = 0xffff; // (will be changed later, just a temp value)
-
-	if ( dest_tree_pos >= dest_tree_max_size )
-		return -1;
-
-	// Get the next bit (counting from left; MSB side)
-	int bit = (codes[ code_idx ].code >> (MAX_BITS-1-cur_bit)) & 1;
-
-	if ( bit == 0 )
-	{ // Add the bit 0 -subtree
-		dest_tree_pos = BuildHuffmanNodes( cur_bit + 1, code_idx, codes, code_amt, dest_tree, dest_tree_pos, dest_tree_max_size );
-		if ( dest_tree_pos < 0 )
-			return -1;
-	}
-	else
-	{ // Cannot continue with a zero bit
-		dest_tree[ dest_tree_pos++ ].jump_if_1 = 0xffff;
-		if ( dest_tree_pos >= dest_tree_max_size )
-			return -1;
-	}
-
-	knot->jump_if_1 = dest_tree_pos;
-
-	// Scroll to a position where this bit is one (start of the other subtree)
-	while ( code_idx < code_amt )
-	{
-		bit = (codes[ code_idx ].code >> (MAX_BITS-1-cur_bit)) & 1;
-		if ( bit == 1 )
-			break;
-		++code_idx;
-	}
-
-	// Bit 1 not found?
-	if ( code_idx >= code_amt )
-	{
-		dest_tree[ dest_tree_pos++ ].jump_if_1 = 0xffff;
-		return dest_tree_pos;
-	}
-
-	// Add the bit 1 subtree
-	dest_tree_pos = BuildHuffmanNodes( cur_bit + 1, code_idx, codes, code_amt, dest_tree, dest_tree_pos, dest_tree_max_size );
-	return dest_tree_pos;
-}
-
-// Builds a huffman tree.
-static bool BuildHuffmanTree( LZuchar *val_bits, int values, LightZ_HuffNode *dest_tree, int dest_tree_max_size, LightZ_HuffCode *temp_codes )
-{
-	// Count how many values there are for each bit length
-	int values_per_bitlen[ MAX_BITS + 1 ];
-
-	for ( int i = 0; i <= MAX_BITS; ++i )
-		values_per_bitlen[ i ] = 0;
-	for ( int i = 0; i < values; ++i )
-	{
-		int bits = val_bits[ i ];
-		if ( bits < 0 || bits > MAX_BITS )
-			return false;
-		values_per_bitlen[ bits ]++;
-	}
-	values_per_bitlen[ 0 ] = 0;
-
-	// Test for too few/too many bits allocated
-	if ( values > 1 )
-	{
-		int left = 1;
-		for ( int i = 1; i <= MAX_BITS; ++i )
-		{
-			left <<= 1;
-			left -= values_per_bitlen[ i ];
-			// Too many bits?
-			if ( left < 0 )
-				return false;
-		}
-		// Too few bits?
-		if ( left > 0 )
-			return false;
-	}
-	else
-	{ // Either 0 or 1 values
-		if ( values_per_bitlen[ 1 ] != values )
-			return false;
-	}
-
-	// Find a numerical smallest value for each of the bit lengths
-	int next_code[ MAX_BITS + 1 ];
-	int code = 0;
-	for ( int bits = 1; bits <= MAX_BITS; ++bits )
-	{
-		code = ( code + values_per_bitlen[ bits - 1 ] ) << 1;
-		next_code[ bits ] = code;
-	}
-
-	// Generate the code values
-	if ( values > MAX_HUFFMAN_VALUES )
-		return false;
-	LightZ_HuffCode *codes = temp_codes;
-	int code_amt = 0;
-
-//	printf( "Huffman codes:\n" );
-	for ( int i = 0; i < values; ++i )
-	{
-		int bits = val_bits[ i ];
-		if ( bits == 0 )
-			continue;
-
-		codes[ code_amt ].bits = bits;
-		codes[ code_amt ].code = next_code[ bits ] << (MAX_BITS - bits); // Make it so that the first bit is always at the left side
-		codes[ code_amt ].value = (LZushort) i;
-
-//		printf( "Val: %d\tBits: %d\tCode: ", i, bits );
-//		ShowBits( next_code[ bits ], bits );
-//		printf( "\n" );
-
-		++code_amt;
-		next_code[ bits ]++;
-	}
-
-	// Sort the codes to increasing order
-	SortHuffmanCodes( codes, code_amt );
-
-	// Init the tree construction
-	dest_tree[ 0 ].jump_if_1 = 0xffff;
-
-	bool ok = true;
-	if ( code_amt > 0 )
-	{
-		if ( BuildHuffmanNodes( 0, 0, codes, code_amt, dest_tree, 0, dest_tree_max_size ) < 0 )
-			ok = false;
-	}
-
-//	if ( ok ) ShowHuffTree( dest_tree, "", 0, 0 );
-
-	return ok;
-}
-
-// The memory allocated environment
-struct LightZ_Env
-{
-	// Allocations for prebuilt length/distance trees
-	LightZ_HuffNode pre_len[ HUFFSIZE_LEN ];
-	LightZ_HuffNode pre_dist[ HUFFSIZE_DIST ];
-
-	// Allocations for dynamic length/distance trees
-	LightZ_HuffNode dyn_len[ HUFFSIZE_LEN ];
-	LightZ_HuffNode dyn_dist[ HUFFSIZE_DIST ];
-
-	// Allocations for dynamic code length trees
-	LightZ_HuffNode codelen[ HUFFSIZE_CODES ];
-
-	// Allocation for bit list big enough for lengths & distances
-	LZuchar temp_bits_list[ 512 ];
-
-	// Temporary for huffman code values (used during tree construction)
-	LightZ_HuffCode huffman_values[ MAX_HUFFMAN_VALUES ];
-
-
-	LightZ_Env()
-	{
-		// Build the predefined length list
-		for ( int i = 0; i <= 143; ++i )
-			temp_bits_list[ i ] = 8;
-		for ( int i = 144; i <= 255; ++i )
-			temp_bits_list[ i ] = 9;
-		for ( int i = 256; i <= 279; ++i )
-			temp_bits_list[ i ] = 7;
-		for ( int i = 280; i <= 287; ++i )
-			temp_bits_list[ i ] = 8;
-
-		BuildHuffmanTree( temp_bits_list, 288, pre_len, HUFFSIZE_LEN, huffman_values );
-
-		// Build the predefined distance list
-		for ( int i = 0; i <= 31; ++i )
-			temp_bits_list[ i ] = 5;
-
-		BuildHuffmanTree( temp_bits_list, 32, pre_dist, HUFFSIZE_DIST, huffman_values );
-	}
-
-	~LightZ_Env()
-	{
-	}
-};
-
-// Scope guard for the environment
-class LightZ_Env_Guard
-{
-public:
-	LightZ_Env *ptr;
-
-	LightZ_Env_Guard() : ptr( 0 ) { }
-	~LightZ_Env_Guard() { if ( ptr != 0 ) delete ptr; }
-};
-
-// The unpacking state
-struct LightZ_State
-{
-	// The memory environment
-	LightZ_Env *env;
-
-	// The source data
-	const LZuchar *src;
-	int src_left;
-
-	bool src_reallocated; // Flag to see if src has been reallocated (only in the case of overlapping areas)
-	LZuchar *release_src; // In case src has been reallocated, this is the pointer that should be released
-
-	// The destination data
-	LZuint dest_adler32;
-	LZuchar **dest;
-	int *dest_pos;
-	int dest_size;
-
-	bool src_and_dest_overlap; // If source and destination areas 
-
-	// Currently being read byte (for bit reading)
-	int read_byte;
-	int read_byte_left;
-
-	// The sliding window to backwards (written) data
-	int window_size;
-
-	// Current error message (null == all ok)
-	const char *err_msg;
-
-
-
-	LightZ_State()
-		: src( 0 )
-		, src_left( 0 )
-		, src_reallocated( 0 )
-		, release_src( 0 )
-		, dest_adler32( ADLER32_START )
-		, dest( 0 )
-		, dest_pos( 0 )
-		, dest_size( 0 )
-		, src_and_dest_overlap( false )
-		, read_byte( 0 )
-		, read_byte_left( 0 )
-		, window_size( 0 )
-		, err_msg( 0 )
-	{ }
-
-	~LightZ_State()
-	{
-		if ( release_src != 0 )
-			delete [] release_src;
-		release_src = 0;
-	}
-
-	// Reads one character of input.
-	LZuchar Read()
-	{
-		if ( src == 0 || src_left <= 0 )
-		{
-			if ( err_msg == 0 )
-				err_msg = LZ_ERRORMSG("Out of source data (EOS)!");
-			return 0;
-		}
-
-		--src_left;
-		return *src++;
-	}
-
-	// Reads x bits of data
-	int ReadBits( int bits )
-	{
-		int ret = 0;
-
-		int shift = 0;
-		while ( bits > 0 )
-		{
-			if ( read_byte_left == 0 )
-			{
-				read_byte = Read();
-				read_byte_left = 8;
-			}
-
-			// Grab the bits
-			int amt = (bits < read_byte_left) ? bits : read_byte_left;
-			int new_bits = read_byte & ( (1<<amt) - 1 );
-			ret |= new_bits << shift;
-
-			// Advance
-			bits -= amt;
-			shift += amt;
-			read_byte >>= amt;
-			read_byte_left -= amt;
-		}
-
-		return ret;
-	}
-
-	// Reads a Huffman packed value, given the Huffman decoding tree (-1 on error)
-	int ReadHuffman( LightZ_HuffNode *tree )
-	{
-		if ( tree == 0 )
-			return -1;
-
-		int idx = 0;
-		while ( err_msg == 0 )
-		{
-			int jump_if_1 = tree[ idx ].jump_if_1;
-
-			if ( jump_if_1 == 0 )
-				return tree[ idx ].value;
-			if ( jump_if_1 == 0xffff )
-				return -1;
-
-			int bit = ReadBits( 1 );
-
-			if ( bit == 0 )
-				++idx;
-			else
-				idx = jump_if_1;
-		}
-
-		return -1;
-	}
-
-	// Writes one character of data
-	void Write( LZuchar chr )
-	{
-		if ( !EnsureFreeSize( 1 ) )
-			return;
-
-		// Check for dest and source overlaps
-		if ( src_and_dest_overlap )
-			CheckForDestOverlap( 1 );
-
-		// Write the data
-		dest_adler32 = UpdateAdler32( dest_adler32, chr );
-		(*dest)[ (*dest_pos)++ ] = chr;
-	}
-
-	// Writes data from back window
-	void WriteBack( int dist, int len )
-	{
-		int start_pos = *dest_pos - dist;
-
-		if ( dist <= 0 || len <= 0 )
-			return;
-		if ( start_pos < 0 )
-		{
-			if ( err_msg == 0 )
-				err_msg = LZ_ERRORMSG("Unable to refer outside the unpacked data boundary!");
-			return;
-		}
-
-		if ( !EnsureFreeSize( len ) )
-			return;
-
-		// Check for dest and source overlaps
-		if ( src_and_dest_overlap )
-			CheckForDestOverlap( len );
-
-		// Copy the data
-		int left = len;
-		LZuchar *s = &((*dest)[ start_pos ]);
-		LZuchar *d = &((*dest)[ *dest_pos ]);
-
-		while ( left-- > 0 )
-			*d++ = *s++;
-		*dest_pos += len;
-
-		// Update the checksum
-		dest_adler32 = UpdateAdler32( dest_adler32, &((*dest)[ start_pos ]), len );
-	}
-
-private:
-	// Preallocate a small buffer for overlapping src copying
-	enum { STATIC_SRC_BUFFER_SIZE = 16 };
-	LZuchar m_src_prealloc_buffer[ STATIC_SRC_BUFFER_SIZE ];
-
-
-	// Ensures free destination size for at least x more bytes
-	// Returns false in case of an error.
-	bool EnsureFreeSize( int free )
-	{
-		if ( free <= 0 )
-			return true;
-
-		int cur_free = dest_size - *dest_pos;
-		if ( cur_free >= free )
-			return true;
-
-		// If source and destination buffers overlap, then dest cannot be freed/reallocated.
-		if ( src_and_dest_overlap )
-		{
-			const char *tmp = LZ_ERRORMSG("Unable to resize the destination buffer when it overlaps with the source data memory.");
-			err_msg = tmp;
-			return false;
-		}
-
-		// Get the amount to allocate
-		int alloc_more = 16 + (free - cur_free) + src_left + (src_left >> 3);
-		int new_size = dest_size + alloc_more;
-
-		// Allocate the new buffer
-		LZuchar *dold = *dest;
-		LZuchar *dnew = new LZuchar[ new_size ];
-
-		if ( dnew == 0 )
-		{
-			err_msg = LZ_ERRORMSG("Out of memory error!");
-			return false;
-		}
-
-		// Copy old data
-		if ( dold != 0 )
-		{
-			LZuchar *s = dold;
-			LZuchar *d = dnew;
-			int left = *dest_pos;
-			while ( left-- > 0 )
-				*d++ = *s++;
-		}
-
-		// Switch to new buffer
-		*dest = dnew;
-		dest_size = new_size;
-
-		if ( dold != 0 )
-			delete [] dold;
-
-		return true;
-	}
-
-	// Called when we know that the source and destination areas overlap. This function checks if
-	// the overlap actually occurs now.
-	void CheckForDestOverlap( int add_amt )
-	{
-		if ( src_reallocated || src_left <= 0 || add_amt <= 0 )
-			return;
-
-		// Would this write make dest catch up to source?
-		LZuchar *d_after = *dest + (*dest_pos + add_amt);
-		if ( d_after < src )
-			return;
-
-		// Allocate a new source buffer for the rest of the data
-		bool use_prealloc = ( src_left <= STATIC_SRC_BUFFER_SIZE );
-		LZuchar *new_src = (use_prealloc ? m_src_prealloc_buffer : new LZuchar[ src_left ]);
-
-		if ( new_src == 0 )
-		{
-			if ( err_msg == 0 )
-			{
-				const char *tmp = LZ_ERRORMSG( "Error allocating a new source buffer (destination and source buffers overlap)." );
-				err_msg = tmp;
-			}
-			return;
-		}
-
-		// Copy the remaining data
-		int left = src_left;
-		const LZuchar *s = src;
-		LZuchar *d = new_src;
-
-		while ( left-- > 0 )
-			*d++ = *s++;
-
-		// Switch to new source
-		src = new_src;
-		src_reallocated = true;
-		if ( !use_prealloc )
-			release_src = new_src;
-	}
-};
-
-// Unpacks the bit lengths by using the code length Huffman tree
-static bool UnpackCodeLens( LightZ_State &state, int read_amt, LZuchar *dest, int dest_size )
-{
-	LightZ_HuffNode *huff_codelen = state.env->codelen;
-
-	for ( int i = 0; i < dest_size; ++i )
-		dest[ i ] = 0;
-
-	int prev_code = -1;
-	while ( read_amt > 0 )
-	{
-		int code = state.ReadHuffman( huff_codelen );
-		if ( code < 0 )
-		{
-			if ( state.err_msg == 0 )
-				state.err_msg = LZ_ERRORMSG("Invalid Huffman code in code lengths!");
-			return false;
-		}
-
-		int amt = 1;
-		switch ( code )
-		{
-		case 16:	amt = 3 + state.ReadBits( 2 ); code = prev_code; break;
-		case 17:	amt = 3 + state.ReadBits( 3 ); code = 0; break;
-		case 18:	amt = 11 + state.ReadBits( 7 ); code = 0; break;
-		}
-
-		if ( code < 0 || code > 15 )
-		{
-			if ( state.err_msg == 0 )
-				state.err_msg = LZ_ERRORMSG("Invalid code to repeat (in dynamic Huffman construction)!");
-			return false;
-		}
-		if ( amt > read_amt )
-		{
-			if ( state.err_msg == 0 )
-				state.err_msg = LZ_ERRORMSG("Too many codes (in dynamic Huffman construction)!");
-			return false;
-		}
-
-		read_amt -= amt;
-		while ( amt-- > 0 )
-			*dest++ = (LZuchar) code;
-
-		prev_code = code;
-	}
-
-	return true;
-}
-
-// Unpacks the dynamic Huffman tables from the input
-static void UnpackDynamicHuffman( LightZ_State &state )
-{
-	LightZ_Env *env = state.env;
-	LZuchar *temp_bits_list = env->temp_bits_list;
-
-	int lengths = 257 + state.ReadBits( 5 ); // HLIT
-	int dists = 1 + state.ReadBits( 5 ); // HDIST
-	int codelens = 4 + state.ReadBits( 4 ); // HCLEN
-
-	// Read the code lengths
-	for ( int i = 0; i < 19; ++i )
-		temp_bits_list[ i ] = 0;
-	for ( int i = 0; i < codelens; ++i )
-		temp_bits_list[ g_codelen_order[ i ] ] = state.ReadBits( 3 );
-
-//	ShowBitLenList( "Code lengths (in bits):", temp_bits_list, 19 );
-
-	// Build the codelen Huffman tree
-	if ( !BuildHuffmanTree( temp_bits_list, 19, env->codelen, HUFFSIZE_CODES, env->huffman_values ) )
-	{
-		if ( state.err_msg == 0 )
-			state.err_msg = LZ_ERRORMSG("Unable to build the Huffman tree for code lengths.");
-		return;
-	}
-
-	// Read the dynamic lengths and distances
-	if ( !UnpackCodeLens( state, lengths + dists, temp_bits_list, lengths + dists ) )
-		return;
-
-	// Build the Huffman tree (dynamic lengths)
-	if ( !BuildHuffmanTree( temp_bits_list, lengths, env->dyn_len, HUFFSIZE_LEN, env->huffman_values ) )
-	{
-		if ( state.err_msg == 0 )
-			state.err_msg = LZ_ERRORMSG("Unable to build the dynamic Huffman tree for lengths.");
-		return;
-	}
-
-	// Build the Huffman tree (dynamic distances)
-	if ( !BuildHuffmanTree( &temp_bits_list[ lengths ], dists, env->dyn_dist, HUFFSIZE_DIST, env->huffman_values ) )
-	{
-		if ( state.err_msg == 0 )
-			state.err_msg = LZ_ERRORMSG("Unable to build the dynamic Huffman tree for distances.");
-		return;
-	}
-}
-
-// Inflates one block of data. Return false if this is the last block.
-static bool InflateBlock( LightZ_State &state )
-{
-	bool BFINAL = (state.ReadBits( 1 ) == 0) ? false : true;
-	int BTYPE = state.ReadBits( 2 );
-
-	if ( BTYPE == 0 )
-	{ // No compression
-		// Skip partial bits
-		state.read_byte_left = 0;
-
-		// Read LEN and NLEN
-		int LEN = state.Read();
-		LEN |= state.Read() << 8;
-		int NLEN = state.Read();
-		NLEN |= state.Read() << 8;
-
-		if ( LEN != ((~NLEN) & 0xffff) )
-		{
-			if ( state.err_msg == 0 )
-				state.err_msg = LZ_ERRORMSG("Invalid LEN/NLEN pair in uncompressed data!");
-			return false;
-		}
-
-		// Copy LEN bytes to output
-		int left = LEN;
-		while ( left-- > 0 )
-		{
-			LZuchar v = state.Read();
-			state.Write( v );
-		}
-	}
-	else if ( BTYPE != 3 )
-	{ // Fixed(1)/Dynamic(2) Huffman codes
-		LightZ_HuffNode *huff_len = state.env->pre_len;
-		LightZ_HuffNode *huff_dist = state.env->pre_dist;
-
-		// Do we have a dynamic Huffman table?
-		if ( BTYPE == 2 )
-		{
-			UnpackDynamicHuffman( state );
-
-			huff_len = state.env->dyn_len;
-			huff_dist = state.env->dyn_dist;
-		}
-
-		while ( state.err_msg == 0 )
-		{
-			// Read the length (or literal)
-			int len = state.ReadHuffman( huff_len );
-			if ( len == -1 )
-			{
-				if ( state.err_msg == 0 )
-					state.err_msg = LZ_ERRORMSG("Invalid Huffman length code!");
-				return false;
-			}
-
-			// Process the code
-			if ( len <= 0xff )
-			{ // Literal
-				state.Write( (LZuchar) len );
-			}
-			else if ( len == 256 )
-			{ // End of block
-				break;
-			}
-			else
-			{ // Length
-				// Get the real length
-				len = g_len_base[ len - 257 ] + state.ReadBits( g_len_extra[ len - 257 ] );
-
-				// Get the distance
-				int dist = state.ReadHuffman( huff_dist );
-				if ( dist < 0 )
-				{
-					if ( state.err_msg == 0 )
-						state.err_msg = LZ_ERRORMSG("Invalid Huffman distance code!");
-					return false;
-				}
-				dist = g_dist_base[ dist ] + state.ReadBits( g_dist_extra[ dist ] );
-
-				// Copy len bytes from dist bytes earlier
-				state.WriteBack( dist, len );
-			}
-		}
-	}
-	else
-	{ // Reserved (error)
-		if ( state.err_msg == 0 )
-			state.err_msg = LZ_ERRORMSG("Invalid compressed block BTYPE!");
-	}
-
-	return !BFINAL;
-}
-
-// Allocates a new LightZ environment
-LightZ_Env *ZFN(NewEnv)()
-{
-	return new LightZ_Env();
-}
-
-// Deallocates a LightZ environment
-void ZFN(NewEnv)( LightZ_Env *env )
-{
-	if ( env != 0 ) delete env;
-}
-
-// Inflates the given source data.
-// Params:
-//  source        - The source data pointer (non-null if source_len > 0)
-//  source_len    - Length of the source data
-//  dest          - Pointer to the destination data area.
-//                  If the destination needs enlargement, the old pointer is delete []:d away.
-//  dest_len      - Pointer to the current destination data area size.
-//                  The value will be updated to contain the new unpacked data size.
-// If everything was ok, return null. Otherwise the return value is the error message.
-const char *ZFN(Inflate)(
-	const void *source, int source_len,
-	unsigned char **dest, int *dest_len,
-	LightZ_Env *env )
-{
-	// Basic checks
-	if ( dest == 0 )
-	{
-		const char *temp = LZ_ERRORMSG("Destination buffer pointer is null!");
-		return temp;
-	}
-	if ( dest_len == 0 )
-	{
-		const char *temp = LZ_ERRORMSG("Destination buffer length pointer is null!");
-		return temp;
-	}
-	if ( *dest_len < 0 )
-	{
-		const char *temp = LZ_ERRORMSG("Negative destination buffer lengths are invalid!");
-		return temp;
-	}
-
-	if ( source_len < 0 )
-	{
-		const char *temp = LZ_ERRORMSG("Invalid source data length (<0)!");
-		return temp;
-	}
-	if ( source == 0 || source_len == 0 )
-	{
-		*dest_len = 0;
-		if ( source_len > 0 )
-		{
-			const char *temp = LZ_ERRORMSG("Source length is >0 but the source data pointer is null!");
-			return temp;
-		}
-		return 0;
-	}
-
-	if ( source_len < 8 )
-	{
-		const char *temp = LZ_ERRORMSG("Source length is too small (<8) to hold valid packed data!");
-		return temp;
-	}
-
-	// Create the environment (if needed)
-	LightZ_Env_Guard env_guard;
-
-	if ( env == 0 )
-	{
-		env = new LightZ_Env();
-		env_guard.ptr = env;
-	}
-
-	// Init the unpack state
-	LightZ_State state;
-	state.env = env;
-
-	state.src = (const LZuchar *) source;
-	state.src_left = source_len;
-
-	state.dest = dest;
-	state.dest_pos = dest_len;
-	state.dest_size = *dest_len;
-
-	*state.dest_pos = 0;
-
-	// Check if source and destination overlap
-	if ( *dest != 0 )
-	{
-		const LZuchar *ptr = (const LZuchar *) *dest;
-		int len = state.dest_size;
-		state.src_and_dest_overlap = !((ptr+len)<=state.src || (state.src+state.src_left)<=ptr);
-	}
-
-	// Parse the CMF header
-	LZuchar CMF = state.Read();
-	LZuchar CM = CMF & 0x0f;
-	LZuchar CINFO = (CMF >> 4) & 0x0f;
-
-	if ( CM != 8 )
-	{
-		const char *temp = LZ_ERRORMSG("Unknown compression method (only deflate/inflate is supported)!");
-		return temp;
-	}   
-	if ( CINFO > 7 )
-	{
-		const char *temp = LZ_ERRORMSG("Too big LZ77 window size!");
-		return temp;
-	}   
-	
-	state.window_size = 1 << (8 + CINFO);
-
-	// Parse the FLG header
-	LZuchar FLG = state.Read();
-	LZuchar FDICT = (FLG >> 5) & 1;
-
-	// Test the header checksum
-	if ( (((CMF<<8) | FLG) % 31) != 0 )
-	{
-		const char *temp = LZ_ERRORMSG("Header checksum error!");
-		return temp;
-	}   
-
-	// Uncompress the dictionary (if any)
-	int dict_size = 0;
-	if ( FDICT != 0 )
-	{
-		LZuint dict_id = state.Read() << 24;
-		dict_id |= state.Read() << 16;
-		dict_id |= state.Read() << 8;
-		dict_id |= state.Read() << 0;
-
-		// Unpack the dictionary
-		while ( state.err_msg == 0 )
-		{
-			if ( !InflateBlock( state ) )
-				break;
-		}
-
-		if ( state.err_msg != 0 )
-			return state.err_msg;
-
-		if ( dict_id != state.dest_adler32 )
-		{ // Invalid checksum
-			const char *temp = LZ_ERRORMSG("Invalid dictionary Adler32 checksum!");
-			return temp;
-		}
-
-		// Reset the dictionary changes
-		state.dest_adler32 = ADLER32_START;
-		dict_size = *state.dest_pos;
-	}
-
-	// Unpack the data
-	while ( state.err_msg == 0 )
-	{
-		if ( !InflateBlock( state ) )
-			break;
-	}
-
-	if ( state.err_msg != 0 )
-		return state.err_msg;
-
-	// Remove the dictionary
-	if ( dict_size > 0 )
-	{
-		LZuchar *mem = *dest;
-		LZuchar *d = mem;
-		LZuchar *s = &mem[ dict_size ];
-
-		*dest_len -= dict_size;
-		int left = *dest_len;
-
-		while ( left-- > 0 )
-			*d++ = *s++;
-	}
-
-	// Should have at least 4 bytes left (adler32 checksum)
-	if ( state.src_left < 4 )
-	{
-		const char *temp = LZ_ERRORMSG("Out of data error (checksum missing)!");
-		return temp;
-	}
-	LZuint adler32 = state.Read() << 24;
-	adler32 |= state.Read() << 16;
-	adler32 |= state.Read() << 8;
-	adler32 |= state.Read() << 0;
-
-	if ( state.dest_adler32 != adler32 )
-	{
-		const char * temp = LZ_ERRORMSG("Adler32 checksum error!");
-		return temp;
-	}
-
-	// Too much data?
-//	if ( state.src_left > 0 )
-//		return LZ_ERRORMSG("Too much data; some left unused!");
-    
-	return 0;
-}
+/** Part of the LightZPng library package, v1.02
+ ** 2005-2006 Jere Sanisalo & Housemarque Inc
+ **
+ ** License for this file (MIT):
+ **
+ ** Copyright (c) 2005 Jere Sanisalo & Housemarque Inc
+ **
+ ** Permission is hereby granted, free of charge, to any person obtaining a
+ ** copy of this software and associated documentation files (the "Software"),
+ ** to deal in the Software without restriction, including without limitation
+ ** the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ ** and/or sell copies of the Software, and to permit persons to whom the
+ ** Software is furnished to do so, subject to the following conditions:
+ **
+ ** The above copyright notice and this permission notice shall be included in
+ ** all copies or substantial portions of the Software.
+ **
+ ** THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ ** IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ ** FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ ** AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ ** LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ ** FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ ** DEALINGS IN THE SOFTWARE.
+ **/
+#define LIGHTZ_INTERNAL
+#include "LightZ.h"
+//#include <stdio.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIGHTZ_SSE2
+#include <emmintrin.h>
+#endif
+
+
+#define LZ_META_ASSERT(x) typedef char LZ_META_ASSERT_##__LINE__[ (x) ? 1 : -1 ];
+
+typedef unsigned char LZuchar;
+typedef unsigned short LZushort;
+typedef unsigned int LZuint;
+#ifdef _MSC_VER
+typedef unsigned __int64 LZuint64;
+#else
+typedef unsigned long long LZuint64;
+#endif
+
+LZ_META_ASSERT( sizeof( LZuchar ) == 1 );
+LZ_META_ASSERT( sizeof( LZushort ) == 2 );
+LZ_META_ASSERT( sizeof( LZuint ) == 4 );
+LZ_META_ASSERT( sizeof( LZuint64 ) == 8 );
+
+#define ADLER32_BASE 65521
+#define ADLER32_NMAX 5552
+#define ADLER32_START 1
+#define MAX_BITS 15
+
+#define HUFFSIZE_LEN 2048
+#define HUFFSIZE_DIST 1024
+#define HUFFSIZE_CODES 512
+
+// Lookup table index bits (the first level) for lengths, distances and code lengths
+#define HUFFBITS_LEN 9
+#define HUFFBITS_DIST 6
+#define HUFFBITS_CODES 7
+
+// Lookup table sizes (first level + worst case for all the second level tables).
+// A second level table of N bits needs at least N+1 codes, so the worst case is
+// having as many 15 bit deep subtables as the value count allows (288/7 and 32/10).
+#define HUFFTABLE_LEN ((1<<HUFFBITS_LEN) + 41*(1<<(MAX_BITS-HUFFBITS_LEN)))
+#define HUFFTABLE_DIST ((1<<HUFFBITS_DIST) + 3*(1<<(MAX_BITS-HUFFBITS_DIST)) + 2)
+#define HUFFTABLE_CODES (1<<HUFFBITS_CODES)
+
+// Lookup table entry layout: value/subtable offset (16 bits), bit count (8 bits), entry type (8 bits)
+#define HUFFENTRY_VALUE 0
+#define HUFFENTRY_LINK 1
+#define HUFFENTRY_ERROR 2
+#define HUFFENTRY(type, bits, value) ( ((LZuint)(type) << 24) | ((LZuint)(bits) << 16) | (LZuint)(value) )
+
+#define MAX_HUFFMAN_VALUES 300
+
+// The fast inflate loop runs while there are at least this many bytes of input
+// (one full bit buffer refill) and output (the longest match) left
+#define FAST_MIN_SRC 8
+#define FAST_MIN_DEST (258 + MATCH_COPY_SLACK)
+
+// CopyMatch may write up to this many bytes past the end of the match
+#define MATCH_COPY_SLACK 16
+
+// The stream keeps the last STREAM_WINDOW bytes of output for matches, in a buffer with
+// room for twice as much new output before it has to be slid back
+#define STREAM_WINDOW 32768
+#define STREAM_BUFFER_SIZE (STREAM_WINDOW * 3)
+
+// Input the stream waits for before decoding (unless told the input has ended): enough
+// for any block header (with dynamic tables at most ~290 bytes) and for one code
+#define STREAM_HEADER_MARGIN 320
+#define STREAM_CODE_MARGIN 8
+#define STREAM_CARRY_SIZE 1024
+
+#define for if (false) {} else for
+
+// The error message to return
+#define LZ_ERRORMSG(x) x
+//#define LZ_ERRORMSG(x) "LightZ error!"
+
+// Length base values (codes 257-287)
+static const int g_len_base[] =
+{
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13,
+	15, 17, 19, 23, 27, 31, 35, 43, 51, 59,
+	67, 83, 99, 115, 131, 163, 195, 227, 258,
+	0, 0
+};
+// Extra bits for lengths (codes 257-287)
+static const int g_len_extra[] =
+{
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+	1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+	4, 4, 4, 4, 5, 5, 5, 5, 0,
+	0, 0
+};
+// Distance base values (0-31)
+static const int g_dist_base[] =
+{
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25,
+	33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+	1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+	0, 0
+};
+// Extra bits for distance (0-31)
+static const int g_dist_extra[] =
+{
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3,
+	4, 4, 5, 5, 6, 6, 7, 7, 8, 8,
+	9, 9, 10, 10, 11, 11, 12, 12, 13,13,
+	0, 0
+};
+// Code length write order
+static const int g_codelen_order[] =
+{
+	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+// The adler32 update. The sums are taken modulo ADLER32_BASE only once per ADLER32_NMAX
+// bytes (the largest amount that can't overflow 32 bits), 16 bytes at a time with SSE2.
+static LZuint UpdateAdler32( LZuint adler, const LZuchar *buf, int len )
+{
+	LZuint s1 = adler & 0xffff;
+	LZuint s2 = (adler >> 16) & 0xffff;
+
+	while ( len > 0 )
+	{
+		int n = (len < ADLER32_NMAX) ? len : ADLER32_NMAX;
+		len -= n;
+
+#ifdef LIGHTZ_SSE2
+		int blocks = n >> 4;
+		if ( blocks > 0 )
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i weights_lo = _mm_set_epi16( 9, 10, 11, 12, 13, 14, 15, 16 );
+			const __m128i weights_hi = _mm_set_epi16( 1, 2, 3, 4, 5, 6, 7, 8 );
+
+			__m128i v_s1 = zero;		// byte sums
+			__m128i v_s1_prev = zero;	// sum of the byte sums before each block
+			__m128i v_s2 = zero;		// weighted byte sums within the blocks
+
+			for ( int i = 0; i < blocks; ++i, buf += 16 )
+			{
+				__m128i v = _mm_loadu_si128( (const __m128i *) buf );
+
+				v_s1_prev = _mm_add_epi32( v_s1_prev, v_s1 );
+				v_s1 = _mm_add_epi32( v_s1, _mm_sad_epu8( v, zero ) );
+				v_s2 = _mm_add_epi32( v_s2, _mm_madd_epi16( _mm_unpacklo_epi8( v, zero ), weights_lo ) );
+				v_s2 = _mm_add_epi32( v_s2, _mm_madd_epi16( _mm_unpackhi_epi8( v, zero ), weights_hi ) );
+			}
+
+			// Horizontal sums
+			v_s1 = _mm_add_epi32( v_s1, _mm_shuffle_epi32( v_s1, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+			v_s1_prev = _mm_add_epi32( v_s1_prev, _mm_shuffle_epi32( v_s1_prev, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+			v_s2 = _mm_add_epi32( v_s2, _mm_shuffle_epi32( v_s2, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+			v_s2 = _mm_add_epi32( v_s2, _mm_shuffle_epi32( v_s2, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+
+			s2 += s1 * 16 * blocks + 16 * (LZuint) _mm_cvtsi128_si32( v_s1_prev ) + (LZuint) _mm_cvtsi128_si32( v_s2 );
+			s1 += (LZuint) _mm_cvtsi128_si32( v_s1 );
+			n &= 15;
+		}
+#endif
+
+		while ( n-- > 0 )
+		{
+			s1 += *buf++;
+			s2 += s1;
+		}
+
+		s1 %= ADLER32_BASE;
+		s2 %= ADLER32_BASE;
+	}
+
+	return (s2 << 16) + s1;
+}
+
+// Reads 8 bytes of little endian data
+static inline LZuint64 LoadLE64( const LZuchar *p )
+{
+	return  (LZuint64) p[ 0 ]        | ((LZuint64) p[ 1 ] << 8 )  |
+		   ((LZuint64) p[ 2 ] << 16) | ((LZuint64) p[ 3 ] << 24) |
+		   ((LZuint64) p[ 4 ] << 32) | ((LZuint64) p[ 5 ] << 40) |
+		   ((LZuint64) p[ 6 ] << 48) | ((LZuint64) p[ 7 ] << 56);
+}
+
+// Copies a len byte match from dist bytes back, using 16 or 8 byte copies where the areas
+// don't overlap and a replicated 8 byte pattern for distances below 8. Writes up to
+// MATCH_COPY_SLACK bytes of garbage past the end of the match. Returns the new out.
+static inline LZuchar *CopyMatch( LZuchar *out, int dist, int len )
+{
+	const LZuchar *s = out - dist;
+	LZuchar *end = out + len;
+
+	if ( dist >= 16 )
+	{
+		do
+		{
+#ifdef LIGHTZ_SSE2
+			_mm_storeu_si128( (__m128i *) out, _mm_loadu_si128( (const __m128i *) s ) );
+#else
+			memcpy( out, s, 16 );
+#endif
+			out += 16;
+			s += 16;
+		} while ( out < end );
+	}
+	else if ( dist >= 8 )
+	{
+		do
+		{
+			memcpy( out, s, 8 );
+			out += 8;
+			s += 8;
+		} while ( out < end );
+	}
+	else
+	{
+		// Make an 8 byte pattern of the repeating part and write it with a step that is
+		// a multiple of the distance (8 for 1, 2, 4; 6 for 3, 6; otherwise the distance)
+		LZuchar pattern[ 8 ];
+		for ( int i = 0; i < 8; ++i )
+			pattern[ i ] = s[ i % dist ];
+
+		int step = (8 / dist) * dist;
+		do
+		{
+			memcpy( out, pattern, 8 );
+			out += step;
+		} while ( out < end );
+	}
+
+	return end;
+}
+
+// One Huffman tree node
+struct LightZ_HuffNode
+{
+	// The table index to jump to if the next bit is 1. If 0, then this is a literal node. If 0xffff, then this is an error node.
+	// If the next bit is 0, then the next table index is (this+1).
+	LZushort jump_if_1;
+
+	// If "jump_if_1" is 0, then this is the literal value for this node.
+	LZushort value;
+};
+
+// One Huffman value/code pair
+struct LightZ_HuffCode
+{
+	LZushort bits;
+	LZushort code;
+	LZushort value;
+};
+
+// One Huffman decoder. The same code is stored both as a bit-by-bit tree and as a
+// two level lookup table; which one is used for decoding is selected by the environment.
+struct LightZ_Huffman
+{
+	// The tree nodes (see LightZ_HuffNode)
+	LightZ_HuffNode *tree;
+	int tree_size;
+
+	// The lookup table. The first (1<<table_bits) entries are indexed with the next
+	// table_bits input bits; longer codes link to a second level table after that.
+	LZuint *table;
+	int table_size;
+	int table_bits;
+
+	LightZ_Huffman()
+		: tree( 0 )
+		, tree_size( 0 )
+		, table( 0 )
+		, table_size( 0 )
+		, table_bits( 0 )
+	{ }
+
+	void Set( LightZ_HuffNode *t, int t_size, LZuint *tab, int tab_size, int tab_bits )
+	{
+		tree = t;
+		tree_size = t_size;
+		table = tab;
+		table_size = tab_size;
+		table_bits = tab_bits;
+	}
+};
+
+///////////////////////////////////
+///////////////////////////////////
+////////////   DEBUG   ////////////
+///////////////////////////////////
+///////////////////////////////////
+
+/*
+static void ShowBits( int num, int bits )
+{
+	for ( int i = 0; i < bits; ++i )
+	{
+		int shift = bits - i - 1;
+		int bit = (num >> shift) & 1;
+		printf( "%d", bit );
+	}
+}
+
+static void ShowBitLenList( const char *title, LZuchar *list, int size )
+{
+	printf( "%s\n", title );
+	for ( int i = 0; i < size; ++i )
+	{
+		printf( "%3d: %d\n", i, list[ i ] );
+	}
+}
+
+static void ShowHuffTree( LightZ_HuffNode *tree, const char *prefix, int node, int indent )
+{
+	LightZ_HuffNode *n = &tree[ node ];
+
+	for ( int i = 0; i < indent; ++i )
+		printf( " " );
+
+	printf( "%s[%d] ", prefix, node );
+	if ( n->jump_if_1 == 0 )
+		printf( "Value: %d\n", n->value );
+	else if ( n->jump_if_1 == 0xffff )
+		printf( "ERROR NODE\n" );
+	else
+	{
+		printf( "\n" );
+		ShowHuffTree( tree, "Zero-> ", node + 1, indent + 2 );
+		ShowHuffTree( tree, "One -> ", n->jump_if_1, indent + 2 );
+	}
+}
+*/
+
+///////////////////////////////////
+///////////////////////////////////
+///////////////////////////////////
+///////////////////////////////////
+///////////////////////////////////
+
+// Sorts a table of Huffman codes (increasing order by code&bits).
+static void SortHuffmanCodes( LightZ_HuffCode *codes, int amt )
+{
+	// TODO: Faster sort code!
+	for ( int i = 0; i < amt; ++i )
+	{
+		for ( int j = i + 1; j < amt; ++j )
+		{
+			if ( codes[ i ].code <= codes[ j ].code )
+				continue;
+
+			LightZ_HuffCode tmp = codes[ i ];
+			codes[ i ] = codes[ j ];
+			codes[ j ] = tmp;
+		}
+	}
+}
+
+// Builds the Huffman tree nodes from a tree-sorted Huffman code table
+static int BuildHuffmanNodes( int cur_bit, int code_idx, LightZ_HuffCode *codes, int code_amt, LightZ_HuffNode *dest_tree, int dest_tree_pos, int dest_tree_max_size )
+{
+	if ( dest_tree_pos >= dest_tree_max_size )
+		return -1;
+	if ( code_idx >= code_amt )
+		return -1;
+
+	if ( cur_bit == codes[ code_idx ].bits )
+	{ // Found an ending leaf node
+		dest_tree[ dest_tree_pos ].jump_if_1 = 0;
+		dest_tree[ dest_tree_pos ].value = codes[ code_idx ].value;
+		return dest_tree_pos + 1;
+	}
+
+	// Make a knot node (branch)
+	LightZ_HuffNode *knot = &dest_tree[ dest_tree_pos++ ];
+	knot->jump_if_1 = 0xffff; // (will be changed later, just a temp value)
+
+	if ( dest_tree_pos >= dest_tree_max_size )
+		return -1;
+
+	// Get the next bit (counting from left; MSB side)
+	int bit = (codes[ code_idx ].code >> (MAX_BITS-1-cur_bit)) & 1;
+
+	if ( bit == 0 )
+	{ // Add the bit 0 -subtree
+		dest_tree_pos = BuildHuffmanNodes( cur_bit + 1, code_idx, codes, code_amt, dest_tree, dest_tree_pos, dest_tree_max_size );
+		if ( dest_tree_pos < 0 )
+			return -1;
+	}
+	else
+	{ // Cannot continue with a zero bit
+		dest_tree[ dest_tree_pos++ ].jump_if_1 = 0xffff;
+		if ( dest_tree_pos >= dest_tree_max_size )
+			return -1;
+	}
+
+	knot->jump_if_1 = dest_tree_pos;
+
+	// Scroll to a position where this bit is one (start of the other subtree)
+	while ( code_idx < code_amt )
+	{
+		bit = (codes[ code_idx ].code >> (MAX_BITS-1-cur_bit)) & 1;
+		if ( bit == 1 )
+			break;
+		++code_idx;
+	}
+
+	// Bit 1 not found?
+	if ( code_idx >= code_amt )
+	{
+		dest_tree[ dest_tree_pos++ ].jump_if_1 = 0xffff;
+		return dest_tree_pos;
+	}
+
+	// Add the bit 1 subtree
+	dest_tree_pos = BuildHuffmanNodes( cur_bit + 1, code_idx, codes, code_amt, dest_tree, dest_tree_pos, dest_tree_max_size );
+	return dest_tree_pos;
+}
+
+// Builds the Huffman lookup table from a (not necessarily sorted) Huffman code table
+static bool BuildHuffmanTable( LightZ_HuffCode *codes, int code_amt, LZuint *dest_table, int dest_table_bits, int dest_table_max_size )
+{
+	int root_size = 1 << dest_table_bits;
+	int root_mask = root_size - 1;
+	if ( root_size > dest_table_max_size )
+		return false;
+
+	// Reverse the codes (the input is read LSB first) and find the deepest code behind each first level entry
+	LZuchar sub_bits[ 1 << HUFFBITS_LEN ];
+	for ( int i = 0; i < root_size; ++i )
+		sub_bits[ i ] = 0;
+
+	for ( int i = 0; i < code_amt; ++i )
+	{
+		int rev = 0;
+		for ( int b = 0; b < MAX_BITS; ++b )
+			rev |= ((codes[ i ].code >> (MAX_BITS-1-b)) & 1) << b;
+		codes[ i ].code = (LZushort) rev;
+
+		int extra = codes[ i ].bits - dest_table_bits;
+		if ( extra > sub_bits[ rev & root_mask ] )
+			sub_bits[ rev & root_mask ] = (LZuchar) extra;
+	}
+
+	// Lay out the second level tables after the first level one
+	int pos = root_size;
+	for ( int i = 0; i < root_size; ++i )
+	{
+		if ( sub_bits[ i ] == 0 )
+		{
+			dest_table[ i ] = HUFFENTRY( HUFFENTRY_ERROR, 0, 0 );
+			continue;
+		}
+
+		int sub_size = 1 << sub_bits[ i ];
+		if ( pos + sub_size > dest_table_max_size )
+			return false;
+
+		dest_table[ i ] = HUFFENTRY( HUFFENTRY_LINK, sub_bits[ i ], pos );
+		for ( int j = 0; j < sub_size; ++j )
+			dest_table[ pos + j ] = HUFFENTRY( HUFFENTRY_ERROR, 0, 0 );
+		pos += sub_size;
+	}
+
+	// Fill in the values (each code covers all the entries that have it as a prefix)
+	for ( int i = 0; i < code_amt; ++i )
+	{
+		int bits = codes[ i ].bits;
+		int rev = codes[ i ].code;
+
+		if ( bits <= dest_table_bits )
+		{
+			LZuint entry = HUFFENTRY( HUFFENTRY_VALUE, bits, codes[ i ].value );
+			for ( int j = rev; j < root_size; j += (1 << bits) )
+				dest_table[ j ] = entry;
+		}
+		else
+		{
+			LZuint link = dest_table[ rev & root_mask ];
+			LZuint *sub = &dest_table[ link & 0xffff ];
+			int sub_size = 1 << ((link >> 16) & 0xff);
+			int sub_bits_used = bits - dest_table_bits;
+
+			LZuint entry = HUFFENTRY( HUFFENTRY_VALUE, sub_bits_used, codes[ i ].value );
+			for ( int j = rev >> dest_table_bits; j < sub_size; j += (1 << sub_bits_used) )
+				sub[ j ] = entry;
+		}
+	}
+
+	return true;
+}
+
+// Builds a huffman tree (and/or the lookup table) for the given decoder.
+static bool BuildHuffmanTree( LZuchar *val_bits, int values, LightZ_Huffman &dest, bool build_tree, bool build_table, LightZ_HuffCode *temp_codes )
+{
+	// Count how many values there are for each bit length
+	int values_per_bitlen[ MAX_BITS + 1 ];
+
+	for ( int i = 0; i <= MAX_BITS; ++i )
+		values_per_bitlen[ i ] = 0;
+	for ( int i = 0; i < values; ++i )
+	{
+		int bits = val_bits[ i ];
+		if ( bits < 0 || bits > MAX_BITS )
+			return false;
+		values_per_bitlen[ bits ]++;
+	}
+	values_per_bitlen[ 0 ] = 0;
+
+	// Test for too few/too many bits allocated
+	if ( values > 1 )
+	{
+		int left = 1;
+		for ( int i = 1; i <= MAX_BITS; ++i )
+		{
+			left <<= 1;
+			left -= values_per_bitlen[ i ];
+			// Too many bits?
+			if ( left < 0 )
+				return false;
+		}
+		// Too few bits?
+		if ( left > 0 )
+			return false;
+	}
+	else
+	{ // Either 0 or 1 values
+		if ( values_per_bitlen[ 1 ] != values )
+			return false;
+	}
+
+	// Find a numerical smallest value for each of the bit lengths
+	int next_code[ MAX_BITS + 1 ];
+	int code = 0;
+	for ( int bits = 1; bits <= MAX_BITS; ++bits )
+	{
+		code = ( code + values_per_bitlen[ bits - 1 ] ) << 1;
+		next_code[ bits ] = code;
+	}
+
+	// Generate the code values
+	if ( values > MAX_HUFFMAN_VALUES )
+		return false;
+	LightZ_HuffCode *codes = temp_codes;
+	int code_amt = 0;
+
+//	printf( "Huffman codes:\n" );
+	for ( int i = 0; i < values; ++i )
+	{
+		int bits = val_bits[ i ];
+		if ( bits == 0 )
+			continue;
+
+		codes[ code_amt ].bits = bits;
+		codes[ code_amt ].code = next_code[ bits ] << (MAX_BITS - bits); // Make it so that the first bit is always at the left side
+		codes[ code_amt ].value = (LZushort) i;
+
+//		printf( "Val: %d\tBits: %d\tCode: ", i, bits );
+//		ShowBits( next_code[ bits ], bits );
+//		printf( "\n" );
+
+		++code_amt;
+		next_code[ bits ]++;
+	}
+
+	bool ok = true;
+
+	if ( build_tree )
+	{
+		LightZ_HuffNode *dest_tree = dest.tree;
+
+		// Sort the codes to increasing order
+		SortHuffmanCodes( codes, code_amt );
+
+		// Init the tree construction
+		dest_tree[ 0 ].jump_if_1 = 0xffff;
+
+		if ( code_amt > 0 )
+		{
+			if ( BuildHuffmanNodes( 0, 0, codes, code_amt, dest_tree, 0, dest.tree_size ) < 0 )
+				ok = false;
+		}
+
+//		if ( ok ) ShowHuffTree( dest_tree, "", 0, 0 );
+	}
+
+	// Build the lookup table (this reverses the codes in place, so it's done after the tree)
+	if ( ok && build_table )
+		ok = BuildHuffmanTable( codes, code_amt, dest.table, dest.table_bits, dest.table_size );
+
+	return ok;
+}
+
+// The memory allocated environment
+struct LightZ_Env
+{
+	// Allocations for prebuilt length/distance trees
+	LightZ_HuffNode pre_len[ HUFFSIZE_LEN ];
+	LightZ_HuffNode pre_dist[ HUFFSIZE_DIST ];
+
+	// Allocations for dynamic length/distance trees
+	LightZ_HuffNode dyn_len[ HUFFSIZE_LEN ];
+	LightZ_HuffNode dyn_dist[ HUFFSIZE_DIST ];
+
+	// Allocations for dynamic code length trees
+	LightZ_HuffNode codelen[ HUFFSIZE_CODES ];
+
+	// Allocations for the lookup tables (same codes as the trees above)
+	LZuint pre_len_table[ HUFFTABLE_LEN ];
+	LZuint pre_dist_table[ HUFFTABLE_DIST ];
+	LZuint dyn_len_table[ HUFFTABLE_LEN ];
+	LZuint dyn_dist_table[ HUFFTABLE_DIST ];
+	LZuint codelen_table[ HUFFTABLE_CODES ];
+
+	// The decoders (tree + table) for the allocations above
+	LightZ_Huffman huff_pre_len;
+	LightZ_Huffman huff_pre_dist;
+	LightZ_Huffman huff_dyn_len;
+	LightZ_Huffman huff_dyn_dist;
+	LightZ_Huffman huff_codelen;
+
+	// Decode with the bit-by-bit trees instead of the lookup tables (for benchmarking)
+	bool use_trees;
+
+	// Allocation for bit list big enough for lengths & distances
+	LZuchar temp_bits_list[ 512 ];
+
+	// Temporary for huffman code values (used during tree construction)
+	LightZ_HuffCode huffman_values[ MAX_HUFFMAN_VALUES ];
+
+
+	LightZ_Env()
+		: use_trees( false )
+	{
+		huff_pre_len.Set( pre_len, HUFFSIZE_LEN, pre_len_table, HUFFTABLE_LEN, HUFFBITS_LEN );
+		huff_pre_dist.Set( pre_dist, HUFFSIZE_DIST, pre_dist_table, HUFFTABLE_DIST, HUFFBITS_DIST );
+		huff_dyn_len.Set( dyn_len, HUFFSIZE_LEN, dyn_len_table, HUFFTABLE_LEN, HUFFBITS_LEN );
+		huff_dyn_dist.Set( dyn_dist, HUFFSIZE_DIST, dyn_dist_table, HUFFTABLE_DIST, HUFFBITS_DIST );
+		huff_codelen.Set( codelen, HUFFSIZE_CODES, codelen_table, HUFFTABLE_CODES, HUFFBITS_CODES );
+
+		// Build the predefined length list
+		for ( int i = 0; i <= 143; ++i )
+			temp_bits_list[ i ] = 8;
+		for ( int i = 144; i <= 255; ++i )
+			temp_bits_list[ i ] = 9;
+		for ( int i = 256; i <= 279; ++i )
+			temp_bits_list[ i ] = 7;
+		for ( int i = 280; i <= 287; ++i )
+			temp_bits_list[ i ] = 8;
+
+		BuildHuffmanTree( temp_bits_list, 288, huff_pre_len, true, true, huffman_values );
+
+		// Build the predefined distance list
+		for ( int i = 0; i <= 31; ++i )
+			temp_bits_list[ i ] = 5;
+
+		BuildHuffmanTree( temp_bits_list, 32, huff_pre_dist, true, true, huffman_values );
+	}
+
+	~LightZ_Env()
+	{
+	}
+};
+
+// Scope guard for the environment
+class LightZ_Env_Guard
+{
+public:
+	LightZ_Env *ptr;
+
+	LightZ_Env_Guard() : ptr( 0 ) { }
+	~LightZ_Env_Guard() { if ( ptr != 0 ) delete ptr; }
+};
+
+// The unpacking state
+struct LightZ_State
+{
+	// The memory environment
+	LightZ_Env *env;
+
+	// The source data
+	const LZuchar *src;
+	int src_left;
+
+	bool src_reallocated; // Flag to see if src has been reallocated (only in the case of overlapping areas)
+	LZuchar *release_src; // In case src has been reallocated, this is the pointer that should be released
+
+	// The destination data
+	LZuint dest_adler32;
+	int dest_adler32_pos;	// The checksum is up to date up to this destination position
+	bool verify;			// If false, the checksums are not calculated nor tested
+	LZuchar **dest;
+	int *dest_pos;
+	int dest_size;
+
+	bool src_and_dest_overlap; // If source and destination areas 
+
+	// Bit buffer (for bit reading). Holds bit_count not yet used input bits, LSB first.
+	LZuint64 bit_buf;
+	int bit_count;
+
+	// The sliding window to backwards (written) data
+	int window_size;
+
+	// Current error message (null == all ok)
+	const char *err_msg;
+
+
+
+	LightZ_State()
+		: src( 0 )
+		, src_left( 0 )
+		, src_reallocated( 0 )
+		, release_src( 0 )
+		, dest_adler32( ADLER32_START )
+		, dest_adler32_pos( 0 )
+		, verify( true )
+		, dest( 0 )
+		, dest_pos( 0 )
+		, dest_size( 0 )
+		, src_and_dest_overlap( false )
+		, bit_buf( 0 )
+		, bit_count( 0 )
+		, window_size( 0 )
+		, err_msg( 0 )
+	{ }
+
+	~LightZ_State()
+	{
+		if ( release_src != 0 )
+			delete [] release_src;
+		release_src = 0;
+	}
+
+	// Reads one character of input.
+	LZuchar Read()
+	{
+		if ( src == 0 || src_left <= 0 )
+		{
+			if ( err_msg == 0 )
+				err_msg = LZ_ERRORMSG("Out of source data (EOS)!");
+			return 0;
+		}
+
+		--src_left;
+		return *src++;
+	}
+
+	// Fills the bit buffer to at least 56 bits with a single 8 byte read.
+	// Needs at least FAST_MIN_SRC bytes of source data left. The bits above bit_count
+	// are left holding the start of the next unread byte; this is harmless as long as
+	// they are cleared before the source is read directly (see ReadAligned).
+	void RefillFast()
+	{
+		bit_buf |= LoadLE64( src ) << bit_count;
+
+		int amt = (63 - bit_count) >> 3;
+		src += amt;
+		src_left -= amt;
+		bit_count |= 56;
+	}
+
+	// Returns the next x (<=16) bits of data without using them up. Past the end of
+	// the source data the missing bits read as zero (see DropBits).
+	int PeekBits( int bits )
+	{
+		if ( bit_count < bits )
+		{
+			if ( src_left >= FAST_MIN_SRC )
+				RefillFast();
+			else
+			{
+				while ( bit_count <= 56 && src != 0 && src_left > 0 )
+				{
+					bit_buf |= (LZuint64) *src++ << bit_count;
+					--src_left;
+					bit_count += 8;
+				}
+			}
+		}
+
+		return (int)( bit_buf & ((1u << bits) - 1) );
+	}
+
+	// Uses up x bits of already peeked data
+	void DropBits( int bits )
+	{
+		if ( bits > bit_count )
+		{
+			if ( err_msg == 0 )
+				err_msg = LZ_ERRORMSG("Out of source data (EOS)!");
+			bit_buf = 0;
+			bit_count = 0;
+			return;
+		}
+
+		bit_buf >>= bits;
+		bit_count -= bits;
+	}
+
+	// Reads x bits of data
+	int ReadBits( int bits )
+	{
+		if ( bits <= 0 )
+			return 0;
+
+		int ret = PeekBits( bits );
+		DropBits( bits );
+		return ret;
+	}
+
+	// Skips the partially read bits up to the next byte boundary
+	void AlignToByte()
+	{
+		DropBits( bit_count & 7 );
+	}
+
+	// Reads one character of byte aligned input (after AlignToByte), buffered bits first
+	LZuchar ReadAligned()
+	{
+		if ( bit_count < 8 )
+		{
+			bit_buf = 0; // (drop the bits RefillFast may have read ahead)
+			return Read();
+		}
+
+		LZuchar ret = (LZuchar) bit_buf;
+		bit_buf >>= 8;
+		bit_count -= 8;
+		return ret;
+	}
+
+	// Checks that there are at least x bits of input left, including the buffered ones
+	bool HasBits( int bits ) const
+	{
+		return bit_count >= bits || src_left >= ((bits - bit_count + 7) >> 3);
+	}
+
+	// Bytes of input left (after AlignToByte), including the buffered ones
+	int AlignedLeft() const
+	{
+		return src_left + (bit_count >> 3);
+	}
+
+	// Reads a Huffman packed value (-1 on error)
+	int ReadHuffman( const LightZ_Huffman &huff )
+	{
+		if ( env->use_trees )
+			return ReadHuffman( huff.tree );
+
+		// First level lookup
+		LZuint entry = huff.table[ PeekBits( huff.table_bits ) ];
+		int type = entry >> 24;
+
+		if ( type == HUFFENTRY_LINK )
+		{ // Longer code; continue in the second level table
+			DropBits( huff.table_bits );
+			entry = huff.table[ (entry & 0xffff) + PeekBits( (entry >> 16) & 0xff ) ];
+			type = entry >> 24;
+		}
+
+		if ( type != HUFFENTRY_VALUE )
+			return -1;
+
+		DropBits( (entry >> 16) & 0xff );
+		if ( err_msg != 0 )
+			return -1;
+
+		return entry & 0xffff;
+	}
+
+	// Reads a Huffman packed value, given the Huffman decoding tree (-1 on error)
+	int ReadHuffman( LightZ_HuffNode *tree )
+	{
+		if ( tree == 0 )
+			return -1;
+
+		int idx = 0;
+		while ( err_msg == 0 )
+		{
+			int jump_if_1 = tree[ idx ].jump_if_1;
+
+			if ( jump_if_1 == 0 )
+				return tree[ idx ].value;
+			if ( jump_if_1 == 0xffff )
+				return -1;
+
+			int bit = ReadBits( 1 );
+
+			if ( bit == 0 )
+				++idx;
+			else
+				idx = jump_if_1;
+		}
+
+		return -1;
+	}
+
+	// Writes one character of data
+	void Write( LZuchar chr )
+	{
+		if ( !EnsureFreeSize( 1 ) )
+			return;
+
+		// Check for dest and source overlaps
+		if ( src_and_dest_overlap )
+			CheckForDestOverlap( 1 );
+
+		// Write the data
+		(*dest)[ (*dest_pos)++ ] = chr;
+	}
+
+	// Writes data from back window
+	void WriteBack( int dist, int len )
+	{
+		int start_pos = *dest_pos - dist;
+
+		if ( dist <= 0 || len <= 0 )
+			return;
+		if ( start_pos < 0 )
+		{
+			if ( err_msg == 0 )
+				err_msg = LZ_ERRORMSG("Unable to refer outside the unpacked data boundary!");
+			return;
+		}
+
+		if ( !EnsureFreeSize( len ) )
+			return;
+
+		// Check for dest and source overlaps
+		if ( src_and_dest_overlap )
+			CheckForDestOverlap( len );
+
+		// Copy the data
+		LZuchar *s = &((*dest)[ start_pos ]);
+		LZuchar *d = &((*dest)[ *dest_pos ]);
+
+		if ( !src_and_dest_overlap && dest_size - *dest_pos >= len + MATCH_COPY_SLACK )
+			CopyMatch( d, dist, len );
+		else
+		{
+			int left = len;
+			while ( left-- > 0 )
+				*d++ = *s++;
+		}
+		*dest_pos += len;
+	}
+
+	// Copies len bytes of byte aligned input to the destination (stored blocks).
+	// The destination size is checked once for the whole run.
+	void WriteStored( int len )
+	{
+		if ( len <= 0 || !EnsureFreeSize( len ) )
+			return;
+
+		// Check for dest and source overlaps
+		if ( src_and_dest_overlap )
+			CheckForDestOverlap( len );
+
+		LZuchar *d = &((*dest)[ *dest_pos ]);
+
+		// Bytes already in the bit buffer first
+		while ( len > 0 && bit_count >= 8 )
+		{
+			*d++ = ReadAligned();
+			++*dest_pos;
+			--len;
+		}
+		if ( len <= 0 )
+			return;
+
+		bit_buf = 0; // (see ReadAligned)
+		if ( src == 0 || src_left < len )
+		{
+			if ( err_msg == 0 )
+				err_msg = LZ_ERRORMSG("Out of source data (EOS)!");
+			return;
+		}
+
+		memmove( d, src, len );
+		src += len;
+		src_left -= len;
+		*dest_pos += len;
+	}
+
+	// Updates the checksum with the data written since the last update
+	void UpdateChecksum()
+	{
+		if ( verify && *dest_pos > dest_adler32_pos )
+			dest_adler32 = UpdateAdler32( dest_adler32, *dest + dest_adler32_pos, *dest_pos - dest_adler32_pos );
+		dest_adler32_pos = *dest_pos;
+	}
+
+private:
+	// Preallocate a small buffer for overlapping src copying
+	enum { STATIC_SRC_BUFFER_SIZE = 16 };
+	LZuchar m_src_prealloc_buffer[ STATIC_SRC_BUFFER_SIZE ];
+
+
+	// Ensures free destination size for at least x more bytes
+	// Returns false in case of an error.
+	bool EnsureFreeSize( int free )
+	{
+		if ( free <= 0 )
+			return true;
+
+		int cur_free = dest_size - *dest_pos;
+		if ( cur_free >= free )
+			return true;
+
+		// If source and destination buffers overlap, then dest cannot be freed/reallocated.
+		if ( src_and_dest_overlap )
+		{
+			const char *tmp = LZ_ERRORMSG("Unable to resize the destination buffer when it overlaps with the source data memory.");
+			err_msg = tmp;
+			return false;
+		}
+
+		// Get the amount to allocate
+		int alloc_more = 16 + (free - cur_free) + src_left + (src_left >> 3);
+		int new_size = dest_size + alloc_more;
+
+		// Allocate the new buffer
+		LZuchar *dold = *dest;
+		LZuchar *dnew = new LZuchar[ new_size ];
+
+		if ( dnew == 0 )
+		{
+			err_msg = LZ_ERRORMSG("Out of memory error!");
+			return false;
+		}
+
+		// Copy old data
+		if ( dold != 0 )
+		{
+			LZuchar *s = dold;
+			LZuchar *d = dnew;
+			int left = *dest_pos;
+			while ( left-- > 0 )
+				*d++ = *s++;
+		}
+
+		// Switch to new buffer
+		*dest = dnew;
+		dest_size = new_size;
+
+		if ( dold != 0 )
+			delete [] dold;
+
+		return true;
+	}
+
+	// Called when we know that the source and destination areas overlap. This function checks if
+	// the overlap actually occurs now.
+	void CheckForDestOverlap( int add_amt )
+	{
+		if ( src_reallocated || src_left <= 0 || add_amt <= 0 )
+			return;
+
+		// Would this write make dest catch up to source?
+		LZuchar *d_after = *dest + (*dest_pos + add_amt);
+		if ( d_after < src )
+			return;
+
+		// Allocate a new source buffer for the rest of the data
+		bool use_prealloc = ( src_left <= STATIC_SRC_BUFFER_SIZE );
+		LZuchar *new_src = (use_prealloc ? m_src_prealloc_buffer : new LZuchar[ src_left ]);
+
+		if ( new_src == 0 )
+		{
+			if ( err_msg == 0 )
+			{
+				const char *tmp = LZ_ERRORMSG( "Error allocating a new source buffer (destination and source buffers overlap)." );
+				err_msg = tmp;
+			}
+			return;
+		}
+
+		// Copy the remaining data
+		int left = src_left;
+		const LZuchar *s = src;
+		LZuchar *d = new_src;
+
+		while ( left-- > 0 )
+			*d++ = *s++;
+
+		// Switch to new source
+		src = new_src;
+		src_reallocated = true;
+		if ( !use_prealloc )
+			release_src = new_src;
+	}
+};
+
+// Unpacks the bit lengths by using the code length Huffman tree
+static bool UnpackCodeLens( LightZ_State &state, int read_amt, LZuchar *dest, int dest_size )
+{
+	const LightZ_Huffman &huff_codelen = state.env->huff_codelen;
+
+	for ( int i = 0; i < dest_size; ++i )
+		dest[ i ] = 0;
+
+	int prev_code = -1;
+	while ( read_amt > 0 )
+	{
+		int code = state.ReadHuffman( huff_codelen );
+		if ( code < 0 )
+		{
+			if ( state.err_msg == 0 )
+				state.err_msg = LZ_ERRORMSG("Invalid Huffman code in code lengths!");
+			return false;
+		}
+
+		int amt = 1;
+		switch ( code )
+		{
+		case 16:	amt = 3 + state.ReadBits( 2 ); code = prev_code; break;
+		case 17:	amt = 3 + state.ReadBits( 3 ); code = 0; break;
+		case 18:	amt = 11 + state.ReadBits( 7 ); code = 0; break;
+		}
+
+		if ( code < 0 || code > 15 )
+		{
+			if ( state.err_msg == 0 )
+				state.err_msg = LZ_ERRORMSG("Invalid code to repeat (in dynamic Huffman construction)!");
+			return false;
+		}
+		if ( amt > read_amt )
+		{
+			if ( state.err_msg == 0 )
+				state.err_msg = LZ_ERRORMSG("Too many codes (in dynamic Huffman construction)!");
+			return false;
+		}
+
+		read_amt -= amt;
+		while ( amt-- > 0 )
+			*dest++ = (LZuchar) code;
+
+		prev_code = code;
+	}
+
+	return true;
+}
+
+// Unpacks the dynamic Huffman tables from the input
+static void UnpackDynamicHuffman( LightZ_State &state )
+{
+	LightZ_Env *env = state.env;
+	LZuchar *temp_bits_list = env->temp_bits_list;
+
+	int lengths = 257 + state.ReadBits( 5 ); // HLIT
+	int dists = 1 + state.ReadBits( 5 ); // HDIST
+	int codelens = 4 + state.ReadBits( 4 ); // HCLEN
+
+	// Read the code lengths
+	for ( int i = 0; i < 19; ++i )
+		temp_bits_list[ i ] = 0;
+	for ( int i = 0; i < codelens; ++i )
+		temp_bits_list[ g_codelen_order[ i ] ] = state.ReadBits( 3 );
+
+//	ShowBitLenList( "Code lengths (in bits):", temp_bits_list, 19 );
+
+	// Build the codelen Huffman tree
+	if ( !BuildHuffmanTree( temp_bits_list, 19, env->huff_codelen, env->use_trees, !env->use_trees, env->huffman_values ) )
+	{
+		if ( state.err_msg == 0 )
+			state.err_msg = LZ_ERRORMSG("Unable to build the Huffman tree for code lengths.");
+		return;
+	}
+
+	// Read the dynamic lengths and distances
+	if ( !UnpackCodeLens( state, lengths + dists, temp_bits_list, lengths + dists ) )
+		return;
+
+	// Build the Huffman tree (dynamic lengths)
+	if ( !BuildHuffmanTree( temp_bits_list, lengths, env->huff_dyn_len, env->use_trees, !env->use_trees, env->huffman_values ) )
+	{
+		if ( state.err_msg == 0 )
+			state.err_msg = LZ_ERRORMSG("Unable to build the dynamic Huffman tree for lengths.");
+		return;
+	}
+
+	// Build the Huffman tree (dynamic distances)
+	if ( !BuildHuffmanTree( &temp_bits_list[ lengths ], dists, env->huff_dyn_dist, env->use_trees, !env->use_trees, env->huffman_values ) )
+	{
+		if ( state.err_msg == 0 )
+			state.err_msg = LZ_ERRORMSG("Unable to build the dynamic Huffman tree for distances.");
+		return;
+	}
+}
+
+// Decodes Huffman coded data as long as there is enough input and output room left for
+// the longest symbol, without the per-symbol bounds checks of the careful path.
+// Returns 1 at the end of the block, 0 when the careful path needs to take over and -1 on error.
+static int InflateFast( LightZ_State &state, const LightZ_Huffman &huff_len, const LightZ_Huffman &huff_dist )
+{
+	const LZuint *len_table = huff_len.table;
+	const LZuint *dist_table = huff_dist.table;
+	const LZuint len_mask = (1 << huff_len.table_bits) - 1;
+	const LZuint dist_mask = (1 << huff_dist.table_bits) - 1;
+
+	if ( state.dest_size - *state.dest_pos < FAST_MIN_DEST )
+		return 0;
+
+	LZuchar *dest_start = *state.dest;
+	LZuchar *out_start = dest_start + *state.dest_pos;
+	LZuchar *out = out_start;
+	LZuchar *out_end = dest_start + state.dest_size - FAST_MIN_DEST;
+
+	int ret = 0;
+	while ( state.src_left >= FAST_MIN_SRC && out <= out_end )
+	{
+		// 56 bits is enough for length + extra bits + distance + extra bits
+		state.RefillFast();
+
+		// Read the length (or literal)
+		LZuint entry = len_table[ state.bit_buf & len_mask ];
+		if ( (entry >> 24) == HUFFENTRY_LINK )
+		{
+			state.bit_buf >>= huff_len.table_bits;
+			state.bit_count -= huff_len.table_bits;
+			entry = len_table[ (entry & 0xffff) + (state.bit_buf & ((1 << ((entry >> 16) & 0xff)) - 1)) ];
+		}
+		if ( (entry >> 24) != HUFFENTRY_VALUE )
+		{
+			state.err_msg = LZ_ERRORMSG("Invalid Huffman length code!");
+			ret = -1;
+			break;
+		}
+		state.bit_buf >>= (entry >> 16) & 0xff;
+		state.bit_count -= (entry >> 16) & 0xff;
+
+		int len = entry & 0xffff;
+		if ( len <= 0xff )
+		{ // Literal
+			*out++ = (LZuchar) len;
+
+			// Literals often come in runs; the buffer has room for a second one without a refill
+			entry = len_table[ state.bit_buf & len_mask ];
+			if ( (entry >> 24) == HUFFENTRY_VALUE && (entry & 0xffff) <= 0xff )
+			{
+				state.bit_buf >>= (entry >> 16) & 0xff;
+				state.bit_count -= (entry >> 16) & 0xff;
+				*out++ = (LZuchar) entry;
+			}
+			continue;
+		}
+		if ( len == 256 )
+		{ // End of block
+			ret = 1;
+			break;
+		}
+
+		// Get the real length
+		int extra = g_len_extra[ len - 257 ];
+		len = g_len_base[ len - 257 ] + (int)( state.bit_buf & ((1 << extra) - 1) );
+		state.bit_buf >>= extra;
+		state.bit_count -= extra;
+
+		// Get the distance
+		entry = dist_table[ state.bit_buf & dist_mask ];
+		if ( (entry >> 24) == HUFFENTRY_LINK )
+		{
+			state.bit_buf >>= huff_dist.table_bits;
+			state.bit_count -= huff_dist.table_bits;
+			entry = dist_table[ (entry & 0xffff) + (state.bit_buf & ((1 << ((entry >> 16) & 0xff)) - 1)) ];
+		}
+		if ( (entry >> 24) != HUFFENTRY_VALUE )
+		{
+			state.err_msg = LZ_ERRORMSG("Invalid Huffman distance code!");
+			ret = -1;
+			break;
+		}
+		state.bit_buf >>= (entry >> 16) & 0xff;
+		state.bit_count -= (entry >> 16) & 0xff;
+
+		int dist = entry & 0xffff;
+		extra = g_dist_extra[ dist ];
+		dist = g_dist_base[ dist ] + (int)( state.bit_buf & ((1 << extra) - 1) );
+		state.bit_buf >>= extra;
+		state.bit_count -= extra;
+
+		if ( dist <= 0 || len <= 0 )
+			continue;
+		if ( dist > out - dest_start )
+		{
+			state.err_msg = LZ_ERRORMSG("Unable to refer outside the unpacked data boundary!");
+			ret = -1;
+			break;
+		}
+
+		// Copy len bytes from dist bytes earlier
+		out = CopyMatch( out, dist, len );
+	}
+
+	// Update the position for everything written
+	*state.dest_pos = (int)( out - dest_start );
+
+	return ret;
+}
+
+// Reads a block header: BFINAL, BTYPE and then either LEN/NLEN of an uncompressed block or
+// the Huffman tables to use. Returns BTYPE (-1 on error).
+static int ReadBlockHeader( LightZ_State &state, bool &final, int &stored_len,
+	const LightZ_Huffman *&huff_len, const LightZ_Huffman *&huff_dist )
+{
+	final = (state.ReadBits( 1 ) == 0) ? false : true;
+	int BTYPE = state.ReadBits( 2 );
+
+	if ( BTYPE == 0 )
+	{ // No compression
+		// Skip partial bits
+		state.AlignToByte();
+
+		// Read LEN and NLEN
+		int LEN = state.ReadAligned();
+		LEN |= state.ReadAligned() << 8;
+		int NLEN = state.ReadAligned();
+		NLEN |= state.ReadAligned() << 8;
+
+		if ( LEN != ((~NLEN) & 0xffff) )
+		{
+			if ( state.err_msg == 0 )
+				state.err_msg = LZ_ERRORMSG("Invalid LEN/NLEN pair in uncompressed data!");
+			return -1;
+		}
+
+		stored_len = LEN;
+	}
+	else if ( BTYPE != 3 )
+	{ // Fixed(1)/Dynamic(2) Huffman codes
+		huff_len = &state.env->huff_pre_len;
+		huff_dist = &state.env->huff_pre_dist;
+
+		// Do we have a dynamic Huffman table?
+		if ( BTYPE == 2 )
+		{
+			UnpackDynamicHuffman( state );
+
+			huff_len = &state.env->huff_dyn_len;
+			huff_dist = &state.env->huff_dyn_dist;
+		}
+	}
+	else
+	{ // Reserved (error)
+		if ( state.err_msg == 0 )
+			state.err_msg = LZ_ERRORMSG("Invalid compressed block BTYPE!");
+		return -1;
+	}
+
+	if ( state.err_msg != 0 )
+		return -1;
+	return BTYPE;
+}
+
+// Decodes Huffman coded data up to the end of the block. Before each code the careful path
+// stops (returning 0) if there are less than min_src_bits of input or min_dest bytes of
+// destination room left; the stream uses these to stop where it can resume.
+// Returns 1 at the end of the block, 0 when stopped and -1 on error.
+static int InflateCodes( LightZ_State &state, const LightZ_Huffman &huff_len, const LightZ_Huffman &huff_dist,
+	int min_src_bits, int min_dest )
+{
+	// The fast loop needs the lookup tables and a destination it can write to freely
+	bool fast = !state.env->use_trees && !state.src_and_dest_overlap;
+
+	while ( state.err_msg == 0 )
+	{
+		// Decode the bulk of the data in the fast loop, finish near the buffer ends here
+		if ( fast )
+		{
+			int ret = InflateFast( state, huff_len, huff_dist );
+			if ( ret != 0 )
+				return ret;
+		}
+
+		if ( !state.HasBits( min_src_bits ) || state.dest_size - *state.dest_pos < min_dest )
+			return 0;
+
+		// Read the length (or literal)
+		int len = state.ReadHuffman( huff_len );
+		if ( len == -1 )
+		{
+			if ( state.err_msg == 0 )
+				state.err_msg = LZ_ERRORMSG("Invalid Huffman length code!");
+			return -1;
+		}
+
+		// Process the code
+		if ( len <= 0xff )
+		{ // Literal
+			state.Write( (LZuchar) len );
+		}
+		else if ( len == 256 )
+		{ // End of block
+			return 1;
+		}
+		else
+		{ // Length
+			// Get the real length
+			len = g_len_base[ len - 257 ] + state.ReadBits( g_len_extra[ len - 257 ] );
+
+			// Get the distance
+			int dist = state.ReadHuffman( huff_dist );
+			if ( dist < 0 )
+			{
+				if ( state.err_msg == 0 )
+					state.err_msg = LZ_ERRORMSG("Invalid Huffman distance code!");
+				return -1;
+			}
+			dist = g_dist_base[ dist ] + state.ReadBits( g_dist_extra[ dist ] );
+
+			// Copy len bytes from dist bytes earlier
+			state.WriteBack( dist, len );
+		}
+	}
+
+	return -1;
+}
+
+// Inflates one block of data. Return false if this is the last block.
+static bool InflateBlock( LightZ_State &state )
+{
+	bool BFINAL = true;
+	int stored_len = 0;
+	const LightZ_Huffman *huff_len = 0;
+	const LightZ_Huffman *huff_dist = 0;
+
+	int BTYPE = ReadBlockHeader( state, BFINAL, stored_len, huff_len, huff_dist );
+	if ( BTYPE == 0 )
+	{ // Copy LEN bytes to output
+		state.WriteStored( stored_len );
+	}
+	else if ( BTYPE > 0 )
+	{
+		InflateCodes( state, *huff_len, *huff_dist, 0, 0 );
+	}
+
+	return !BFINAL;
+}
+
+// Allocates a new LightZ environment
+LightZ_Env *ZFN(NewEnv)()
+{
+	return new LightZ_Env();
+}
+
+// Deallocates a LightZ environment
+void ZFN(DeleteEnv)( LightZ_Env *env )
+{
+	if ( env != 0 ) delete env;
+}
+
+// Deallocates a LightZ environment (the original name of DeleteEnv)
+void ZFN(NewEnv)( LightZ_Env *env )
+{
+	ZFN(DeleteEnv)( env );
+}
+
+// Selects the Huffman decoding method for the environment
+void ZFN(UseHuffmanTrees)( LightZ_Env *env, bool use_trees )
+{
+	if ( env != 0 ) env->use_trees = use_trees;
+}
+
+// Inflates the given source data.
+// Params:
+//  source        - The source data pointer (non-null if source_len > 0)
+//  source_len    - Length of the source data
+//  dest          - Pointer to the destination data area.
+//                  If the destination needs enlargement, the old pointer is delete []:d away.
+//  dest_len      - Pointer to the current destination data area size.
+//                  The value will be updated to contain the new unpacked data size.
+//  env           - The optional memory environment
+//  trusted       - If set, the Adler32 checksums are neither calculated nor tested
+// If everything was ok, return null. Otherwise the return value is the error message.
+const char *ZFN(Inflate)(
+	const void *source, int source_len,
+	unsigned char **dest, int *dest_len,
+	LightZ_Env *env, bool trusted )
+{
+	// Basic checks
+	if ( dest == 0 )
+	{
+		const char *temp = LZ_ERRORMSG("Destination buffer pointer is null!");
+		return temp;
+	}
+	if ( dest_len == 0 )
+	{
+		const char *temp = LZ_ERRORMSG("Destination buffer length pointer is null!");
+		return temp;
+	}
+	if ( *dest_len < 0 )
+	{
+		const char *temp = LZ_ERRORMSG("Negative destination buffer lengths are invalid!");
+		return temp;
+	}
+
+	if ( source_len < 0 )
+	{
+		const char *temp = LZ_ERRORMSG("Invalid source data length (<0)!");
+		return temp;
+	}
+	if ( source == 0 || source_len == 0 )
+	{
+		*dest_len = 0;
+		if ( source_len > 0 )
+		{
+			const char *temp = LZ_ERRORMSG("Source length is >0 but the source data pointer is null!");
+			return temp;
+		}
+		return 0;
+	}
+
+	if ( source_len < 8 )
+	{
+		const char *temp = LZ_ERRORMSG("Source length is too small (<8) to hold valid packed data!");
+		return temp;
+	}
+
+	// Create the environment (if needed)
+	LightZ_Env_Guard env_guard;
+
+	if ( env == 0 )
+	{
+		env = new LightZ_Env();
+		env_guard.ptr = env;
+	}
+
+	// Init the unpack state
+	LightZ_State state;
+	state.env = env;
+
+	state.src = (const LZuchar *) source;
+	state.src_left = source_len;
+
+	state.dest = dest;
+	state.dest_pos = dest_len;
+	state.dest_size = *dest_len;
+	state.verify = !trusted;
+
+	*state.dest_pos = 0;
+
+	// Check if source and destination overlap
+	if ( *dest != 0 )
+	{
+		const LZuchar *ptr = (const LZuchar *) *dest;
+		int len = state.dest_size;
+		state.src_and_dest_overlap = !((ptr+len)<=state.src || (state.src+state.src_left)<=ptr);
+	}
+
+	// Parse the CMF header
+	LZuchar CMF = state.Read();
+	LZuchar CM = CMF & 0x0f;
+	LZuchar CINFO = (CMF >> 4) & 0x0f;
+
+	if ( CM != 8 )
+	{
+		const char *temp = LZ_ERRORMSG("Unknown compression method (only deflate/inflate is supported)!");
+		return temp;
+	}   
+	if ( CINFO > 7 )
+	{
+		const char *temp = LZ_ERRORMSG("Too big LZ77 window size!");
+		return temp;
+	}   
+	
+	state.window_size = 1 << (8 + CINFO);
+
+	// Parse the FLG header
+	LZuchar FLG = state.Read();
+	LZuchar FDICT = (FLG >> 5) & 1;
+
+	// Test the header checksum
+	if ( (((CMF<<8) | FLG) % 31) != 0 )
+	{
+		const char *temp = LZ_ERRORMSG("Header checksum error!");
+		return temp;
+	}   
+
+	// Uncompress the dictionary (if any)
+	int dict_size = 0;
+	if ( FDICT != 0 )
+	{
+		LZuint dict_id = state.Read() << 24;
+		dict_id |= state.Read() << 16;
+		dict_id |= state.Read() << 8;
+		dict_id |= state.Read() << 0;
+
+		// Unpack the dictionary
+		while ( state.err_msg == 0 )
+		{
+			bool more = InflateBlock( state );
+			state.UpdateChecksum();
+			if ( !more )
+				break;
+		}
+
+		if ( state.err_msg != 0 )
+			return state.err_msg;
+
+		if ( !trusted && dict_id != state.dest_adler32 )
+		{ // Invalid checksum
+			const char *temp = LZ_ERRORMSG("Invalid dictionary Adler32 checksum!");
+			return temp;
+		}
+
+		// Reset the dictionary changes
+		state.dest_adler32 = ADLER32_START;
+		dict_size = *state.dest_pos;
+	}
+
+	// Unpack the data (the checksum is updated after each block, while the data is still in the cache)
+	while ( state.err_msg == 0 )
+	{
+		bool more = InflateBlock( state );
+		state.UpdateChecksum();
+		if ( !more )
+			break;
+	}
+
+	if ( state.err_msg != 0 )
+		return state.err_msg;
+
+	// Remove the dictionary
+	if ( dict_size > 0 )
+	{
+		LZuchar *mem = *dest;
+		LZuchar *d = mem;
+		LZuchar *s = &mem[ dict_size ];
+
+		*dest_len -= dict_size;
+		int left = *dest_len;
+
+		while ( left-- > 0 )
+			*d++ = *s++;
+	}
+
+	// Should have at least 4 bytes left (adler32 checksum)
+	state.AlignToByte();
+	if ( state.AlignedLeft() < 4 )
+	{
+		const char *temp = LZ_ERRORMSG("Out of data error (checksum missing)!");
+		return temp;
+	}
+	LZuint adler32 = state.ReadAligned() << 24;
+	adler32 |= state.ReadAligned() << 16;
+	adler32 |= state.ReadAligned() << 8;
+	adler32 |= state.ReadAligned() << 0;
+
+	if ( !trusted && state.dest_adler32 != adler32 )
+	{
+		const char * temp = LZ_ERRORMSG("Adler32 checksum error!");
+		return temp;
+	}
+
+	// Too much data?
+//	if ( state.src_left > 0 )
+//		return LZ_ERRORMSG("Too much data; some left unused!");
+    
+	return 0;
+}
+
+///////////////////////////////////
+// Streaming inflate
+
+enum LightZ_StreamMode
+{
+	StreamMode_Header,		// zlib header
+	StreamMode_Block,		// Next block header
+	StreamMode_Stored,		// Inside an uncompressed block
+	StreamMode_Codes,		// Inside a Huffman coded block
+	StreamMode_Checksum,	// Adler32 after the last block
+	StreamMode_Done
+};
+
+struct LightZ_Stream
+{
+	LightZ_Env_Guard env_guard;
+	LightZ_State state;
+
+	LightZ_OutputFunc output_func;
+	void *user;
+
+	// The output buffer; the data before flushed_pos has been passed on already
+	LZuchar *buffer;
+	int buffer_pos;
+	int flushed_pos;
+
+	// Input left over from the previous call (too little to decode without more)
+	LZuchar carry[ STREAM_CARRY_SIZE ];
+	int carry_len;
+
+	// Where in the stream we are
+	LightZ_StreamMode mode;
+	bool final_block;
+	int stored_left;
+	const LightZ_Huffman *huff_len;
+	const LightZ_Huffman *huff_dist;
+
+	LightZ_Stream()
+		: output_func( 0 )
+		, user( 0 )
+		, buffer( 0 )
+		, buffer_pos( 0 )
+		, flushed_pos( 0 )
+		, carry_len( 0 )
+		, mode( StreamMode_Header )
+		, final_block( false )
+		, stored_left( 0 )
+		, huff_len( 0 )
+		, huff_dist( 0 )
+	{ }
+
+	~LightZ_Stream()
+	{
+		delete [] buffer;
+	}
+};
+
+// Passes the new output on and, if there is less than room bytes of space left, slides
+// the buffer back so that only the window is kept
+static void StreamFlush( LightZ_Stream &stream, int room )
+{
+	LightZ_State &state = stream.state;
+
+	state.UpdateChecksum();
+	if ( stream.buffer_pos > stream.flushed_pos )
+	{
+		stream.output_func( stream.user, &stream.buffer[ stream.flushed_pos ], stream.buffer_pos - stream.flushed_pos );
+		stream.flushed_pos = stream.buffer_pos;
+	}
+
+	if ( STREAM_BUFFER_SIZE - stream.buffer_pos < room && stream.buffer_pos > STREAM_WINDOW )
+	{
+		memmove( stream.buffer, &stream.buffer[ stream.buffer_pos - STREAM_WINDOW ], STREAM_WINDOW );
+		stream.buffer_pos = STREAM_WINDOW;
+		stream.flushed_pos = STREAM_WINDOW;
+		state.dest_adler32_pos = STREAM_WINDOW;
+	}
+}
+
+// Decodes the current input as far as it goes. Unless last is set, stops before anything
+// that might need more input than there is.
+static void StreamDecode( LightZ_Stream &stream, bool last )
+{
+	LightZ_State &state = stream.state;
+
+	while ( state.err_msg == 0 )
+	{
+		switch ( stream.mode )
+		{
+		case StreamMode_Header:
+			{
+				if ( !last && !state.HasBits( 16 ) )
+					return;
+
+				LZuchar CMF = (LZuchar) state.ReadBits( 8 );
+				LZuchar FLG = (LZuchar) state.ReadBits( 8 );
+
+				if ( (CMF & 0x0f) != 8 )
+					state.err_msg = LZ_ERRORMSG("Unknown compression method (only deflate/inflate is supported)!");
+				else if ( ((CMF >> 4) & 0x0f) > 7 )
+					state.err_msg = LZ_ERRORMSG("Too big LZ77 window size!");
+				else if ( (((CMF<<8) | FLG) % 31) != 0 )
+					state.err_msg = LZ_ERRORMSG("Header checksum error!");
+				else if ( ((FLG >> 5) & 1) != 0 )
+					state.err_msg = LZ_ERRORMSG("Preset dictionaries are not supported when streaming!");
+
+				stream.mode = StreamMode_Block;
+			}
+			break;
+
+		case StreamMode_Block:
+			{
+				if ( !last && !state.HasBits( STREAM_HEADER_MARGIN * 8 ) )
+					return;
+
+				int BTYPE = ReadBlockHeader( state, stream.final_block, stream.stored_left, stream.huff_len, stream.huff_dist );
+				if ( BTYPE == 0 )
+					stream.mode = StreamMode_Stored;
+				else if ( BTYPE > 0 )
+					stream.mode = StreamMode_Codes;
+			}
+			break;
+
+		case StreamMode_Stored:
+			{
+				if ( stream.stored_left <= 0 )
+				{
+					stream.mode = stream.final_block ? StreamMode_Checksum : StreamMode_Block;
+					break;
+				}
+
+				if ( stream.buffer_pos == STREAM_BUFFER_SIZE )
+					StreamFlush( stream, 1 );
+
+				int len = stream.stored_left;
+				if ( len > STREAM_BUFFER_SIZE - stream.buffer_pos )
+					len = STREAM_BUFFER_SIZE - stream.buffer_pos;
+				if ( len > state.AlignedLeft() )
+					len = state.AlignedLeft();
+
+				if ( len <= 0 )
+				{
+					if ( last )
+						state.err_msg = LZ_ERRORMSG("Out of source data (EOS)!");
+					return;
+				}
+
+				state.WriteStored( len );
+				stream.stored_left -= len;
+			}
+			break;
+
+		case StreamMode_Codes:
+			{
+				int ret = InflateCodes( state, *stream.huff_len, *stream.huff_dist, last ? 0 : STREAM_CODE_MARGIN * 8, FAST_MIN_DEST );
+				if ( ret > 0 )
+					stream.mode = stream.final_block ? StreamMode_Checksum : StreamMode_Block;
+				else if ( ret == 0 )
+				{
+					if ( STREAM_BUFFER_SIZE - stream.buffer_pos >= FAST_MIN_DEST )
+						return; // Needs more input
+					StreamFlush( stream, FAST_MIN_DEST );
+				}
+			}
+			break;
+
+		case StreamMode_Checksum:
+			{
+				state.AlignToByte();
+				if ( state.AlignedLeft() < 4 )
+				{
+					if ( last )
+						state.err_msg = LZ_ERRORMSG("Out of data error (checksum missing)!");
+					return;
+				}
+
+				LZuint adler32 = state.ReadAligned() << 24;
+				adler32 |= state.ReadAligned() << 16;
+				adler32 |= state.ReadAligned() << 8;
+				adler32 |= state.ReadAligned() << 0;
+
+				state.UpdateChecksum();
+				if ( state.verify && state.dest_adler32 != adler32 )
+					state.err_msg = LZ_ERRORMSG("Adler32 checksum error!");
+
+				stream.mode = StreamMode_Done;
+			}
+			break;
+
+		case StreamMode_Done:
+			return;
+		}
+	}
+}
+
+// Allocates a new streaming inflater
+LightZ_Stream *ZFN(NewStream)( LightZ_OutputFunc output_func, void *user, LightZ_Env *env, bool trusted )
+{
+	if ( output_func == 0 )
+		return 0;
+
+	LightZ_Stream *stream = new LightZ_Stream();
+	if ( stream == 0 )
+		return 0;
+
+	if ( env == 0 )
+	{
+		env = new LightZ_Env();
+		stream->env_guard.ptr = env;
+	}
+
+	stream->output_func = output_func;
+	stream->user = user;
+	stream->buffer = new LZuchar[ STREAM_BUFFER_SIZE ];
+
+	LightZ_State &state = stream->state;
+	state.env = env;
+	state.verify = !trusted;
+	state.dest = &stream->buffer;
+	state.dest_pos = &stream->buffer_pos;
+	state.dest_size = STREAM_BUFFER_SIZE;
+	state.window_size = STREAM_WINDOW;
+
+	return stream;
+}
+
+// Deallocates a streaming inflater
+void ZFN(DeleteStream)( LightZ_Stream *stream )
+{
+	if ( stream != 0 ) delete stream;
+}
+
+// Inflates the next piece of the compressed data
+const char *ZFN(StreamInflate)( LightZ_Stream *stream, const void *source, int source_len, bool last )
+{
+	if ( stream == 0 )
+	{
+		const char *temp = LZ_ERRORMSG("The stream is null!");
+		return temp;
+	}
+	if ( source_len < 0 || (source == 0 && source_len > 0) )
+	{
+		const char *temp = LZ_ERRORMSG("Invalid source data!");
+		return temp;
+	}
+
+	LightZ_State &state = stream->state;
+	const LZuchar *src = (const LZuchar *) source;
+	int left = source_len;
+
+	// Finish the input left over from the last call first, topped up with the new data.
+	// Once the decoding gets past the old bytes it continues in the new data directly.
+	while ( stream->carry_len > 0 && stream->mode != StreamMode_Done && state.err_msg == 0 )
+	{
+		int old_len = stream->carry_len;
+		int add = STREAM_CARRY_SIZE - old_len;
+		if ( add > left )
+			add = left;
+		if ( add > 0 )
+			memcpy( &stream->carry[ old_len ], src, add );
+
+		state.src = stream->carry;
+		state.src_left = old_len + add;
+		StreamDecode( *stream, last && add == left );
+
+		int used = (int)( state.src - stream->carry );
+		if ( used >= old_len )
+		{
+			src += used - old_len;
+			left -= used - old_len;
+			stream->carry_len = 0;
+		}
+		else
+		{
+			stream->carry_len = old_len + add - used;
+			memmove( stream->carry, &stream->carry[ used ], stream->carry_len );
+			src += add;
+			left -= add;
+			if ( left <= 0 )
+				break;
+		}
+	}
+
+	// Then the new data, keeping what can't be decoded yet (less than a block header)
+	if ( stream->carry_len == 0 && stream->mode != StreamMode_Done && state.err_msg == 0 )
+	{
+		state.src = src;
+		state.src_left = left;
+		StreamDecode( *stream, last );
+
+		if ( state.err_msg == 0 && stream->mode != StreamMode_Done && state.src_left > 0 )
+		{
+			memcpy( stream->carry, state.src, state.src_left );
+			stream->carry_len = state.src_left;
+		}
+	}
+
+	// The source is gone after this call; drop the read ahead bits (see RefillFast)
+	state.src = 0;
+	state.src_left = 0;
+	if ( state.bit_count < 64 )
+		state.bit_buf &= ((LZuint64) 1 << state.bit_count) - 1;
+
+	if ( state.err_msg == 0 )
+		StreamFlush( *stream, 0 );
+
+	if ( last && state.err_msg == 0 && stream->mode != StreamMode_Done )
+		state.err_msg = LZ_ERRORMSG("Out of source data (EOS)!");
+
+	return state.err_msg;
+}
+
+// Returns true once the whole stream has been inflated
+bool ZFN(StreamDone)( const LightZ_Stream *stream )
+{
+	return stream != 0 && stream->mode == StreamMode_Done;
+}
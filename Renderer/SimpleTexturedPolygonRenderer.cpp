@@ -1,157 +1,345 @@
-#include "SimpleTexturedPolygonRenderer.h"
-#include "primitives.h"
-#include "LightPng/LightPng.h"
-#include "LightPng/LightZ.h"
-#include <cstdio>
-#include <cstdlib>
-#include <ctime>
-
-using namespace Quokka3D;
-
-SimpleTexturedPolygonRenderer::SimpleTexturedPolygonRenderer(const Transform3D& camera, 
-                                                             const ViewWindow& viewWindow, 
-                                                             const std::string& textureFile)
-{
-    init(camera, viewWindow, true); 
-    m_a = Vector3D();
-    m_b = Vector3D();
-    m_c = Vector3D();
-    m_viewPos = Vector3D();
-    m_textureBounds = Rectangle3D();
-    // m_texture = NULL;
-    m_texture = loadTexture(textureFile);
-
-}
-
-
-// Reads a file fully (return null on error)
-char* SimpleTexturedPolygonRenderer::ReadFile( const char *fn, int &dest_size )
-{
-	FILE *f = fopen( fn, "rb" );
-	if ( f == 0 )
-		return 0;
-
-	fseek( f, 0, SEEK_END );
-	dest_size = ftell( f );
-	fseek( f, 0, SEEK_SET );
-
-	char *data = new char[ dest_size + 1 ];
-	if ( fread( data, 1, dest_size, f ) != dest_size )
-	{
-		delete [] data;
-		data = 0;
-	}
-	fclose( f );
-
-	return data;  // caller must delete data with delete[]
-}
-
-
-LPNG_Image* SimpleTexturedPolygonRenderer::loadTexture(const std::string& fileName)
-{
-    int source_len;
-    char *source = ReadFile(fileName.c_str(), source_len);
-	if ( source == 0 )
-	{
-        fprintf(stderr, "Error reading file %s\n", fileName.c_str());
-        exit(EXIT_FAILURE);
-	}
-
-    clock_t before = clock();
-
-	// Does all the hard work decompressing the png in memory
-	LPNG_Image *img = LPNG_Create( source, source_len );
-
-    double elapsed = clock() - before;
-
-    printf("PNG_Create()took %.3f seconds\n", elapsed/CLOCKS_PER_SEC);
-
-	if ( img == 0 )
-	{
-		fprintf(stderr, "Error creating PNG image from file %s\n", fileName.c_str());
-		exit(EXIT_FAILURE);
-	}
-
-	printf( "Image opened ok\n" );
-	printf( "Width : %d\n", img->width );
-	printf( "Height: %d\n", img->height );
-	printf( "Has palette: %s\n", img->has_palette ? "yes" : "no" );
-
-    delete[] source;
-
-    return img; // caller must delete memory
-
-}
-
-void SimpleTexturedPolygonRenderer::drawCurrentPolygon()
-{
-        // Calculate texture bounds.
-        // Ideally texture bounds are pre-calculated and stored
-        // with the polygon. Coordinates are computed here for
-        // demonstration purposes.
-
-        // These 3 vars are references because that's what they are
-        // in Brackeen's original Java code.
-        Vector3D& textureOrigin = m_textureBounds.getOrigin();
-        Vector3D& textureDirectionU = m_textureBounds.getDirectionU();
-        Vector3D& textureDirectionV = m_textureBounds.getDirectionV();
-
-        textureOrigin = (*m_sourcePolygon)[0];
-
-        textureDirectionU = (*m_sourcePolygon)[3];
-        textureDirectionU -= textureOrigin;
-        textureDirectionU.normalize();
-
-        textureDirectionV = (*m_sourcePolygon)[1];
-        textureDirectionV -= textureOrigin;
-        textureDirectionV.normalize();
-
-        // transform the texture bounds
-        m_textureBounds.subtract(m_camera);
-      
-
-        // start texture-mapping calculations
-        m_a.cross(m_textureBounds.getDirectionV(), m_textureBounds.getOrigin());
-        m_b.cross(m_textureBounds.getOrigin(), m_textureBounds.getDirectionU());
-        m_c.cross(m_textureBounds.getDirectionU(), m_textureBounds.getDirectionV());
-
-        int y = m_scanConverter.getTopBoundary();
-        m_viewPos.z = -m_viewWindow.getDistance();
-
-        unsigned char *data = m_texture->data;
-
-        while (y <= m_scanConverter.getBottomBoundary()) 
-        {
-            ScanConverter::Scan scan = m_scanConverter[y];
-
-            if (scan.isValid()) 
-            {
-                m_viewPos.y = m_viewWindow.convertFromScreenYToViewY(y);
-                for (int x=scan.left; x<=scan.right; x++) 
-                {
-                    m_viewPos.x = m_viewWindow.convertFromScreenXToViewX(x);
-
-                    // compute the texture location
-                    int tx = (int)(m_a.dot(m_viewPos) / m_c.dot(m_viewPos));
-                    int ty = (int)(m_b.dot(m_viewPos) / m_c.dot(m_viewPos));
-
-                    //printf("y = %d  x = %d  tx = %d  ty = %d\n", y, x, tx, ty); 
-
-                    // get the color to draw
-                    unsigned char *src_color = data + (ty * m_texture->width + tx) * PITCH;
-                    unsigned char a, r, g, b;
-                    a = *src_color++;
-                    r = *src_color++;
-                    g = *src_color++;
-                    b = *src_color++;
-
-                    TRUECOLOR color = MAKE_RGB32(r,g,b);
-
-                    // At last, after all that hard work, draw the pixel!
-                    plot_pixel(x, y, color);
-                }
-            }
-            y++;    // next scan line
-        }
-}
-    
+#include "SimpleTexturedPolygonRenderer.h"
+#include "primitives.h"
+#include "texture.h"
+#include "texturecache.h"
+#include "spankernels.h"
+#include "texturedpolygon3d.h"
+#include "LightPng/LightPng.h"
+#include "LightPng/LightZ.h"
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+using namespace Quokka3D;
+
+SimpleTexturedPolygonRenderer::SimpleTexturedPolygonRenderer(FrameBuffer& frameBuffer,
+                                                             const Transform3D& camera, 
+                                                             const ViewWindow& viewWindow, 
+                                                             const std::string& textureFile)
+{
+    init(frameBuffer, camera, viewWindow, true); 
+    m_a = Vector3D();
+    m_b = Vector3D();
+    m_c = Vector3D();
+    m_viewPos = Vector3D();
+    m_textureBounds = Rectangle3D();
+    m_subdivision = DEFAULT_SUBDIVISION;
+    m_mipMapping = true;
+    // m_texture = NULL;
+    setTexture(loadTexture(textureFile));
+
+}
+
+
+SimpleTexturedPolygonRenderer::SimpleTexturedPolygonRenderer(FrameBuffer& frameBuffer,
+                                                             const Transform3D& camera, 
+                                                             const ViewWindow& viewWindow, 
+                                                             const TextureHandle& texture)
+{
+    init(frameBuffer, camera, viewWindow, true); 
+    m_a = Vector3D();
+    m_b = Vector3D();
+    m_c = Vector3D();
+    m_viewPos = Vector3D();
+    m_textureBounds = Rectangle3D();
+    m_subdivision = DEFAULT_SUBDIVISION;
+    m_mipMapping = true;
+    setTexture(texture);
+}
+
+
+TextureHandle SimpleTexturedPolygonRenderer::loadTexture(const std::string& fileName)
+{
+    clock_t before = clock();
+
+    // renderers using the same file share one decoded copy
+    TextureHandle img = TextureCache::getDefault().get(fileName);
+
+    double elapsed = clock() - before;
+
+    printf("Texture load took %.3f seconds\n", elapsed/CLOCKS_PER_SEC);
+
+	if ( !img )
+	{
+		fprintf(stderr, "Error creating PNG image from file %s\n", fileName.c_str());
+		exit(EXIT_FAILURE);
+	}
+
+	printf( "Image opened ok\n" );
+	printf( "Width : %d\n", img->getWidth() );
+	printf( "Height: %d\n", img->getHeight() );
+
+    return img;
+
+}
+
+/*
+    Sets the texture drawn on polygons that don't have their own.
+*/
+void SimpleTexturedPolygonRenderer::setTexture(const TextureHandle& texture)
+{
+    m_texture = texture;
+    selectTexture(texture);
+}
+
+
+/*
+    Makes texture the one drawn, picking its texel addressing: shift/mask with
+    wrap around when both sides are powers of two, a multiply with clamping
+    otherwise.
+*/
+void SimpleTexturedPolygonRenderer::selectTexture(const TextureHandle& texture)
+{
+    m_currentTexture = texture;
+    m_textureShift = -1;
+    if (!texture)
+        return;
+
+    // sides up to 2^14 keep the 16.16 tile offsets well inside an int
+    int w = texture->getWidth();
+    int h = texture->getHeight();
+    if ((w & (w - 1)) == 0 && (h & (h - 1)) == 0 && w <= 16384 && h <= 16384)
+    {
+        m_textureShift = 0;
+        while ((1 << m_textureShift) < w)
+            m_textureShift++;
+    }
+}
+
+
+void SimpleTexturedPolygonRenderer::drawCurrentPolygon()
+{
+        // The texture bounds are stored with a TexturedPolygon3D, so only the
+        // move to camera space is left to do. Other polygons get the
+        // renderer's texture, laid on their vertices as calcTextureBounds would.
+        const TexturedPolygon3D* poly = dynamic_cast<const TexturedPolygon3D*>(m_sourcePolygon);
+        const TextureHandle& texture = (poly != NULL && poly->getTexture()) ? poly->getTexture() : m_texture;
+        if (!texture)
+            return;
+        if (texture != m_currentTexture)
+            selectTexture(texture);
+
+        if (poly != NULL)
+            m_textureBounds = poly->getTextureBounds();
+        else
+            m_textureBounds = TexturedPolygon3D::calcTextureBounds(*m_sourcePolygon, texture);
+        m_textureBounds.transform(m_objectToCamera);
+      
+
+        // start texture-mapping calculations
+        m_a.cross(m_textureBounds.getDirectionV(), m_textureBounds.getOrigin());
+        m_b.cross(m_textureBounds.getOrigin(), m_textureBounds.getDirectionU());
+        m_c.cross(m_textureBounds.getDirectionU(), m_textureBounds.getDirectionV());
+
+        int y = m_scanConverter.getTopBoundary();
+        m_viewPos.z = -m_viewWindow.getDistance();
+
+        int pixels = 0;
+        while (y <= m_scanConverter.getBottomBoundary()) 
+        {
+            ScanConverter::Scan scan = m_scanConverter[y];
+
+            if (scan.isValid()) 
+            {
+                drawSpan(y, scan.left, scan.right);
+                pixels += scan.right - scan.left + 1;
+            }
+            y++;    // next scan line
+        }
+        m_numPixels += pixels;
+}
+
+
+// 16.16 fixed point texture coordinates
+static const int FIXED_BITS = 16;
+static const float FIXED_ONE = (float)(1 << FIXED_BITS);
+static const int WRAP_LIMIT = 1 << 29;
+static const int EDGE_MARGIN = 1 << 10;
+
+
+/*
+    Converts a texture coordinate to 16.16 fixed point, limited to [min, max].
+*/
+static inline int toFixed(float f, int min, int max)
+{
+    // (float)max may round up past max, hence the second clamp
+    f = (f < (float)max) ? f : (float)max;
+    f = (f > (float)min) ? f : (float)min;
+    int fixed = (int)f;
+    return (fixed < max) ? fixed : max;
+}
+
+
+/*
+    Picks the mip level for a scan: the level where one pixel step, across or
+    down the screen, moves the texture location by about one texel. The
+    texture location is (a.p / c.p, b.p / c.p), so its change per pixel is
+    e.g. (a.x c.p - a.p c.x) / (c.p)^2 across for u. It is measured at the
+    middle of the scan.
+*/
+int SimpleTexturedPolygonRenderer::selectMipLevel(int y, int left, int right) const
+{
+    Vector3D p(m_viewWindow.convertFromScreenXToViewX((left + right) * 0.5f),
+               m_viewWindow.convertFromScreenYToViewY((float)y),
+               m_viewPos.z);
+    const float u = m_a.dot(p);
+    const float v = m_b.dot(p);
+    const float z = m_c.dot(p);
+
+    // the view y coordinate changes by -1 per scan, which doesn't change the lengths
+    const float zInverse2 = 1.0f / (z * z);
+    const float uAcross = (m_a.x * z - u * m_c.x) * zInverse2;
+    const float vAcross = (m_b.x * z - v * m_c.x) * zInverse2;
+    const float uDown = (m_a.y * z - u * m_c.y) * zInverse2;
+    const float vDown = (m_b.y * z - v * m_c.y) * zInverse2;
+    const float across = uAcross * uAcross + vAcross * vAcross;
+    const float down = uDown * uDown + vDown * vDown;
+
+    // texels per pixel squared: level n has 4^n times fewer
+    const float texels2 = (across > down) ? across : down;
+    const int lastLevel = m_currentTexture->getNumLevels() - 1;
+    int level = 0;
+    for (float limit = 4.0f; level < lastLevel && texels2 >= limit; limit *= 4.0f)
+        level++;
+    return level;
+}
+
+
+/*
+    Texture maps one scan. The texture location of a pixel is (a.p / c.p, b.p / c.p)
+    where p is the pixel's position on the view window. The three dot products
+    change by a constant amount from one pixel to the next, so they are stepped
+    along the scan, and the true (perspective correct) texture location is only
+    computed every m_subdivision pixels. Between those points the location is
+    stepped linearly in 16.16 fixed point, which is indistinguishable from the
+    exact result for short enough runs.
+*/
+void SimpleTexturedPolygonRenderer::drawSpan(int y, int left, int right)
+{
+    m_viewPos.x = m_viewWindow.convertFromScreenXToViewX((float)left);
+    m_viewPos.y = m_viewWindow.convertFromScreenYToViewY((float)y);
+
+    // The mip level's texture locations are the full size texture's scaled
+    // by its size. The levels of a power of two texture are powers of two too.
+    int mipLevel = 0;
+    if (m_mipMapping && m_currentTexture->getNumLevels() > 1)
+        mipLevel = selectMipLevel(y, left, right);
+    const Texture::Level level = m_currentTexture->getLevel(mipLevel);
+    const float scaleU = (mipLevel == 0) ? FIXED_ONE : FIXED_ONE * level.width / m_currentTexture->getWidth();
+    const float scaleV = (mipLevel == 0) ? FIXED_ONE : FIXED_ONE * level.height / m_currentTexture->getHeight();
+
+    // the dot products at the left end of the scan and their change per pixel
+    // (the view x coordinate grows by 1 per screen pixel)
+    const float u0 = m_a.dot(m_viewPos) * scaleU;
+    const float v0 = m_b.dot(m_viewPos) * scaleV;
+    const float z0 = m_c.dot(m_viewPos);
+    const float du = m_a.x * scaleU;
+    const float dv = m_b.x * scaleV;
+    const float dz = m_c.x;
+
+    // texels (or the palette entries of indexed textures) are already in the
+    // MAKE_RGB32 layout, so they are plotted as is
+    const TRUECOLOR* texels = level.texels;
+    const unsigned char* indices = level.indices;
+    const TRUECOLOR* palette = m_currentTexture->getPalette();
+    const int textureWidth = level.width;
+    const bool wrapped = (m_textureShift >= 0);
+
+    // Without wrap around the locations are clamped to the texture (exact ones
+    // stray at most a fraction of a texel outside it), 1/64 texel in from the
+    // edges since the rounded steps can overshoot the ends of a run slightly.
+    // Wrapped locations are kept to +-2^13 texels so the steps between them
+    // can't overflow.
+    const int maxU = wrapped ? WRAP_LIMIT : (level.width << FIXED_BITS) - EDGE_MARGIN;
+    const int maxV = wrapped ? WRAP_LIMIT : (level.height << FIXED_BITS) - EDGE_MARGIN;
+    const int minUV = wrapped ? -WRAP_LIMIT : EDGE_MARGIN;
+
+    // 16.16 masks of one tile of a wrapped texture, and v's shift and mask
+    // straight to the texel row
+    const int levelShift = (m_textureShift > mipLevel) ? m_textureShift - mipLevel : 0;
+    const int textureMaskU = wrapped ? level.width - 1 : 0;
+    const int textureMaskV = wrapped ? level.height - 1 : 0;
+    const int tileMaskU = (textureMaskU << FIXED_BITS) | 0xffff;
+    const int tileMaskV = (textureMaskV << FIXED_BITS) | 0xffff;
+    const int wrapShiftV = wrapped ? FIXED_BITS - levelShift : 0;
+    const int wrapMaskV = wrapped ? textureMaskV << levelShift : 0;
+
+    // tiled levels have their own addressing
+    const TexturedRunFunc drawRun = level.tiled ? m_spanKernels->drawRunTiled : m_spanKernels->drawRun;
+
+    TRUECOLOR* row = m_frameBuffer->getRow(y);
+    const float subdivisionInverse = 1.0f / m_subdivision;
+
+    int u = toFixed(u0 / z0, minUV, maxU);
+    int v = toFixed(v0 / z0, minUV, maxV);
+    int x = left;
+    for (;;)
+    {
+        // the run ends at the next subdivision point or the last pixel of the scan
+        int count = right - x;
+        if (count > m_subdivision)
+            count = m_subdivision;
+
+        // the true texture location at the end of the run (stepped from the left
+        // end of the scan rather than the last run, so errors don't accumulate)
+        int uEnd = u;
+        int vEnd = v;
+        int uStep = 0;
+        int vStep = 0;
+        if (count > 0)
+        {
+            const float steps = (float)(x + count - left);
+            const float zInverse = 1.0f / (z0 + dz * steps);
+            uEnd = toFixed((u0 + du * steps) * zInverse, minUV, maxU);
+            vEnd = toFixed((v0 + dv * steps) * zInverse, minUV, maxV);
+
+            const float countInverse = (count == m_subdivision) ? subdivisionInverse : 1.0f / count;
+            uStep = (int)((float)(uEnd - u) * countInverse);
+            vStep = (int)((float)(vEnd - v) * countInverse);
+        }
+
+        // the last run also draws the last pixel of the scan
+        const int drawn = (x + count == right) ? count + 1 : count;
+        TRUECOLOR* dest = row + x;
+
+        // Move a wrapped run to the first repeat of the texture. Most runs then
+        // stay inside it and don't need the masks.
+        int uStart = u;
+        int vStart = v;
+        bool masked = false;
+        if (wrapped)
+        {
+            const int uTile = u & tileMaskU;
+            const int vTile = v & tileMaskV;
+            const int uLast = uTile + uStep * (drawn - 1);
+            const int vLast = vTile + vStep * (drawn - 1);
+            masked = !(((uLast | vLast) >= 0) && uLast <= tileMaskU && vLast <= tileMaskV);
+            if (!masked)
+            {
+                uStart = uTile;
+                vStart = vTile;
+            }
+        }
+
+        if (indices != 0)
+        {
+            if (!masked)
+                m_spanKernels->drawRunIndexed(dest, drawn, uStart, vStart, uStep, vStep, indices, textureWidth, palette);
+            else
+                m_spanKernels->drawRunIndexedWrapped(dest, drawn, u, v, uStep, vStep, indices, wrapShiftV, textureMaskU, wrapMaskV, palette);
+        }
+        else if (!masked)
+            drawRun(dest, drawn, uStart, vStart, uStep, vStep, texels, textureWidth);
+        else if (level.tiled)
+            m_spanKernels->drawRunTiledWrapped(dest, drawn, u, v, uStep, vStep, texels, levelShift, textureMaskU, textureMaskV);
+        else
+            m_spanKernels->drawRunWrapped(dest, drawn, u, v, uStep, vStep, texels, wrapShiftV, textureMaskU, wrapMaskV);
+
+        x += count;
+        if (x == right)
+            break;
+        u = uEnd;
+        v = vEnd;
+    }
+}
+    
@@ -1,43 +1,74 @@
-#ifndef SimpleTexturedPolygonRenderer_h
-#define SimpleTexturedPolygonRenderer_h
-
-#include "polygonrenderer.h"
-#include "rectangle3D.h"
-#include "LightPng/LightPng.h"
-#include "LightPng/LightZ.h"
-
-namespace Quokka3D
-{
-    
-    class SimpleTexturedPolygonRenderer : public PolygonRenderer
-    {
-    public:
-        SimpleTexturedPolygonRenderer() {}
-        SimpleTexturedPolygonRenderer(const Transform3D& camera, 
-                                      const ViewWindow& viewWindow,
-                                      const std::string& textureFile);
-        
-        ~SimpleTexturedPolygonRenderer() { delete m_texture; }
-
-        LPNG_Image* loadTexture(const std::string& fileName);
-        
-    private:
-        char* ReadFile( const char *fn, int &dest_size );
-
-
-    protected:
-        void drawCurrentPolygon();
-    	
-    private:
-        Vector3D m_a, m_b, m_c;
-        Vector3D m_viewPos;
-        Rectangle3D m_textureBounds;
-        LPNG_Image *m_texture;            // a pointer to the texture data bits
-
-        
-
-    };
-
-} // Quokka3D
-
+#ifndef SimpleTexturedPolygonRenderer_h
+#define SimpleTexturedPolygonRenderer_h
+
+#include "polygonrenderer.h"
+#include "rectangle3D.h"
+#include "texture.h"
+#include "texturecache.h"
+#include "spankernels.h"
+#include "LightPng/LightPng.h"
+#include "LightPng/LightZ.h"
+
+namespace Quokka3D
+{
+    
+    class SimpleTexturedPolygonRenderer : public PolygonRenderer
+    {
+    public:
+        SimpleTexturedPolygonRenderer() : m_subdivision(DEFAULT_SUBDIVISION), m_mipMapping(true), m_textureShift(-1) {}
+        SimpleTexturedPolygonRenderer(FrameBuffer& frameBuffer,
+                                      const Transform3D& camera, 
+                                      const ViewWindow& viewWindow,
+                                      const std::string& textureFile);
+
+        // Uses an already loaded texture (e.g. from a TextureLoader or TextureCache)
+        SimpleTexturedPolygonRenderer(FrameBuffer& frameBuffer,
+                                      const Transform3D& camera, 
+                                      const ViewWindow& viewWindow,
+                                      const TextureHandle& texture);
+
+        TextureHandle loadTexture(const std::string& fileName);     // through the default TextureCache
+
+        // The texture for polygons without one of their own. Textures whose sides
+        // are powers of two are addressed with shifts and masks and tile (wrap
+        // around); others are addressed with a multiply and clamped to their edges.
+        // Indexed textures are drawn through their palette.
+        void setTexture(const TextureHandle& texture);
+        const TextureHandle& getTexture() const { return m_texture; }
+        bool isTextureWrapped() const { return m_textureShift >= 0; }     // for the last texture drawn
+
+        // The perspective correct texture location is computed every this many
+        // pixels along a scan and interpolated linearly in between.
+        static const int DEFAULT_SUBDIVISION = 16;
+        void setSubdivision(int pixels) { m_subdivision = (pixels < 1) ? 1 : pixels; }
+        int getSubdivision() const { return m_subdivision; }
+
+        // Each scan of a mip mapped texture is drawn from the mip level with
+        // about one texel per pixel, picked from how fast the texture location
+        // changes across and down the screen at the middle of the scan.
+        void setMipMapping(bool on) { m_mipMapping = on; }
+        bool isMipMapping() const { return m_mipMapping; }
+
+    protected:
+        void drawCurrentPolygon();     // a TexturedPolygon3D, or any polygon with the renderer's texture
+        void drawSpan(int y, int left, int right);
+        void selectTexture(const TextureHandle& texture);
+        int selectMipLevel(int y, int left, int right) const;
+    	
+    private:
+        Vector3D m_a, m_b, m_c;
+        Vector3D m_viewPos;
+        Rectangle3D m_textureBounds;
+        TextureHandle m_texture;          // the texture data bits, shared with other users
+        TextureHandle m_currentTexture;   // the texture being drawn, m_texture or the polygon's
+        int m_subdivision;                // pixels between perspective divides
+        bool m_mipMapping;                // draw from the mip maps of textures that have them
+        int m_textureShift;               // log2 of the current texture's width, -1 if not a power of two
+
+        
+
+    };
+
+} // Quokka3D
+
 #endif // SimpleTexturedPolygonRenderer_h
\ No newline at end of file
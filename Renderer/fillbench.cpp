@@ -0,0 +1,171 @@
+// fillbench.cpp : Measures the solid fill rate over the whole screen: pixel by
+// pixel with plot_pixel, with line_horiz, with line_fast along the rows and down
+// the columns, with cls, with each level of span fill kernels (plain and
+// streaming stores), and through SolidPolygonRenderer with a polygon covering
+// the screen.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+#include "vector3d.h"
+#include "primitives.h"
+#include "framebuffer.h"
+#include "viewwindow.h"
+#include "spankernels.h"
+#include "solidpolygon3d.h"
+#include "solidpolygonrenderer.h"
+
+using namespace Quokka3D;
+
+const int width = 640;
+const int height = 480;
+
+MemoryFrameBuffer frameBuffer(width, height);      // drawn to, never shown
+
+static const int FRAMES = 500;
+
+
+// The screen's pixels per second for frames drawn by drawFrame, the best of
+// three tries
+template <class DrawFrame>
+static double measureFillRate(DrawFrame drawFrame)
+{
+    double best = 0;
+    for (int repeat=0; repeat<3; repeat++)
+    {
+        clock_t before = clock();
+        for (int i=0; i<FRAMES; i++)
+            drawFrame(MAKE_RGB32(i, 255 - i, 128));
+        double seconds = (double)(clock() - before) / CLOCKS_PER_SEC;
+
+        if (seconds > 0 && (double)width * height * FRAMES / seconds > best)
+            best = (double)width * height * FRAMES / seconds;
+    }
+    return best;
+}
+
+
+struct PlotPixels
+{
+    void operator()(TRUECOLOR color) const
+    {
+        for (int y=0; y<height; y++)
+            for (int x=0; x<width; x++)
+                frameBuffer.plot_pixel(x, y, color);
+    }
+};
+
+
+struct LineHoriz
+{
+    void operator()(TRUECOLOR color) const
+    {
+        for (int y=0; y<height; y++)
+            frameBuffer.line_horiz(0, width - 1, y, color);
+    }
+};
+
+
+// Bresenham lines along the rows and down the columns
+struct LineFastRows
+{
+    void operator()(TRUECOLOR color) const
+    {
+        for (int y=0; y<height; y++)
+            frameBuffer.line_fast(0, y, width - 1, y, color);
+    }
+};
+
+
+struct LineFastColumns
+{
+    void operator()(TRUECOLOR color) const
+    {
+        for (int x=0; x<width; x++)
+            frameBuffer.line_fast(x, 0, x, height - 1, color);
+    }
+};
+
+
+struct Cls
+{
+    void operator()(TRUECOLOR) const
+    {
+        frameBuffer.cls();
+    }
+};
+
+
+struct FillRuns
+{
+    FillRunFunc fillRun;
+
+    void operator()(TRUECOLOR color) const
+    {
+        for (int y=0; y<height; y++)
+            fillRun(frameBuffer.getRow(y), width, color);
+    }
+};
+
+
+struct DrawPolygon
+{
+    SolidPolygonRenderer* renderer;
+    SolidPolygon3D* polygon;
+
+    void operator()(TRUECOLOR color) const
+    {
+        SolidPolygon3D poly = *polygon;
+        poly.setColor(color);
+        renderer->startFrame();
+        renderer->draw(&poly);
+    }
+};
+
+
+int main()
+{
+    printf("%dx%d screen, %d frames each\n", width, height, FRAMES);
+    printf("%-28s %10s\n", "", "Mpix/s");
+
+    printf("%-28s %10.1f\n", "plot_pixel", measureFillRate(PlotPixels()) / 1e6);
+    printf("%-28s %10.1f\n", "line_horiz", measureFillRate(LineHoriz()) / 1e6);
+    printf("%-28s %10.1f\n", "line_fast rows", measureFillRate(LineFastRows()) / 1e6);
+    printf("%-28s %10.1f\n", "line_fast columns", measureFillRate(LineFastColumns()) / 1e6);
+    printf("%-28s %10.1f\n", "cls", measureFillRate(Cls()) / 1e6);
+
+    // a square well beyond the screen's edges, so the scans cover the screen
+    ViewWindow view(0, 0, width, height, DegToRad(75));
+    Transform3D camera(0, 0, 0);
+    SolidPolygon3D polygon(Vector3D(-1000, 1000, -100),
+                           Vector3D(-1000, -1000, -100),
+                           Vector3D(1000, -1000, -100),
+                           Vector3D(1000, 1000, -100));
+    SolidPolygonRenderer renderer(frameBuffer, camera, view, false);
+
+    for (int level=SPAN_KERNEL_SCALAR; level<SPAN_KERNEL_LEVELS; level++)
+    {
+        if (!isSpanKernelSupported((SpanKernelLevel)level))
+            continue;
+
+        const SpanKernels& kernels = getSpanKernels((SpanKernelLevel)level);
+        char name[64];
+
+        FillRuns fillRuns = { kernels.fillRun };
+        sprintf(name, "fillRun %s", kernels.name);
+        printf("%-28s %10.1f\n", name, measureFillRate(fillRuns) / 1e6);
+
+        FillRuns streamFillRuns = { kernels.streamFillRun };
+        sprintf(name, "streamFillRun %s", kernels.name);
+        printf("%-28s %10.1f\n", name, measureFillRate(streamFillRuns) / 1e6);
+
+        renderer.setSpanKernelLevel(kernels.level);
+        DrawPolygon drawPolygon = { &renderer, &polygon };
+        sprintf(name, "SolidPolygonRenderer %s", kernels.name);
+        printf("%-28s %10.1f\n", name, measureFillRate(drawPolygon) / 1e6);
+    }
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include <cstdlib>
+#include <cstring>
+#include "framebuffer.h"
+#include "spankernels.h"
+
+namespace Quokka3D
+{
+    /*
+        Draws into width x height pixels at pixels, with rows pitch bytes apart.
+    */
+    FrameBuffer::FrameBuffer(void* pixels, int width, int height, int pitch, Format format)
+    {
+        setMemory(pixels, width, height, pitch, format);
+    }
+
+
+    void FrameBuffer::setMemory(void* pixels, int width, int height, int pitch, Format format)
+    {
+        m_pixels = (TRUECOLOR*)pixels;
+        m_width = width;
+        m_height = height;
+        m_pitch = pitch;
+        m_format = format;
+    }
+
+
+    /*
+        One fill when the rows are packed, otherwise row by row so the bytes
+        between them (which may belong to something else) are left alone.
+    */
+    void FrameBuffer::cls()
+    {
+        if (m_pitch == m_width * PITCH)
+        {
+            memset(m_pixels, 0, (size_t)m_height * m_pitch);
+            return;
+        }
+
+        for (int y=0; y<m_height; y++)
+            memset(getRow(y), 0, (size_t)m_width * PITCH);
+    }
+
+
+    void FrameBuffer::clsStreamed(const SpanKernels& kernels)
+    {
+        const FillRunFunc streamFillRun = kernels.streamFillRun;
+        if (m_pitch == m_width * PITCH)
+        {
+            streamFillRun(m_pixels, m_width * m_height, 0);
+            return;
+        }
+
+        for (int y=0; y<m_height; y++)
+            streamFillRun(getRow(y), m_width, 0);
+    }
+
+
+    /**************************************************************************
+     *    line_fast                                                           *
+     *    draws a line using Bresenham's line-drawing algorithm, which uses   *
+     *    no multiplication or division. Original code by David Brackeen.     *
+     *    Color is represented as 32-bit xrgb.                                *
+     **************************************************************************/
+    void FrameBuffer::line_fast(int x1, int y1, int x2, int y2, TRUECOLOR color)
+    {
+        int i, dx, dy, sdx, dxabs, dyabs, x, y;
+
+        dx = x2 - x1;      /* the horizontal distance of the line */
+        dy = y2 - y1;      /* the vertical distance of the line */
+        dxabs = abs(dx);
+        dyabs = abs(dy);
+        sdx = sgn(dx);
+        x = dyabs >> 1;
+        y = dxabs >> 1;
+
+        /* a cursor stepped a pixel across or a row down, rather than the
+           row looked up again for each pixel */
+        TRUECOLOR* pixel = getRow(y1) + x1;
+        const ptrdiff_t sdy = sgn(dy) * (m_pitch / PITCH);
+
+        *pixel = color;
+
+        if (dxabs >= dyabs) /* the line is more horizontal than vertical */
+        {
+            for(i=0; i<dxabs; i++)
+            {
+                y += dyabs;
+                if (y >= dxabs)
+                {
+                    y -= dxabs;
+                    pixel += sdy;
+                }
+                pixel += sdx;
+                *pixel = color;
+            }
+        }
+        else /* the line is more vertical than horizontal */
+        {
+            for(i=0; i<dyabs; i++)
+            {
+                x += dxabs;
+                if (x >= dyabs)
+                {
+                    x -= dyabs;
+                    pixel += sdx;
+                }
+                pixel += sdy;
+                *pixel = color;
+            }
+        }
+    }
+
+
+    /*
+        The memory is padded so the pixels can start on a 32 byte boundary.
+    */
+    MemoryFrameBuffer::MemoryFrameBuffer(int width, int height)
+        : m_memory((size_t)width * height + 7)
+    {
+        TRUECOLOR* pixels = &m_memory[0];
+        while (((size_t)pixels & 31) != 0)
+            pixels++;
+        setMemory(pixels, width, height, width * PITCH, FORMAT_XRGB32);
+    }
+} //Soft3D
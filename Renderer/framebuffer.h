@@ -0,0 +1,87 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include "primitives.h"
+#include "spankernels.h"
+
+namespace Quokka3D
+{
+    // A block of 32-bit pixels in the MAKE_RGB32 layout (the only format the
+    // renderers draw) to render into: width x height pixels in rows pitch
+    // bytes apart, a multiple of PITCH. The memory belongs to someone else, e.g.
+    // the vector handed to a PixelToaster display, and must outlive the frame
+    // buffer. Coordinates aren't checked.
+    //
+    // Each renderer draws into the frame buffer it is given, so several views
+    // can be drawn into different buffers, or on different threads.
+    class FrameBuffer
+    {
+    public:
+        enum Format
+        {
+            FORMAT_XRGB32           // TRUECOLOR, the top 8 bits unused
+        };
+
+        FrameBuffer() : m_pixels(0), m_width(0), m_height(0), m_pitch(0), m_format(FORMAT_XRGB32) {}
+        FrameBuffer(void* pixels, int width, int height, int pitch, Format format = FORMAT_XRGB32);
+        virtual ~FrameBuffer() {}
+
+        TRUECOLOR* getPixels() const { return m_pixels; }
+        TRUECOLOR* getRow(int y) const { return (TRUECOLOR*)((BYTE*)m_pixels + y * m_pitch); }
+        int getWidth() const { return m_width; }
+        int getHeight() const { return m_height; }
+        int getPitch() const { return (int)m_pitch; }    // in bytes
+        Format getFormat() const { return m_format; }
+
+        void cls();                 // clears all the pixels to black
+        // the same with the kernels' streaming stores, for buffers bigger than the caches
+        void clsStreamed(const SpanKernels& kernels = getSpanKernels());
+        // For plotting many pixels, take getRow(y) once per row and store
+        // through it rather than calling plot_pixel for each.
+        void plot_pixel(int x, int y, TRUECOLOR color) { getRow(y)[x] = color; }
+        void line_horiz(int x1, int x2, int y, TRUECOLOR color);
+        void line_fast(int x1, int y1, int x2, int y2, TRUECOLOR color);
+
+    protected:
+        void setMemory(void* pixels, int width, int height, int pitch, Format format);
+
+    private:
+        FrameBuffer(const FrameBuffer&);                // not copyable
+        FrameBuffer& operator=(const FrameBuffer&);
+
+        TRUECOLOR* m_pixels;
+        int m_width;
+        int m_height;
+        ptrdiff_t m_pitch;              // not an int, so pixel stores can't alias it
+        Format m_format;
+    };
+
+
+    // A frame buffer that owns its memory, for drawing without a display
+    // (benchmarks, tests, off screen views). The rows are packed and the first
+    // one starts 32 byte aligned.
+    class MemoryFrameBuffer : public FrameBuffer
+    {
+    public:
+        MemoryFrameBuffer(int width, int height);
+
+    private:
+        std::vector<TRUECOLOR> m_memory;
+    };
+
+
+    // Draw a horizontal line, both ends included. The row is looked up once
+    // and the pixels filled as 32-bit words.
+    inline void FrameBuffer::line_horiz(int x1, int x2, int y, TRUECOLOR color)
+    {
+        if (x2 < x1)
+            return;
+
+        std::fill_n(getRow(y) + x1, x2 - x1 + 1, color);
+    }
+}
+
+#endif  //FRAMEBUFFER_H
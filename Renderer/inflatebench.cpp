@@ -0,0 +1,138 @@
+// inflatebench.cpp : Measures LZ_Inflate over the IDAT data of PNG files, with
+// the table-driven Huffman decoding and with the original tree walk
+// (LZ_UseHuffmanTrees), in MB of inflated data per second.
+// Usage: inflatebench [file.png ...] (the test pattern by default)
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <vector>
+#include "mappedfile.h"
+#include "LightPng/LightZ.h"
+
+using namespace Quokka3D;
+
+// Each measurement inflates a file's data until at least this much comes out
+static const double MEASURE_BYTES = 64.0 * 1024 * 1024;
+
+
+// The zlib stream of a PNG file: its IDAT chunks' data, joined. Empty if the
+// file isn't a PNG.
+static std::vector<unsigned char> readIdat(const MappedFile& file)
+{
+    static const unsigned char signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+    std::vector<unsigned char> idat;
+    const unsigned char* p = file.getData();
+    const unsigned char* end = p + file.getSize();
+    if (file.getSize() < 8 || !std::equal(signature, signature + 8, p))
+        return idat;
+
+    p += 8;
+    while (end - p >= 12)
+    {
+        const size_t length = ((size_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+        if (length > (size_t)(end - p) - 12)
+            break;
+        if (p[4] == 'I' && p[5] == 'D' && p[6] == 'A' && p[7] == 'T')
+            idat.insert(idat.end(), p + 8, p + 8 + length);
+        p += 12 + length;
+    }
+    return idat;
+}
+
+
+// Inflates idat over and over, and returns the best of three rates in MB of
+// inflated data per second, or 0 on an error
+static double measureInflate(const std::vector<unsigned char>& idat, bool useTrees)
+{
+    LightZ_Env* env = LZ_NewEnv();
+    LZ_UseHuffmanTrees(env, useTrees);
+
+    // the first inflate sizes the buffer, so the timed ones don't allocate
+    unsigned char* dest = 0;
+    int capacity = 0;
+    if (LZ_Inflate(&idat[0], (int)idat.size(), &dest, &capacity, env) != 0 || capacity == 0)
+    {
+        delete [] dest;
+        LZ_DeleteEnv(env);
+        return 0;
+    }
+    const int inflated = capacity;
+    const int count = (int)(MEASURE_BYTES / inflated) + 1;
+
+    double best = 0;
+    for (int repeat=0; repeat<3; repeat++)
+    {
+        clock_t before = clock();
+        for (int i=0; i<count; i++)
+        {
+            int length = capacity;
+            LZ_Inflate(&idat[0], (int)idat.size(), &dest, &length, env);
+        }
+        double seconds = (double)(clock() - before) / CLOCKS_PER_SEC;
+
+        if (seconds > 0 && (double)inflated * count / seconds > best)
+            best = (double)inflated * count / seconds;
+    }
+
+    delete [] dest;
+    LZ_DeleteEnv(env);
+    return best / (1024 * 1024);
+}
+
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> fileNames(argv + 1, argv + argc);
+    if (fileNames.empty())
+        fileNames.push_back(INFLATEBENCH_TEXTURE);
+
+    printf("%-32s %10s %10s %10s %10s %7s\n", "file", "packed KB", "KB", "tables", "trees", "ratio");
+
+    double totalTables = 0;
+    double totalTrees = 0;
+    int measured = 0;
+    for (size_t i=0; i<fileNames.size(); i++)
+    {
+        MappedFile file;
+        if (!file.open(fileNames[i]))
+        {
+            fprintf(stderr, "Error opening %s\n", fileNames[i].c_str());
+            return EXIT_FAILURE;
+        }
+        std::vector<unsigned char> idat = readIdat(file);
+        if (idat.empty())
+        {
+            fprintf(stderr, "%s isn't a PNG file\n", fileNames[i].c_str());
+            return EXIT_FAILURE;
+        }
+
+        unsigned char* dest = 0;
+        int inflated = 0;
+        const char* error = LZ_Inflate(&idat[0], (int)idat.size(), &dest, &inflated);
+        delete [] dest;
+        if (error != 0)
+        {
+            fprintf(stderr, "Error inflating %s: %s\n", fileNames[i].c_str(), error);
+            return EXIT_FAILURE;
+        }
+
+        double tables = measureInflate(idat, false);
+        double trees = measureInflate(idat, true);
+        const size_t slash = fileNames[i].find_last_of("/\\");
+        const std::string name = (slash == std::string::npos) ? fileNames[i] : fileNames[i].substr(slash + 1);
+        printf("%-32s %10.1f %10.1f %10.1f %10.1f %7.2f\n", name.c_str(), idat.size() / 1024.0,
+               inflated / 1024.0, tables, trees, (trees > 0) ? tables / trees : 0);
+        totalTables += tables;
+        totalTrees += trees;
+        measured++;
+    }
+    printf("%-32s %10s %10s %10.1f %10.1f %7.2f  MB/s\n", "mean", "", "", totalTables / measured,
+           totalTrees / measured, (totalTrees > 0) ? totalTables / totalTrees : 0);
+
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include "mappedfile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Quokka3D
+{
+    MappedFile::MappedFile()
+    {
+        m_data = 0;
+        m_size = 0;
+#ifdef _WIN32
+        m_file = INVALID_HANDLE_VALUE;
+        m_mapping = 0;
+#endif
+    }
+
+
+    /*
+        Maps the whole file read-only. Empty files can't be mapped.
+    */
+    bool MappedFile::open(const std::string& fileName)
+    {
+        close();
+
+#ifdef _WIN32
+        m_file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, 0,
+                             OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+        if (m_file == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_file, &size) || size.QuadPart <= 0 ||
+            (unsigned long long)size.QuadPart > (size_t)-1)
+        {
+            close();
+            return false;
+        }
+
+        m_mapping = CreateFileMappingA(m_file, 0, PAGE_READONLY, 0, 0, 0);
+        if (m_mapping != 0)
+            m_data = (const unsigned char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+        if (m_data == 0)
+        {
+            close();
+            return false;
+        }
+        m_size = (size_t)size.QuadPart;
+#else
+        int fd = ::open(fileName.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size <= 0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        void* data = mmap(0, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);    // the mapping stays valid without the descriptor
+        if (data == MAP_FAILED)
+            return false;
+
+        // the data is read through once, front to back
+        madvise(data, (size_t)info.st_size, MADV_SEQUENTIAL);
+
+        m_data = (const unsigned char*)data;
+        m_size = (size_t)info.st_size;
+#endif
+        return true;
+    }
+
+
+    /*
+        Unmaps the file (if mapped).
+    */
+    void MappedFile::close()
+    {
+#ifdef _WIN32
+        if (m_data != 0)
+            UnmapViewOfFile(m_data);
+        if (m_mapping != 0)
+            CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE)
+            CloseHandle(m_file);
+        m_mapping = 0;
+        m_file = INVALID_HANDLE_VALUE;
+#else
+        if (m_data != 0)
+            munmap((void*)m_data, m_size);
+#endif
+        m_data = 0;
+        m_size = 0;
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace Quokka3D
+{
+    // A whole file mapped read-only into memory. The pages are shared with the
+    // OS file cache, so nothing is copied to the heap.
+    class MappedFile
+    {
+    public:
+        MappedFile();
+        ~MappedFile() { close(); }
+
+        bool open(const std::string& fileName);     // false if the file can't be mapped
+        void close();
+
+        bool isOpen() const { return m_data != 0; }
+        const unsigned char* getData() const { return m_data; }
+        size_t getSize() const { return m_size; }
+
+    private:
+        MappedFile(const MappedFile&);              // not copyable
+        MappedFile& operator=(const MappedFile&);
+
+        const unsigned char* m_data;
+        size_t m_size;
+#ifdef _WIN32
+        void* m_file;                               // file and mapping handles
+        void* m_mapping;
+#endif
+    };
+}
+
+#endif  //MAPPEDFILE_H
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include "polygongroup.h"
+
+namespace Quokka3D
+{
+    PolygonGroup& PolygonGroup::addChild()
+    {
+        m_children.push_back(std::shared_ptr<PolygonGroup>(new PolygonGroup()));
+        m_boundsValid = false;
+        return *m_children.back();
+    }
+
+
+    static bool sameMatrix(const Matrix3x4& a, const Matrix3x4& b)
+    {
+        for (int row=0; row<3; row++)
+            for (int col=0; col<4; col++)
+                if (a.m[row][col] != b.m[row][col])
+                    return false;
+        return true;
+    }
+
+
+    void PolygonGroup::calcBounds()
+    {
+        calcVertexBounds();
+        for (size_t i=0; i<m_children.size(); i++)
+            m_children[i]->calcBounds();
+        mergeChildBounds();
+    }
+
+
+    /*
+        Recalculates the spheres that are out of date, from the bottom up: a
+        group's own after polygons are added to it, and a parent's when one
+        of its children's sphere or transform has changed since it was
+        merged. Every child is visited, so the whole tree is up to date after.
+    */
+    bool PolygonGroup::updateBounds()
+    {
+        bool changed = !m_boundsValid;
+        if (changed)
+            calcVertexBounds();
+
+        for (size_t i=0; i<m_children.size(); i++)
+        {
+            PolygonGroup& child = *m_children[i];
+            if (child.updateBounds() || !sameMatrix(child.m_transform.getMatrix(), child.m_boundsMatrix))
+                changed = true;
+        }
+
+        if (changed)
+            mergeChildBounds();
+        return changed;
+    }
+
+
+    /*
+        The sphere around the box of the group's own vertices.
+    */
+    void PolygonGroup::calcVertexBounds()
+    {
+        m_vertexRadius = -1.0f;
+        if (m_vertices.size() > 0)
+        {
+            Vector3D low(m_vertices.get(0));
+            Vector3D high(low);
+            for (int i=1; i<m_vertices.size(); i++)
+            {
+                const Vector3D v = m_vertices.get(i);
+                low = Vector3D(std::min(low.x, v.x), std::min(low.y, v.y), std::min(low.z, v.z));
+                high = Vector3D(std::max(high.x, v.x), std::max(high.y, v.y), std::max(high.z, v.z));
+            }
+            m_vertexCenter = Vector3D((low.x + high.x) / 2, (low.y + high.y) / 2, (low.z + high.z) / 2);
+
+            float radiusSquared = 0.0f;
+            for (int i=0; i<m_vertices.size(); i++)
+            {
+                Vector3D d(m_vertices.get(i));
+                d -= m_vertexCenter;
+                radiusSquared = std::max(radiusSquared, d.dot(d));
+            }
+            m_vertexRadius = sqrt(radiusSquared);
+        }
+    }
+
+
+    /*
+        The sphere starts as the vertices' and grows to take in each child's
+        sphere in turn, keeping the side away from the child where it was.
+        Each child's transform is kept, for updateBounds to tell when it moves.
+    */
+    void PolygonGroup::mergeChildBounds()
+    {
+        m_boundsCenter = m_vertexCenter;
+        m_boundsRadius = m_vertexRadius;
+        for (size_t i=0; i<m_children.size(); i++)
+        {
+            PolygonGroup& child = *m_children[i];
+            child.m_boundsMatrix = child.m_transform.getMatrix();
+            if (child.m_boundsRadius < 0.0f)
+                continue;
+
+            Vector3D center(child.m_boundsCenter);
+            child.m_transform.getMatrix().transform(center);
+            if (m_boundsRadius < 0.0f)
+            {
+                m_boundsCenter = center;
+                m_boundsRadius = child.m_boundsRadius;
+                continue;
+            }
+
+            Vector3D d(center);
+            d -= m_boundsCenter;
+            const float distance = sqrt(d.dot(d));
+            if (distance + child.m_boundsRadius <= m_boundsRadius)
+                continue;                           // already inside
+            if (distance + m_boundsRadius <= child.m_boundsRadius)
+            {
+                m_boundsCenter = center;            // the child's takes in this one
+                m_boundsRadius = child.m_boundsRadius;
+                continue;
+            }
+
+            const float radius = (distance + m_boundsRadius + child.m_boundsRadius) / 2;
+            d *= (radius - m_boundsRadius) / distance;
+            m_boundsCenter += d;
+            m_boundsRadius = radius;
+        }
+        m_boundsValid = true;
+    }
+}
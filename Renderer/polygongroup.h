@@ -0,0 +1,90 @@
+#ifndef POLYGONGROUP_H
+#define POLYGONGROUP_H
+
+#include <memory>
+#include <vector>
+#include "polygon3D.h"
+#include "transform3D.h"
+#include "vertexpool.h"
+
+namespace Quokka3D
+{
+    // An object: polygons sharing the vertices of one pool, in the object's
+    // own space, with a transform placing it in its parent's space (the
+    // world's for a group without a parent). Child groups move with their
+    // parent, e.g. the wheels of a car.
+    //
+    // PolygonRenderer::draw(group) draws the group and its children in one
+    // call, moving each group's vertices straight from object to camera space
+    // with the transforms combined into one matrix. A group whose bounding
+    // sphere is out of view is skipped with its children, before any of their
+    // vertices are transformed.
+    class PolygonGroup
+    {
+    public:
+        PolygonGroup() : m_vertexRadius(-1.0f), m_boundsRadius(-1.0f), m_boundsValid(false), m_boundsMatrix() {}
+
+        VertexPool& getVertices() { return m_vertices; }
+        const VertexPool& getVertices() const { return m_vertices; }
+        Transform3D& getTransform() { return m_transform; }
+        const Transform3D& getTransform() const { return m_transform; }
+
+        // Adds a copy of poly made of the vertices at indices (see
+        // Polygon3D::setIndices) and returns it, to set its color or texture.
+        // Poly is the type of polygon the renderer draws; a TexturedPolygon3D
+        // needs setTexture or calcTextureBounds afterwards.
+        template <class Poly>
+        Poly& addPolygon(const Poly& poly, const int* indices, int count);
+
+        int getNumPolygons() const { return (int)m_polygons.size(); }
+        Polygon3D* getPolygon(int i) const { return m_polygons[i].get(); }
+
+        // Adds an empty child group and returns it. It stays with this group.
+        PolygonGroup& addChild();
+
+        int getNumChildren() const { return (int)m_children.size(); }
+        PolygonGroup& getChild(int i) const { return *m_children[i]; }
+
+        // A sphere in the group's space around its vertices and its children's
+        // spheres where their transforms put them. The renderer brings the
+        // spheres up to date with updateBounds on every draw, so adding
+        // polygons or children and changing the children's transforms need
+        // nothing more; call calcBounds after moving a group's vertices. A
+        // radius below 0 means the group is empty.
+        void calcBounds();              // the children's too
+        bool updateBounds();            // true if this group's sphere changed
+        const Vector3D& getBoundsCenter() const { return m_boundsCenter; }
+        float getBoundsRadius() const { return m_boundsRadius; }
+
+    private:
+        PolygonGroup(const PolygonGroup&);              // not copyable
+        PolygonGroup& operator=(const PolygonGroup&);
+
+        void calcVertexBounds();
+        void mergeChildBounds();
+
+        VertexPool m_vertices;
+        Transform3D m_transform;                        // object to parent space
+        std::vector<std::shared_ptr<Polygon3D> > m_polygons;    // each deleted as its own type
+        std::vector<std::shared_ptr<PolygonGroup> > m_children;
+        Vector3D m_vertexCenter;                        // the sphere of the vertices alone
+        float m_vertexRadius;
+        Vector3D m_boundsCenter;
+        float m_boundsRadius;
+        bool m_boundsValid;             // false after adding polygons or children
+        Matrix3x4 m_boundsMatrix;       // the transform the parent's sphere was made with
+    };
+
+
+    template <class Poly>
+    Poly& PolygonGroup::addPolygon(const Poly& poly, const int* indices, int count)
+    {
+        std::shared_ptr<Poly> copy(new Poly(poly));
+        copy->setIndices(m_vertices, indices, count);
+        m_polygons.push_back(copy);
+        m_boundsValid = false;
+        return *copy;
+    }
+}
+
+#endif  //POLYGONGROUP_H
@@ -1,60 +1,265 @@
-#include "polygonrenderer.h"
-
-namespace Quokka3D
-{
-    PolygonRenderer::PolygonRenderer(const Transform3D& camera, const ViewWindow& viewWindow)
-    {
-        init(camera, viewWindow, true);
-    }
-
-    PolygonRenderer::PolygonRenderer(const Transform3D& camera, const ViewWindow& viewWindow, bool clearViewEveryFrame)
-    {
-        init(camera, viewWindow, clearViewEveryFrame);
-    }
-
-    void PolygonRenderer::init(const Transform3D& camera, const ViewWindow& viewWindow, bool clearViewEveryFrame)
-    {
-        m_camera = camera;
-        m_viewWindow = viewWindow;
-        m_clearViewEveryFrame = clearViewEveryFrame;
-        m_scanConverter = ScanConverter(viewWindow);
-        m_sourcePolygon = NULL;
-        m_numClipped = m_numFacing = 0;
-        
-    }
-
-    void PolygonRenderer::startFrame()
-    {
-        if (m_clearViewEveryFrame)
-        {
-            cls();
-        }
-    }
-
-    bool PolygonRenderer::draw(Polygon3D* poly)
-    {
-        if ((*poly).isFacing(m_camera.getLocation()))
-        {
-            m_numFacing++;
-            m_sourcePolygon = poly; // save the source poly in case data is needed later
-            m_destPolygon = *poly;
-            m_destPolygon.subtract(m_camera);
-            bool visible = m_destPolygon.clip(-1.0f);
-            if (visible)
-            {
-                m_destPolygon.project(m_viewWindow);
-                visible = m_scanConverter.convert(m_destPolygon);
-                if (visible)
-                {
-                    drawCurrentPolygon();
-                    return true;
-                }
-            }
-            else
-                m_numClipped++;
-        }
-       
-        return false;
-    }
-
-} //Quokka3D
+#include <algorithm>
+#include <climits>
+#include "polygonrenderer.h"
+#include "spankernels.h"
+
+namespace Quokka3D
+{
+    static const float CLIP_Z = -1.0f;     // the near clip plane, in camera space
+
+    PolygonRenderer::PolygonRenderer(FrameBuffer& frameBuffer, const Transform3D& camera, const ViewWindow& viewWindow)
+        : m_spanKernels(&getSpanKernels())
+    {
+        init(frameBuffer, camera, viewWindow, true);
+    }
+
+    PolygonRenderer::PolygonRenderer(FrameBuffer& frameBuffer, const Transform3D& camera, const ViewWindow& viewWindow, bool clearViewEveryFrame)
+        : m_spanKernels(&getSpanKernels())
+    {
+        init(frameBuffer, camera, viewWindow, clearViewEveryFrame);
+    }
+
+    void PolygonRenderer::init(FrameBuffer& frameBuffer, const Transform3D& camera, const ViewWindow& viewWindow, bool clearViewEveryFrame)
+    {
+        m_frameBuffer = &frameBuffer;
+        m_camera = camera;
+        m_viewWindow = viewWindow;
+        m_scanConverter = ScanConverter(viewWindow);
+        m_sourcePolygon = NULL;
+        m_objectToCamera = m_camera.getInverseMatrix();
+        resetCounters();
+        setClearMode(clearViewEveryFrame ? CLEAR_FULL : CLEAR_NONE);
+    }
+
+    void PolygonRenderer::setClearMode(ClearMode mode)
+    {
+        m_clearMode = mode;
+        m_clearAll = true;
+
+        ScanConverter::Scan empty;
+        empty.clear();
+        m_drawnScans.assign((mode == CLEAR_DRAWN) ? m_viewWindow.getTopOffset() + m_viewWindow.getHeight() : 0, empty);
+        m_drawnTop = INT_MAX;
+        m_drawnBottom = INT_MIN;
+    }
+
+    void PolygonRenderer::startFrame()
+    {
+        if (m_clearMode == CLEAR_FULL)
+        {
+            m_frameBuffer->cls();
+        }
+        else if (m_clearMode == CLEAR_FULL_STREAMED)
+        {
+            m_frameBuffer->clsStreamed(*m_spanKernels);
+        }
+        else if (m_clearMode == CLEAR_DRAWN)
+        {
+            if (m_clearAll)
+            {
+                m_frameBuffer->cls();
+                m_clearAll = false;
+            }
+            else
+                clearDrawnScans();
+
+            // start the new frame's extents empty
+            for (int y=m_drawnTop; y<=m_drawnBottom; y++)
+                m_drawnScans[y].clear();
+            m_drawnTop = INT_MAX;
+            m_drawnBottom = INT_MIN;
+        }
+    }
+
+    /*
+        Clears the extents drawn last frame, row by row.
+    */
+    void PolygonRenderer::clearDrawnScans()
+    {
+        const FillRunFunc fillRun = m_spanKernels->fillRun;
+        for (int y=m_drawnTop; y<=m_drawnBottom; y++)
+        {
+            const ScanConverter::Scan& scan = m_drawnScans[y];
+            if (scan.isValid())
+                fillRun(m_frameBuffer->getRow(y) + scan.left, scan.right - scan.left + 1, 0);
+        }
+    }
+
+    /*
+        Adds the scans of the polygon just converted to the frame's extents.
+    */
+    void PolygonRenderer::addDrawnScans()
+    {
+        const int top = m_scanConverter.getTopBoundary();
+        const int bottom = m_scanConverter.getBottomBoundary();
+        for (int y=top; y<=bottom; y++)
+        {
+            const ScanConverter::Scan& scan = m_scanConverter[y];
+            if (scan.isValid())
+                m_drawnScans[y].merge(scan);
+        }
+        m_drawnTop = std::min(m_drawnTop, top);
+        m_drawnBottom = std::max(m_drawnBottom, bottom);
+    }
+
+    bool PolygonRenderer::draw(Polygon3D* poly)
+    {
+        if ((*poly).isFacing(m_camera.getLocation()))
+        {
+            m_numFacing++;
+            m_objectToCamera = m_camera.getInverseMatrix();
+            if (isCulled(poly))
+                return false;
+
+            m_sourcePolygon = poly; // save the source poly in case data is needed later
+            m_destPolygon = *poly;
+            m_destPolygon.subtract(m_camera);
+            if (m_destPolygon.clip(CLIP_Z))
+            {
+                m_destPolygon.project(m_viewWindow);
+                return drawDestPolygon();
+            }
+            else
+                m_numClipped++;
+        }
+       
+        return false;
+    }
+
+    bool PolygonRenderer::draw(Polygon3D* poly, const VertexPool& pool)
+    {
+        m_objectToCamera = m_camera.getInverseMatrix();
+        return drawFromPool(poly, pool, m_camera.getLocation(), false);
+    }
+
+    /*
+        Each group's vertices go from its space to camera space with one
+        matrix, the product of the camera's and the transforms down to it. The
+        facing tests are done in the group's space too, from where the camera
+        is in it. The spheres are brought up to date first, in case a child
+        has been moved since the last draw.
+    */
+    int PolygonRenderer::draw(PolygonGroup& group)
+    {
+        group.updateBounds();
+        return drawGroup(group, m_camera.getInverseMatrix(), false);
+    }
+
+    /*
+        inView is set once a parent's sphere is wholly in view, when its
+        children's and their polygons' are too, and needn't be tested.
+    */
+    int PolygonRenderer::drawGroup(PolygonGroup& group, const Matrix3x4& parentToCamera, bool inView)
+    {
+        Matrix3x4 toCamera;
+        toCamera.multiply(parentToCamera, group.getTransform().getMatrix());
+
+        if (!inView && group.getBoundsRadius() >= 0.0f)
+        {
+            Vector3D center(group.getBoundsCenter());
+            toCamera.transform(center);
+            ViewWindow::Containment containment = m_viewWindow.testSphere(center, group.getBoundsRadius(), CLIP_Z);
+            if (containment == ViewWindow::OUTSIDE)
+            {
+                m_numCulledGroups++;
+                return 0;
+            }
+            inView = (containment == ViewWindow::INSIDE);
+        }
+
+        group.getVertices().transform(toCamera, m_viewWindow);
+
+        Vector3D eye(0.0f, 0.0f, 0.0f);
+        toCamera.inverseTransform(eye);
+
+        int drawn = 0;
+        m_objectToCamera = toCamera;
+        for (int i=0; i<group.getNumPolygons(); i++)
+            drawn += drawFromPool(group.getPolygon(i), group.getVertices(), eye, inView);
+
+        for (int i=0; i<group.getNumChildren(); i++)
+            drawn += drawGroup(group.getChild(i), toCamera, inView);
+        return drawn;
+    }
+
+    /*
+        Tests the polygon's bounding sphere, moved by m_objectToCamera,
+        against the view frustum, and counts it if it's outside.
+    */
+    bool PolygonRenderer::isCulled(const Polygon3D* poly)
+    {
+        if (poly->getBoundsRadius() < 0.0f)
+            return false;
+
+        Vector3D center(poly->getBoundsCenter());
+        m_objectToCamera.transform(center);
+        if (m_viewWindow.testSphere(center, poly->getBoundsRadius(), CLIP_Z) != ViewWindow::OUTSIDE)
+            return false;
+
+        m_numCulled++;
+        return true;
+    }
+
+    /*
+        The polygon's vertices are already in camera space and projected in
+        the pool. When they are all in front of the clip plane the projected
+        points are used as they are; otherwise the camera space vertices are
+        clipped and projected like those of any other polygon. eye is the
+        camera in the polygon's space, for the facing test, and inView is set
+        if the polygon's group is known to be in view.
+    */
+    bool PolygonRenderer::drawFromPool(Polygon3D* poly, const VertexPool& pool, const Vector3D& eye, bool inView)
+    {
+        if (!(*poly).isFacing(eye))
+            return false;
+
+        m_numFacing++;
+        if (!inView && isCulled(poly))
+            return false;
+
+        m_sourcePolygon = poly;
+        const int numVertices = poly->getNumVertices();
+        m_destPolygon.setNumVertices(numVertices);
+
+        bool inFront = true;
+        for (int i=0; i<numVertices; i++)
+            inFront = inFront && pool.getViewZ(poly->getIndex(i)) <= CLIP_Z;
+
+        if (inFront)
+        {
+            for (int i=0; i<numVertices; i++)
+            {
+                const int index = poly->getIndex(i);
+                m_destPolygon[i] = Vector3D(pool.getScreenX(index), pool.getScreenY(index), pool.getViewZ(index));
+            }
+        }
+        else
+        {
+            for (int i=0; i<numVertices; i++)
+                m_destPolygon[i] = pool.getViewVertex(poly->getIndex(i));
+            if (!m_destPolygon.clip(CLIP_Z))
+            {
+                m_numClipped++;
+                return false;
+            }
+            m_destPolygon.project(m_viewWindow);
+        }
+        return drawDestPolygon();
+    }
+
+    /*
+        Scan converts and draws m_destPolygon, once it is projected.
+    */
+    bool PolygonRenderer::drawDestPolygon()
+    {
+        if (!m_scanConverter.convert(m_destPolygon))
+            return false;
+
+        if (m_clearMode == CLEAR_DRAWN)
+            addDrawnScans();
+        m_numDrawn++;
+        drawCurrentPolygon();
+        return true;
+    }
+
+} //Quokka3D
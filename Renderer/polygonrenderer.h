@@ -1,49 +1,118 @@
-#ifndef polygonrenderer_h
-#define polygonrenderer_h
-
-#include "vector3d.h"
-#include "transform3D.h"
-#include "polygon3D.h"
-#include "scanconverter.h"
-#include "viewwindow.h"
-#include "primitives.h"
-
-namespace Quokka3D
-{
-    class PolygonRenderer
-    {
-    public:
-        PolygonRenderer() {}
-        virtual ~PolygonRenderer() {}
-
-        PolygonRenderer(const Transform3D& camera, const ViewWindow& viewWindow);
-        PolygonRenderer(const Transform3D& camera, const ViewWindow& viewWindow, bool clearViewEveryFrame);
-        Transform3D& getCamera()  { return m_camera; }
-        void startFrame();
-        void endFrame() {};
-        bool draw(Polygon3D* poly);
-        void resetCounters() { m_numClipped = m_numFacing = 0; }
-
-        int m_numFacing;
-        int m_numClipped;
-
-    protected:
-        ScanConverter m_scanConverter;
-        Transform3D m_camera;
-        ViewWindow m_viewWindow;
-        bool m_clearViewEveryFrame;
-        Polygon3D* m_sourcePolygon;     // a pointer because behavior is polymorphic
-        Polygon3D m_destPolygon;
-        
-
-        void init(const Transform3D& camera, const ViewWindow& viewWindow, bool clearViewEveryFrame);
-
-        // This must be implemented by a subclass - it does the actual drawing
-        virtual void drawCurrentPolygon() = 0;
-
-    private:
-        
-    };
-
-} // Quokka3D
+#ifndef polygonrenderer_h
+#define polygonrenderer_h
+
+#include "vector3d.h"
+#include "transform3D.h"
+#include "polygon3D.h"
+#include "scanconverter.h"
+#include "viewwindow.h"
+#include "primitives.h"
+#include "framebuffer.h"
+#include "vertexpool.h"
+#include "polygongroup.h"
+
+namespace Quokka3D
+{
+    class PolygonRenderer
+    {
+    public:
+        // How startFrame clears the screen
+        enum ClearMode
+        {
+            CLEAR_NONE,         // keep the last frame's pixels
+            CLEAR_FULL,         // all of the screen, with cls
+            CLEAR_FULL_STREAMED,    // all of the screen, with streaming stores
+            CLEAR_DRAWN         // only the parts of the rows the renderer drew on last frame
+        };
+
+        PolygonRenderer() : m_spanKernels(&getSpanKernels()) {}
+        virtual ~PolygonRenderer() {}
+
+        // The view window must lie inside the frame buffer, which must outlive
+        // the renderer.
+        PolygonRenderer(FrameBuffer& frameBuffer, const Transform3D& camera, const ViewWindow& viewWindow);
+        PolygonRenderer(FrameBuffer& frameBuffer, const Transform3D& camera, const ViewWindow& viewWindow, bool clearViewEveryFrame);
+        Transform3D& getCamera()  { return m_camera; }
+        const ViewWindow& getViewWindow() const { return m_viewWindow; }
+
+        // Draws into another buffer from the next frame, e.g. flipping between
+        // two. The first CLEAR_DRAWN frame clears it in full.
+        void setFrameBuffer(FrameBuffer& frameBuffer) { m_frameBuffer = &frameBuffer; m_clearAll = true; }
+        FrameBuffer& getFrameBuffer() const { return *m_frameBuffer; }
+
+        void startFrame();
+        void endFrame() {};
+
+        // CLEAR_FULL_STREAMED writes the screen straight to memory without
+        // reading it into the caches, for screens bigger than the caches (see
+        // SpanKernels::streamFillRun). CLEAR_DRAWN clears the extents of the
+        // scans drawn since the last startFrame, which is much less than the
+        // screen when the polygons are small; the renderer must be the only thing
+        // drawing to the screen. The first frame after the mode is set is
+        // cleared in full.
+        void setClearMode(ClearMode mode);
+        ClearMode getClearMode() const { return m_clearMode; }
+
+        // The span kernels (the clears' and the subclasses' inner loops)
+        // default to the best the CPU supports; a lower level can be picked
+        // for comparison.
+        void setSpanKernelLevel(SpanKernelLevel level) { m_spanKernels = &getSpanKernels(level); }
+        SpanKernelLevel getSpanKernelLevel() const { return m_spanKernels->level; }
+
+        bool draw(Polygon3D* poly);
+
+        // Draws a polygon of pool's vertices (see Polygon3D::setIndices) from
+        // the pool's last transform, which must have been with this renderer's
+        // camera and view window and after the camera last moved. Only polygons
+        // crossing the clip plane are clipped and projected on their own.
+        bool draw(Polygon3D* poly, const VertexPool& pool);
+
+        // Draws the group and its children, each placed by its transform and
+        // its parents'. Their polygons must be of the type the renderer draws.
+        // Returns the number of polygons drawn.
+        int draw(PolygonGroup& group);
+        void resetCounters() { m_numClipped = m_numFacing = m_numCulled = m_numCulledGroups = m_numDrawn = 0; m_numPixels = 0; }
+
+        // Facing polygons whose bounding spheres are out of view are culled
+        // before their vertices are clipped, and groups before anything of
+        // theirs is looked at.
+        int m_numFacing;
+        int m_numCulled;            // facing polygons outside the view frustum
+        int m_numCulledGroups;      // groups outside it, with their children
+        int m_numClipped;
+        int m_numDrawn;             // polygons with pixels on the screen
+        long long m_numPixels;      // pixels drawn, counting overdraw (by drawCurrentPolygon)
+
+    protected:
+        FrameBuffer* m_frameBuffer;
+        ScanConverter m_scanConverter;
+        Transform3D m_camera;
+        ViewWindow m_viewWindow;
+        ClearMode m_clearMode;
+        const SpanKernels* m_spanKernels;   // the span kernels in use
+        Polygon3D* m_sourcePolygon;     // a pointer because behavior is polymorphic
+        Polygon3D m_destPolygon;
+        Matrix3x4 m_objectToCamera;         // moves the source poly's space to camera space
+        
+
+        void init(FrameBuffer& frameBuffer, const Transform3D& camera, const ViewWindow& viewWindow, bool clearViewEveryFrame);
+
+        // This must be implemented by a subclass - it does the actual drawing
+        virtual void drawCurrentPolygon() = 0;
+
+    private:
+        bool isCulled(const Polygon3D* poly);
+        bool drawFromPool(Polygon3D* poly, const VertexPool& pool, const Vector3D& eye, bool inView);
+        int drawGroup(PolygonGroup& group, const Matrix3x4& parentToCamera, bool inView);
+        bool drawDestPolygon();
+        void clearDrawnScans();
+        void addDrawnScans();
+
+        std::vector<ScanConverter::Scan> m_drawnScans;  // per row, the extent drawn (CLEAR_DRAWN)
+        int m_drawnTop;                 // the rows with drawn extents
+        int m_drawnBottom;
+        bool m_clearAll;                // the next CLEAR_DRAWN clear is a full one
+    };
+
+} // Quokka3D
 #endif // polygonrenderer_h
\ No newline at end of file
@@ -0,0 +1,573 @@
+// quokka_bench.cpp : Renders the test scenes along scripted camera paths into
+// an offscreen frame buffer and reports the time per frame, pixel and polygon
+// rates, polygons and groups culled a frame for being out of view, and a
+// checksum of the frames (the same on every run of a build, and the same for
+// all the kernel levels). Checks the span kernels first, on random spans and on
+// the wall of TextureMapTest1 drawn at each level, and fails if any level's
+// output differs from the scalar kernels'.
+//
+// The terrain is drawn twice, polygon by polygon and from a vertex pool; the
+// two checksums are the same. The village is a group of house groups.
+//
+// -clear picks how the screen is cleared between frames (see
+// PolygonRenderer::ClearMode); streamed and drawn give the same checksums as
+// full, the default, and none doesn't clear at all.
+//
+// Usage: quokka_bench [-frames n] [-size WxH] [-kernels scalar|SSE4.1|AVX2]
+//                     [-clear none|full|streamed|drawn] [-texture file.png]
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "vector3d.h"
+#include "primitives.h"
+#include "framebuffer.h"
+#include "viewwindow.h"
+#include "spankernels.h"
+#include "texture.h"
+#include "texturecache.h"
+#include "solidpolygon3d.h"
+#include "solidpolygonrenderer.h"
+#include "texturedpolygon3d.h"
+#include "SimpleTexturedPolygonRenderer.h"
+#include "vertexpool.h"
+#include "polygongroup.h"
+
+#ifndef QUOKKA_BENCH_TEXTURE
+#define QUOKKA_BENCH_TEXTURE "test_pattern.png"
+#endif
+
+using namespace Quokka3D;
+
+
+// The house of simpletest2: convex, anti-clockwise faces
+static void createHouse(std::vector<SolidPolygon3D>& polys)
+{
+    SolidPolygon3D poly;
+
+    // walls
+    poly = SolidPolygon3D(Vector3D(-200, 0, -1000), Vector3D(200, 0, -1000),
+                          Vector3D(200, 250, -1000), Vector3D(-200, 250, -1000));
+    poly.setColor(MAKE_RGB32(255, 255, 0));
+    polys.push_back(poly);
+    poly = SolidPolygon3D(Vector3D(-200, 0, -1400), Vector3D(-200, 250, -1400),
+                          Vector3D(200, 250, -1400), Vector3D(200, 0, -1400));
+    poly.setColor(MAKE_RGB32(128, 128, 0));
+    polys.push_back(poly);
+    poly = SolidPolygon3D(Vector3D(-200, 0, -1400), Vector3D(-200, 0, -1000),
+                          Vector3D(-200, 250, -1000), Vector3D(-200, 250, -1400));
+    poly.setColor(MAKE_RGB32(128, 128, 0));
+    polys.push_back(poly);
+    poly = SolidPolygon3D(Vector3D(200, 0, -1000), Vector3D(200, 0, -1400),
+                          Vector3D(200, 250, -1400), Vector3D(200, 250, -1000));
+    poly.setColor(MAKE_RGB32(128, 128, 0));
+    polys.push_back(poly);
+
+    // door and windows
+    poly = SolidPolygon3D(Vector3D(0, 0, -1000), Vector3D(75, 0, -1000),
+                          Vector3D(75, 125, -1000), Vector3D(0, 125, -1000));
+    poly.setColor(MAKE_RGB32(2, 40, 90));
+    polys.push_back(poly);
+    poly = SolidPolygon3D(Vector3D(-150, 150, -1000), Vector3D(-100, 150, -1000),
+                          Vector3D(-100, 200, -1000), Vector3D(-150, 200, -1000));
+    poly.setColor(MAKE_RGB32(25, 40, 40));
+    polys.push_back(poly);
+
+    // roof
+    poly = SolidPolygon3D(Vector3D(-200, 250, -1000), Vector3D(200, 250, -1000),
+                          Vector3D(75, 400, -1200), Vector3D(-75, 400, -1200));
+    poly.setColor(MAKE_RGB32(220, 0, 0));
+    polys.push_back(poly);
+    poly = SolidPolygon3D(Vector3D(-200, 250, -1400), Vector3D(-200, 250, -1000),
+                          Vector3D(-75, 400, -1200));
+    poly.setColor(MAKE_RGB32(128, 0, 0));
+    polys.push_back(poly);
+    poly = SolidPolygon3D(Vector3D(200, 250, -1400), Vector3D(-200, 250, -1400),
+                          Vector3D(-75, 400, -1200), Vector3D(75, 400, -1200));
+    poly.setColor(MAKE_RGB32(128, 0, 0));
+    polys.push_back(poly);
+    poly = SolidPolygon3D(Vector3D(200, 250, -1000), Vector3D(200, 250, -1400),
+                          Vector3D(75, 400, -1200));
+    poly.setColor(MAKE_RGB32(128, 0, 0));
+    polys.push_back(poly);
+}
+
+
+// The house again as a group of shared corners around its origin
+static void createHouseGroup(PolygonGroup& house)
+{
+    VertexPool& v = house.getVertices();
+    const int frontBottomLeft = v.add(Vector3D(-200, 0, 200));
+    const int frontBottomRight = v.add(Vector3D(200, 0, 200));
+    const int frontTopRight = v.add(Vector3D(200, 250, 200));
+    const int frontTopLeft = v.add(Vector3D(-200, 250, 200));
+    const int backBottomLeft = v.add(Vector3D(-200, 0, -200));
+    const int backTopLeft = v.add(Vector3D(-200, 250, -200));
+    const int backTopRight = v.add(Vector3D(200, 250, -200));
+    const int backBottomRight = v.add(Vector3D(200, 0, -200));
+    const int ridgeRight = v.add(Vector3D(75, 400, 0));
+    const int ridgeLeft = v.add(Vector3D(-75, 400, 0));
+
+    const int front[] = { frontBottomLeft, frontBottomRight, frontTopRight, frontTopLeft };
+    house.addPolygon(SolidPolygon3D(), front, 4).setColor(MAKE_RGB32(255, 255, 0));
+    const int back[] = { backBottomLeft, backTopLeft, backTopRight, backBottomRight };
+    house.addPolygon(SolidPolygon3D(), back, 4).setColor(MAKE_RGB32(128, 128, 0));
+    const int left[] = { backBottomLeft, frontBottomLeft, frontTopLeft, backTopLeft };
+    house.addPolygon(SolidPolygon3D(), left, 4).setColor(MAKE_RGB32(128, 128, 0));
+    const int right[] = { frontBottomRight, backBottomRight, backTopRight, frontTopRight };
+    house.addPolygon(SolidPolygon3D(), right, 4).setColor(MAKE_RGB32(128, 128, 0));
+
+    const int door[] = { v.add(Vector3D(0, 0, 200)), v.add(Vector3D(75, 0, 200)),
+                         v.add(Vector3D(75, 125, 200)), v.add(Vector3D(0, 125, 200)) };
+    house.addPolygon(SolidPolygon3D(), door, 4).setColor(MAKE_RGB32(2, 40, 90));
+    const int window[] = { v.add(Vector3D(-150, 150, 200)), v.add(Vector3D(-100, 150, 200)),
+                           v.add(Vector3D(-100, 200, 200)), v.add(Vector3D(-150, 200, 200)) };
+    house.addPolygon(SolidPolygon3D(), window, 4).setColor(MAKE_RGB32(25, 40, 40));
+
+    const int roofFront[] = { frontTopLeft, frontTopRight, ridgeRight, ridgeLeft };
+    house.addPolygon(SolidPolygon3D(), roofFront, 4).setColor(MAKE_RGB32(220, 0, 0));
+    const int roofLeft[] = { backTopLeft, frontTopLeft, ridgeLeft };
+    house.addPolygon(SolidPolygon3D(), roofLeft, 3).setColor(MAKE_RGB32(128, 0, 0));
+    const int roofBack[] = { backTopRight, backTopLeft, ridgeLeft, ridgeRight };
+    house.addPolygon(SolidPolygon3D(), roofBack, 4).setColor(MAKE_RGB32(128, 0, 0));
+    const int roofRight[] = { frontTopRight, backTopRight, ridgeRight };
+    house.addPolygon(SolidPolygon3D(), roofRight, 3).setColor(MAKE_RGB32(128, 0, 0));
+}
+
+
+// VILLAGE_SIDE x VILLAGE_SIDE houses in rows, each turned its own way, as
+// children of a group at the house's place. They are drawn in order, without
+// sorting, so nearer houses may be drawn over.
+static const int VILLAGE_SIDE = 8;
+
+static void createVillage(PolygonGroup& village)
+{
+    village.getTransform().setLocation(Vector3D(0, 0, -1200));
+    for (int i=0; i<VILLAGE_SIDE; i++)
+    {
+        for (int j=0; j<VILLAGE_SIDE; j++)
+        {
+            PolygonGroup& house = village.addChild();
+            createHouseGroup(house);
+            house.getTransform().setLocation(Vector3D(700.0f * (j - (VILLAGE_SIDE - 1) / 2.0f), 0,
+                                                      700.0f * (i - (VILLAGE_SIDE - 1) / 2.0f)));
+            house.getTransform().setAngleY(0.7f * (i * VILLAGE_SIDE + j));
+        }
+    }
+}
+
+
+// The wall of TextureMapTest1, drawn with the renderer's texture
+static void createWall(std::vector<TexturedPolygon3D>& polys)
+{
+    polys.push_back(TexturedPolygon3D(Vector3D(-128, 256, -1000), Vector3D(-128, 0, -1000),
+                                      Vector3D(128, 0, -1000), Vector3D(128, 256, -1000)));
+}
+
+
+// Rolling hills of triangles sharing their vertices through pool, TERRAIN_CELLS
+// square cells a side, checkered in two greens
+static const int TERRAIN_CELLS = 48;
+static const float TERRAIN_CELL_SIZE = 64;
+
+static void createTerrain(VertexPool& pool, std::vector<SolidPolygon3D>& polys)
+{
+    const int side = TERRAIN_CELLS + 1;
+    const float origin = -TERRAIN_CELLS * TERRAIN_CELL_SIZE / 2;
+    for (int i=0; i<side; i++)
+    {
+        for (int j=0; j<side; j++)
+        {
+            float x = origin + j * TERRAIN_CELL_SIZE;
+            float z = origin + i * TERRAIN_CELL_SIZE - 1200;
+            pool.add(Vector3D(x, 60 * sin(x / 300) + 60 * cos(z / 250), z));
+        }
+    }
+
+    // each cell is two triangles facing up
+    for (int i=0; i<TERRAIN_CELLS; i++)
+    {
+        for (int j=0; j<TERRAIN_CELLS; j++)
+        {
+            const int a = i * side + j;
+            const int b = a + side;
+            const int halves[2][3] = { { a, b, b + 1 }, { a, b + 1, a + 1 } };
+            for (int k=0; k<2; k++)
+            {
+                SolidPolygon3D poly;
+                poly.setIndices(pool, halves[k], 3);
+                poly.setColor(((i + j) & 1) ? MAKE_RGB32(40, 160, 40) : MAKE_RGB32(30, 120, 30 + 20 * k));
+                polys.push_back(poly);
+            }
+        }
+    }
+}
+
+
+// Turns the camera at location to face target (the camera looks down -z)
+static void lookAt(Transform3D& camera, const Vector3D& location, const Vector3D& target, float roll)
+{
+    camera.setLocation(location);
+    float dx = target.x - location.x;
+    float dy = target.y - location.y;
+    float dz = target.z - location.z;
+    camera.setAngle(atan2(dy, sqrt(dx*dx + dz*dz)), atan2(-dx, -dz), roll);
+}
+
+
+// One turn around the house at t from 0 to 1, closing in and rising and
+// falling, so the house is seen from every side and at several sizes
+static void houseCamera(Transform3D& camera, float t)
+{
+    float angle = 2 * PI * t;
+    float radius = 1100 - 600 * sin(PI * t);
+    Vector3D center(0, 150, -1200);
+    Vector3D location(center.x + radius * sin(angle), 150 + 250 * sin(4 * PI * t),
+                      center.z + radius * cos(angle));
+    lookAt(camera, location, center, 0);
+}
+
+
+// From far away (the smallest mip levels) up to the wall, until it covers the
+// screen, swinging from side to side and rolling, so it is drawn at all angles
+// and sizes. The distance shrinks by the same factor every frame.
+static void wallCamera(Transform3D& camera, float t)
+{
+    Vector3D center(0, 128, -1000);
+    float distance = 3000 * pow(100.0f / 3000, t);
+    float swing = 0.8f * sin(2 * PI * t);
+    Vector3D location(center.x + distance * sin(swing), center.y + 40 * sin(6 * PI * t),
+                      center.z + distance * cos(swing));
+    lookAt(camera, location, center, PI * t);
+}
+
+
+// Low over the terrain in a circle, looking ahead and down, so the near
+// triangles cross the clip plane
+static void terrainCamera(Transform3D& camera, float t)
+{
+    float angle = 2 * PI * t;
+    Vector3D center(0, 0, -1200);
+    Vector3D location(center.x + 700 * sin(angle), 170 + 40 * sin(6 * PI * t), center.z + 700 * cos(angle));
+    Vector3D target(center.x + 700 * sin(angle + 0.6f), 0, center.z + 700 * cos(angle + 0.6f));
+    lookAt(camera, location, target, 0);
+}
+
+
+// Around the village, well above the roofs and looking down at it
+static void villageCamera(Transform3D& camera, float t)
+{
+    float angle = 2 * PI * t;
+    Vector3D center(0, 0, -1200);
+    Vector3D location(center.x + 4000 * sin(angle), 1800 + 600 * sin(4 * PI * t), center.z + 4000 * cos(angle));
+    lookAt(camera, location, center, 0);
+}
+
+
+struct SceneResult
+{
+    std::vector<double> frameMs;        // each frame's time
+    long long pixels;                   // pixels drawn
+    long long polygons;                 // polygons given to the renderer
+    long long culled;                   // polygons outside the view frustum
+    long long culledGroups;             // groups outside it
+    unsigned int checksum;              // of all the frames
+};
+
+
+// FNV-1a of the frame's pixels, carried on from hash
+static unsigned int hashFrame(const FrameBuffer& frameBuffer, unsigned int hash)
+{
+    for (int y=0; y<frameBuffer.getHeight(); y++)
+    {
+        const TRUECOLOR* row = frameBuffer.getRow(y);
+        for (int x=0; x<frameBuffer.getWidth(); x++)
+        {
+            hash = (hash ^ row[x]) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+
+// Milliseconds on a monotonic clock (as a double, since vector3d.h's operator-
+// template hides the time_point one)
+static double nowMs()
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+// Polygons in a vector, each drawn on its own or, with a pool, from the pool
+// after transforming it each frame
+template <class Poly>
+struct PolygonScene
+{
+    std::vector<Poly> polys;
+    VertexPool* pool;
+
+    PolygonScene(const std::vector<Poly>& polys, VertexPool* pool = 0) : polys(polys), pool(pool) {}
+
+    long long draw(PolygonRenderer& renderer)
+    {
+        if (pool)
+        {
+            pool->transform(renderer.getCamera(), renderer.getViewWindow());
+            for (size_t j=0; j<polys.size(); j++)
+                renderer.draw(&polys[j], *pool);
+        }
+        else
+        {
+            for (size_t j=0; j<polys.size(); j++)
+                renderer.draw(&polys[j]);
+        }
+        return polys.size();
+    }
+};
+
+
+// A group drawn in one call
+struct GroupScene
+{
+    PolygonGroup& group;
+
+    explicit GroupScene(PolygonGroup& group) : group(group) {}
+
+    long long draw(PolygonRenderer& renderer)
+    {
+        renderer.draw(group);
+        return countPolygons(group);
+    }
+
+    static long long countPolygons(const PolygonGroup& group)
+    {
+        long long count = group.getNumPolygons();
+        for (int i=0; i<group.getNumChildren(); i++)
+            count += countPolygons(group.getChild(i));
+        return count;
+    }
+};
+
+
+// Draws frames of the scene along the camera path, timing each frame
+// (the checksum is taken outside the timing)
+template <class Scene>
+static SceneResult runScene(PolygonRenderer& renderer, Scene scene,
+                            void (*cameraPath)(Transform3D&, float), int frames)
+{
+    SceneResult result;
+    result.frameMs.reserve(frames);
+    result.polygons = 0;
+    result.checksum = 2166136261u;
+
+    // the other scenes drew on the screen too, so a CLEAR_DRAWN renderer
+    // starts with a full clear
+    renderer.setClearMode(renderer.getClearMode());
+    renderer.resetCounters();
+    for (int i=0; i<frames; i++)
+    {
+        cameraPath(renderer.getCamera(), (float)i / frames);
+
+        double start = nowMs();
+        renderer.startFrame();
+        result.polygons += scene.draw(renderer);
+        renderer.endFrame();
+        double end = nowMs();
+
+        result.frameMs.push_back(end - start);
+        result.checksum = hashFrame(renderer.getFrameBuffer(), result.checksum);
+    }
+    result.pixels = renderer.m_numPixels;
+    result.culled = renderer.m_numCulled;
+    result.culledGroups = renderer.m_numCulledGroups;
+    return result;
+}
+
+
+// The value below which p of the sorted values lie (nearest rank)
+static double percentile(const std::vector<double>& sorted, double p)
+{
+    size_t rank = (size_t)ceil(p / 100 * sorted.size());
+    return sorted[(rank > 0) ? rank - 1 : 0];
+}
+
+
+static void printResult(const char* name, SceneResult result)
+{
+    double totalMs = 0;
+    for (size_t i=0; i<result.frameMs.size(); i++)
+        totalMs += result.frameMs[i];
+    std::sort(result.frameMs.begin(), result.frameMs.end());
+
+    double seconds = totalMs / 1000;
+    double frames = (double)result.frameMs.size();
+    printf("%-9s %7.3f %7.3f %7.3f %7.3f %9.1f %10.0f %8.1f %8.1f  %08x\n", name,
+           percentile(result.frameMs, 50), percentile(result.frameMs, 90),
+           percentile(result.frameMs, 99), result.frameMs.back(),
+           (seconds > 0) ? result.pixels / seconds / 1e6 : 0,
+           (seconds > 0) ? result.polygons / seconds : 0,
+           result.culled / frames, result.culledGroups / frames, result.checksum);
+}
+
+
+static void usage()
+{
+    fprintf(stderr, "Usage: quokka_bench [-frames n] [-size WxH] [-kernels scalar|SSE4.1|AVX2]\n"
+                    "                    [-clear none|full|streamed|drawn] [-texture file.png]\n");
+    exit(EXIT_FAILURE);
+}
+
+
+int main(int argc, char* argv[])
+{
+    int frames = 600;
+    int width = 640;
+    int height = 480;
+    SpanKernelLevel level = getBestSpanKernelLevel();
+    static const char* const clearNames[] = { "none", "full", "streamed", "drawn" };
+    PolygonRenderer::ClearMode clearMode = PolygonRenderer::CLEAR_FULL;
+    std::string textureFile = QUOKKA_BENCH_TEXTURE;
+
+    for (int i=1; i<argc; i++)
+    {
+        if (i + 1 >= argc)
+            usage();
+        if (strcmp(argv[i], "-frames") == 0)
+            frames = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-size") == 0)
+        {
+            if (sscanf(argv[++i], "%dx%d", &width, &height) != 2)
+                usage();
+        }
+        else if (strcmp(argv[i], "-kernels") == 0)
+        {
+            const char* name = argv[++i];
+            int l = SPAN_KERNEL_SCALAR;
+            while (l < SPAN_KERNEL_LEVELS && strcmp(getSpanKernels((SpanKernelLevel)l).name, name) != 0)
+                l++;
+            if (l == SPAN_KERNEL_LEVELS)
+                usage();
+            if (!isSpanKernelSupported((SpanKernelLevel)l))
+            {
+                fprintf(stderr, "%s kernels aren't supported here\n", name);
+                return EXIT_FAILURE;
+            }
+            level = (SpanKernelLevel)l;
+        }
+        else if (strcmp(argv[i], "-clear") == 0)
+        {
+            const char* name = argv[++i];
+            int c = PolygonRenderer::CLEAR_NONE;
+            while (c <= PolygonRenderer::CLEAR_DRAWN && strcmp(clearNames[c], name) != 0)
+                c++;
+            if (c > PolygonRenderer::CLEAR_DRAWN)
+                usage();
+            clearMode = (PolygonRenderer::ClearMode)c;
+        }
+        else if (strcmp(argv[i], "-texture") == 0)
+            textureFile = argv[++i];
+        else
+            usage();
+    }
+    if (frames < 1 || width < 1 || height < 1)
+        usage();
+
+    TextureHandle texture = TextureCache::getDefault().get(textureFile);
+    if (!texture)
+    {
+        fprintf(stderr, "Error loading %s\n", textureFile.c_str());
+        return EXIT_FAILURE;
+    }
+
+    // the kernels must agree with the scalar ones before their times mean anything
+    int differences = 0;
+    for (int l=SPAN_KERNEL_SCALAR; l<SPAN_KERNEL_LEVELS; l++)
+    {
+        const Texture::Level top = texture->getLevel(0);
+        if (!texture->isIndexed())
+            differences += checkSpanKernels((SpanKernelLevel)l, top.texels, top.width, top.height);
+        else
+            differences += checkIndexedSpanKernels((SpanKernelLevel)l, top.indices, texture->getPalette(),
+                                                   top.width, top.height);
+    }
+    if (differences != 0)
+    {
+        fprintf(stderr, "Span kernel check failed: %d pixels differ\n", differences);
+        return EXIT_FAILURE;
+    }
+
+    MemoryFrameBuffer frameBuffer(width, height);
+    ViewWindow view(0, 0, width, height, DegToRad(75));
+    Transform3D camera;
+
+    std::vector<SolidPolygon3D> house;
+    createHouse(house);
+    SolidPolygonRenderer houseRenderer(frameBuffer, camera, view);
+    houseRenderer.setSpanKernelLevel(level);
+    houseRenderer.setClearMode(clearMode);
+
+    std::vector<TexturedPolygon3D> wall;
+    createWall(wall);
+    SimpleTexturedPolygonRenderer wallRenderer(frameBuffer, camera, view, texture);
+    wallRenderer.setSpanKernelLevel(level);
+    wallRenderer.setClearMode(clearMode);
+
+    VertexPool terrainPool;
+    std::vector<SolidPolygon3D> terrain;
+    createTerrain(terrainPool, terrain);
+    terrainPool.setSpanKernelLevel(level);
+
+    PolygonGroup village;
+    createVillage(village);
+
+    // the whole wall scene too, with the renderer's texture at every level
+    unsigned int scalarWall = 0;
+    for (int l=SPAN_KERNEL_SCALAR; l<SPAN_KERNEL_LEVELS; l++)
+    {
+        if (!isSpanKernelSupported((SpanKernelLevel)l))
+            continue;
+        wallRenderer.setSpanKernelLevel((SpanKernelLevel)l);
+        const unsigned int checksum = runScene(wallRenderer, PolygonScene<TexturedPolygon3D>(wall), wallCamera,
+                                               frames).checksum;
+        if (l == SPAN_KERNEL_SCALAR)
+            scalarWall = checksum;
+        else if (checksum != scalarWall)
+        {
+            fprintf(stderr, "Span kernel check failed: the %s wall checksum is %08x, the scalar one %08x\n",
+                    getSpanKernels((SpanKernelLevel)l).name, checksum, scalarWall);
+            return EXIT_FAILURE;
+        }
+    }
+    wallRenderer.setSpanKernelLevel(level);
+
+    printf("%dx%d, %d frames a scene, %s kernels, clear %s\n", width, height, frames,
+           getSpanKernels(level).name, clearNames[clearMode]);
+    printf("%-9s %7s %7s %7s %7s %9s %10s %8s %8s  %s\n", "scene", "p50 ms", "p90 ms", "p99 ms", "max ms",
+           "Mpix/s", "polys/s", "culled", "groups", "checksum");
+
+    // a short run of each first, so the caches and clocks settle
+    runScene(houseRenderer, PolygonScene<SolidPolygon3D>(house), houseCamera, std::min(frames, 30));
+    printResult("house", runScene(houseRenderer, PolygonScene<SolidPolygon3D>(house), houseCamera, frames));
+
+    runScene(wallRenderer, PolygonScene<TexturedPolygon3D>(wall), wallCamera, std::min(frames, 30));
+    printResult("wall", runScene(wallRenderer, PolygonScene<TexturedPolygon3D>(wall), wallCamera, frames));
+
+    PolygonScene<SolidPolygon3D> terrainScene(terrain);
+    runScene(houseRenderer, terrainScene, terrainCamera, std::min(frames, 30));
+    printResult("terrain", runScene(houseRenderer, terrainScene, terrainCamera, frames));
+
+    PolygonScene<SolidPolygon3D> terrainPoolScene(terrain, &terrainPool);
+    runScene(houseRenderer, terrainPoolScene, terrainCamera, std::min(frames, 30));
+    printResult("terrain-p", runScene(houseRenderer, terrainPoolScene, terrainCamera, frames));
+
+    runScene(houseRenderer, GroupScene(village), villageCamera, std::min(frames, 30));
+    printResult("village", runScene(houseRenderer, GroupScene(village), villageCamera, frames));
+
+    return 0;
+}
@@ -1,30 +1,38 @@
-#include "solidpolygonrenderer.h"
-#include "solidpolygon3d.h"
-#include "primitives.h"
-
-namespace Quokka3D
-{
-    /*
-    Draws the current polygon. At this point, the current
-    polygon is transformed, clipped, projected,
-    scan-converted, and visible.
-    */
-    void SolidPolygonRenderer::drawCurrentPolygon()
-    {
-        // draw the scans        
-        int y = m_scanConverter.getTopBoundary();
-        while (y <= m_scanConverter.getBottomBoundary()) 
-        {
-            ScanConverter::Scan scan = m_scanConverter[y];
-           
-            if (scan.isValid())
-            {
-                // TODO: sort out this horrible cast
-                //line_fast(scan.left, y, scan.right, y, (*(SolidPolygon3D*)m_sourcePolygon).getColor());
-                line_horiz(scan.left, scan.right, y, (*(SolidPolygon3D*)m_sourcePolygon).getColor());
-            }
-            y++;
-        }
-
-    }
+#include "solidpolygonrenderer.h"
+#include "solidpolygon3d.h"
+#include "primitives.h"
+
+namespace Quokka3D
+{
+    /*
+    Draws the current polygon. At this point, the current
+    polygon is transformed, clipped, projected,
+    scan-converted, and visible.
+    */
+    void SolidPolygonRenderer::drawCurrentPolygon()
+    {
+        // TODO: sort out this horrible cast
+        const TRUECOLOR color = (*(SolidPolygon3D*)m_sourcePolygon).getColor();
+
+        // draw the scans, stepping the row pointer rather than recomputing it
+        const int rowStep = m_frameBuffer->getPitch() / PITCH;
+        int y = m_scanConverter.getTopBoundary();
+        TRUECOLOR* row = m_frameBuffer->getRow(y);
+        int pixels = 0;
+        while (y <= m_scanConverter.getBottomBoundary()) 
+        {
+            ScanConverter::Scan scan = m_scanConverter[y];
+           
+            if (scan.isValid())
+            {
+                const int count = scan.right - scan.left + 1;
+                m_spanKernels->fillRun(row + scan.left, count, color);
+                pixels += count;
+            }
+            y++;
+            row += rowStep;
+        }
+        m_numPixels += pixels;
+
+    }
 } // Quokka3D
\ No newline at end of file
@@ -1,27 +1,26 @@
-#ifndef solidpolygonrenderer_h
-#define solidpolygonrenderer_h
-
-#include "polygonrenderer.h"
-
-namespace Quokka3D
-{
-    class SolidPolygonRenderer : public PolygonRenderer
-    {
-    public:
-        SolidPolygonRenderer() {}
-        SolidPolygonRenderer(const Transform3D& camera, const ViewWindow& viewWindow) { init(camera, viewWindow, true); }
-        SolidPolygonRenderer(const Transform3D& camera, const ViewWindow& viewWindow, bool clearViewEveryFrame) 
-            { init(camera, viewWindow, clearViewEveryFrame); }
-
-
-
-    protected:
-        void drawCurrentPolygon();
-    	
-    private:
-       
-    };
-
-} // Quokka3D
-
+#ifndef solidpolygonrenderer_h
+#define solidpolygonrenderer_h
+
+#include "polygonrenderer.h"
+#include "spankernels.h"
+
+namespace Quokka3D
+{
+    class SolidPolygonRenderer : public PolygonRenderer
+    {
+    public:
+        // The scans are filled with the span kernels' fillRun (see
+        // PolygonRenderer::setSpanKernelLevel).
+        SolidPolygonRenderer() {}
+        SolidPolygonRenderer(FrameBuffer& frameBuffer, const Transform3D& camera, const ViewWindow& viewWindow) 
+            { init(frameBuffer, camera, viewWindow, true); }
+        SolidPolygonRenderer(FrameBuffer& frameBuffer, const Transform3D& camera, const ViewWindow& viewWindow, bool clearViewEveryFrame) 
+            { init(frameBuffer, camera, viewWindow, clearViewEveryFrame); }
+
+    protected:
+        void drawCurrentPolygon();
+    };
+
+} // Quokka3D
+
 #endif // solidpolygonrenderer_h
\ No newline at end of file
@@ -0,0 +1,1133 @@
+#include "spankernels.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// The SIMD kernels are compiled for their instruction sets whatever the build's
+// target is, and chosen at run time.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define QUOKKA_SPAN_SSE41
+#define QUOKKA_SPAN_AVX2
+#define QUOKKA_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define QUOKKA_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#if _MSC_VER >= 1500
+#define QUOKKA_SPAN_SSE41
+#include <smmintrin.h>
+#endif
+#if _MSC_VER >= 1700
+#define QUOKKA_SPAN_AVX2
+#include <immintrin.h>
+#endif
+#define QUOKKA_TARGET_SSE41
+#define QUOKKA_TARGET_AVX2
+#endif
+
+namespace Quokka3D
+{
+    static const int FIXED_BITS = 16;
+
+
+    static void drawRunScalar(TRUECOLOR* dest, int count, int u, int v, int du, int dv,
+                              const TRUECOLOR* texels, int textureWidth)
+    {
+        for (int i=0; i<count; i++)
+        {
+            dest[i] = texels[(v >> FIXED_BITS) * textureWidth + (u >> FIXED_BITS)];
+            u += du;
+            v += dv;
+        }
+    }
+
+
+    static void drawRunWrappedScalar(TRUECOLOR* dest, int count, int u, int v, int du, int dv,
+                                     const TRUECOLOR* texels, int vShift, int maskU, int maskV)
+    {
+        for (int i=0; i<count; i++)
+        {
+            dest[i] = texels[((v >> vShift) & maskV) + ((u >> FIXED_BITS) & maskU)];
+            u += du;
+            v += dv;
+        }
+    }
+
+
+    /*
+        The index of texel (x, y) in a texture of 4x4 tiles: the row of tiles,
+        the tile in it, then the texel in the tile.
+    */
+    static inline int tiledIndex(int x, int y, int textureWidth)
+    {
+        return (y & ~3) * textureWidth + ((x << 2) & ~15) + ((y << 2) & 12) + (x & 3);
+    }
+
+
+    static void drawRunTiledScalar(TRUECOLOR* dest, int count, int u, int v, int du, int dv,
+                                   const TRUECOLOR* texels, int textureWidth)
+    {
+        for (int i=0; i<count; i++)
+        {
+            dest[i] = texels[tiledIndex(u >> FIXED_BITS, v >> FIXED_BITS, textureWidth)];
+            u += du;
+            v += dv;
+        }
+    }
+
+
+    static void drawRunTiledWrappedScalar(TRUECOLOR* dest, int count, int u, int v, int du, int dv,
+                                          const TRUECOLOR* texels, int widthShift, int maskU, int maskV)
+    {
+        for (int i=0; i<count; i++)
+        {
+            dest[i] = texels[tiledIndex((u >> FIXED_BITS) & maskU, (v >> FIXED_BITS) & maskV, 1 << widthShift)];
+            u += du;
+            v += dv;
+        }
+    }
+
+
+    static void drawRunIndexedScalar(TRUECOLOR* dest, int count, int u, int v, int du, int dv,
+                                     const unsigned char* indices, int textureWidth, const TRUECOLOR* palette)
+    {
+        for (int i=0; i<count; i++)
+        {
+            dest[i] = palette[indices[(v >> FIXED_BITS) * textureWidth + (u >> FIXED_BITS)]];
+            u += du;
+            v += dv;
+        }
+    }
+
+
+    static void drawRunIndexedWrappedScalar(TRUECOLOR* dest, int count, int u, int v, int du, int dv,
+                                            const unsigned char* indices, int vShift, int maskU, int maskV,
+                                            const TRUECOLOR* palette)
+    {
+        for (int i=0; i<count; i++)
+        {
+            dest[i] = palette[indices[((v >> vShift) & maskV) + ((u >> FIXED_BITS) & maskU)]];
+            u += du;
+            v += dv;
+        }
+    }
+
+
+    static void fillRunScalar(TRUECOLOR* dest, int count, TRUECOLOR color)
+    {
+        std::fill_n(dest, count, color);
+    }
+
+
+    /*
+        The operations are in the order of Matrix3x4::transform and
+        ViewWindow::project, which the SIMD versions follow lane by lane.
+    */
+    static void transformVerticesScalar(const VertexArrays& vertices, int count, const float matrix[3][4],
+                                        float distance, float centerX, float centerY)
+    {
+        for (int i=0; i<count; i++)
+        {
+            const float x = vertices.x[i];
+            const float y = vertices.y[i];
+            const float z = vertices.z[i];
+            const float viewX = matrix[0][0]*x + matrix[0][1]*y + matrix[0][2]*z + matrix[0][3];
+            const float viewY = matrix[1][0]*x + matrix[1][1]*y + matrix[1][2]*z + matrix[1][3];
+            const float viewZ = matrix[2][0]*x + matrix[2][1]*y + matrix[2][2]*z + matrix[2][3];
+            vertices.viewX[i] = viewX;
+            vertices.viewY[i] = viewY;
+            vertices.viewZ[i] = viewZ;
+            vertices.screenX[i] = distance * viewX / -viewZ + centerX;
+            vertices.screenY[i] = centerY - distance * viewY / -viewZ;
+        }
+    }
+
+
+    /*
+        The arrays from vertex first on, for the scalar tail of a SIMD pass.
+    */
+    static VertexArrays offsetVertices(const VertexArrays& vertices, int first)
+    {
+        VertexArrays rest = { vertices.x + first, vertices.y + first, vertices.z + first,
+                              vertices.viewX + first, vertices.viewY + first, vertices.viewZ + first,
+                              vertices.screenX + first, vertices.screenY + first };
+        return rest;
+    }
+
+
+    /*
+        The location after n steps of d from start, with the wrap around of the
+        vector lanes (so the scalar tail of a run carries on where they stopped).
+    */
+    static inline int advance(int start, int d, int n)
+    {
+        return (int)((unsigned int)start + (unsigned int)d * (unsigned int)n);
+    }
+
+
+#ifdef QUOKKA_SPAN_SSE41
+    /*
+        4 pixels at a time: the addresses are computed together and the texels
+        fetched one by one (there is no gather before AVX2).
+    */
+    QUOKKA_TARGET_SSE41
+    static void drawRunSSE41(TRUECOLOR* dest, int count, int u, int v, int du, int dv,
+                             const TRUECOLOR* texels, int textureWidth)
+    {
+        int i = 0;
+        if (count >= 4)
+        {
+            const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+            __m128i u4 = _mm_add_epi32(_mm_set1_epi32(u), _mm_mullo_epi32(_mm_set1_epi32(du), lanes));
+            __m128i v4 = _mm_add_epi32(_mm_set1_epi32(v), _mm_mullo_epi32(_mm_set1_epi32(dv), lanes));
+            const __m128i du4 = _mm_set1_epi32(advance(0, du, 4));
+            const __m128i dv4 = _mm_set1_epi32(advance(0, dv, 4));
+            const __m128i width4 = _mm_set1_epi32(textureWidth);
+
+            for (; i + 4 <= count; i += 4)
+            {
+                __m128i index = _mm_add_epi32(_mm_mullo_epi32(_mm_srai_epi32(v4, FIXED_BITS), width4),
+                                              _mm_srai_epi32(u4, FIXED_BITS));
+                __m128i texel = _mm_cvtsi32_si128((int)texels[_mm_cvtsi128_si32(index)]);
+                texel = _mm_insert_epi32(texel, (int)texels[_mm_extract_epi32(index, 1)], 1);
+                texel = _mm_insert_epi32(texel, (int)texels[_mm_extract_epi32(index, 2)], 2);
+                texel = _mm_insert_epi32(texel, (int)texels[_mm_extract_epi32(index, 3)], 3);
+                _mm_storeu_si128((__m128i*)(dest + i), texel);
+
+                u4 = _mm_add_epi32(u4, du4);
+                v4 = _mm_add_epi32(v4, dv4);
+            }
+            u = advance(u, du, i);
+            v = advance(v, dv, i);
+        }
+        drawRunScalar(dest + i, count - i, u, v, du, dv, texels, textureWidth);
+    }
+
+
+    QUOKKA_TARGET_SSE41
+    static void drawRunWrappedSSE41(TRUECOLOR* dest, int count, int u, int v, int du, int dv,
+                                    const TRUECOLOR* texels, int vShift, int maskU, int maskV)
+    {
+        int i = 0;
+        if (count >= 4)
+        {
+            const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+            __m128i u4 = _mm_add_epi32(_mm_set1_epi32(u), _mm_mullo_epi32(_mm_set1_epi32(du), lanes));
+            __m128i v4 = _mm_add_epi32(_mm_set1_epi32(v), _mm_mullo_epi32(_mm_set1_epi32(dv), lanes));
+            const __m128i du4 = _mm_set1_epi32(advance(0, du, 4));
+            const __m128i dv4 = _mm_set1_epi32(advance(0, dv, 4));
+            const __m128i shiftV = _mm_cvtsi32_si128(vShift);
+            const __m128i maskU4 = _mm_set1_epi32(maskU);
+            const __m128i maskV4 = _mm_set1_epi32(maskV);
+
+            for (; i + 4 <= count; i += 4)
+            {
+                __m128i index = _mm_add_epi32(_mm_and_si128(_mm_sra_epi32(v4, shiftV), maskV4),
+                                              _mm_and_si128(_mm_srai_epi32(u4, FIXED_BITS), maskU4));
+                __m128i texel = _mm_cvtsi32_si128((int)texels[_mm_cvtsi128_si32(index)]);
+                texel = _mm_insert_epi32(texel, (int)texels[_mm_extract_epi32(index, 1)], 1);
+                texel = _mm_insert_epi32(texel, (int)texels[_mm_extract_epi32(index, 2)], 2);
+                texel = _mm_insert_epi32(texel, (int)texels[_mm_extract_epi32(index, 3)], 3);
+                _mm_storeu_si128((__m128i*)(dest + i), texel);
+
+                u4 = _mm_add_epi32(u4, du4);
+                v4 = _mm_add_epi32(v4, dv4);
+            }
+            u = advance(u, du, i);
+            v = advance(v, dv, i);
+        }
+        drawRunWrappedScalar(dest + i, count - i, u, v, du, dv, texels, vShift, maskU, maskV);
+    }
+
+    /*
+        tiledIndex for 4 texels. The row of tiles is (y & ~3) * width << rowShift,
+        so the texture width is given either as width or as a shift (width 1).
+    */
+    QUOKKA_TARGET_SSE41
+    static inline __m128i tiledIndex4(__m128i x, __m128i y, __m128i width, __m128i rowShift)
+    {
+        __m128i row = _mm_and_si128(y, _mm_set1_epi32(~3));
+        row = _mm_sll_epi32(_mm_mullo_epi32(row, width), rowShift);
+        __m128i column = _mm_and_si128(_mm_slli_epi32(x, 2), _mm_set1_epi32(~15));
+        __m128i inTile = _mm_or_si128(_mm_and_si128(_mm_slli_epi32(y, 2), _mm_set1_epi32(12)),
+                                      _mm_and_si128(x, _mm_set1_epi32(3)));
+        return _mm_add_epi32(_mm_add_epi32(row, column), inTile);
+    }
+
+
+    QUOKKA_TARGET_SSE41
+    static void drawRunTiledSSE41(TRUECOLOR* dest, int count, int u, int v, int du, int dv,
+                                  const TRUECOLOR* texels, int textureWidth)
+    {
+        int i = 0;
+        if (count >= 4)
+        {
+            const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+            __m128i u4 = _mm_add_epi32(_mm_set1_epi32(u), _mm_mullo_epi32(_mm_set1_epi32(du), lanes));
+            __m128i v4 = _mm_add_epi32(_mm_set1_epi32(v), _mm_mullo_epi32(_mm_set1_epi32(dv), lanes));
+            const __m128i du4 = _mm_set1_epi32(advance(0, du, 4));
+            const __m128i dv4 = _mm_set1_epi32(advance(0, dv, 4));
+            const __m128i width4 = _mm_set1_epi32(textureWidth);
+            const __m128i noShift = _mm_setzero_si128();
+
+            for (; i + 4 <= count; i += 4)
+            {
+                __m128i index = tiledIndex4(_mm_srai_epi32(u4, FIXED_BITS), _mm_srai_epi32(v4, FIXED_BITS), width4, noShift);
+                __m128i texel = _mm_cvtsi32_si128((int)texels[_mm_cvtsi128_si32(index)]);
+                texel = _mm_insert_epi32(texel, (int)texels[_mm_extract_epi32(index, 1)], 1);
+                texel = _mm_insert_epi32(texel, (int)texels[_mm_extract_epi32(index, 2)], 2);
+                texel = _mm_insert_epi32(texel, (int)texels[_mm_extract_epi32(index, 3)], 3);
+                _mm_storeu_si128((__m128i*)(dest + i), texel);
+
+                u4 = _mm_add_epi32(u4, du4);
+                v4 = _mm_add_epi32(v4, dv4);
+            }
+            u = advance(u, du, i);
+            v = advance(v, dv, i);
+        }
+        drawRunTiledScalar(dest + i, count - i, u, v, du, dv, texels, textureWidth);
+    }
+
+
+    QUOKKA_TARGET_SSE41
+    static void drawRunTiledWrappedSSE41(TRUECOLOR* dest, int count, int u, int v, int du, int dv,
+                                         const TRUECOLOR* texels, int widthShift, int maskU, int maskV)
+    {
+        int i = 0;
+        if (count >= 4)
+        {
+            const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+            __m128i u4 = _mm_add_epi32(_mm_set1_epi32(u), _mm_mullo_epi32(_mm_set1_epi32(du), lanes));
+            __m128i v4 = _mm_add_epi32(_mm_set1_epi32(v), _mm_mullo_epi32(_mm_set1_epi32(dv), lanes));
+            const __m128i du4 = _mm_set1_epi32(advance(0, du, 4));
+            const __m128i dv4 = _mm_set1_epi32(advance(0, dv, 4));
+            const __m128i one4 = _mm_set1_epi32(1);
+            const __m128i shift = _mm_cvtsi32_si128(widthShift);
+            const __m128i maskU4 = _mm_set1_epi32(maskU);
+            const __m128i maskV4 = _mm_set1_epi32(maskV);
+
+            for (; i + 4 <= count; i += 4)
+            {
+                __m128i index = tiledIndex4(_mm_and_si128(_mm_srai_epi32(u4, FIXED_BITS), maskU4),
+                                            _mm_and_si128(_mm_srai_epi32(v4, FIXED_BITS), maskV4), one4, shift);
+                __m128i texel = _mm_cvtsi32_si128((int)texels[_mm_cvtsi128_si32(index)]);
+                texel = _mm_insert_epi32(texel, (int)texels[_mm_extract_epi32(index, 1)], 1);
+                texel = _mm_insert_epi32(texel, (int)texels[_mm_extract_epi32(index, 2)], 2);
+                texel = _mm_insert_epi32(texel, (int)texels[_mm_extract_epi32(index, 3)], 3);
+                _mm_storeu_si128((__m128i*)(dest + i), texel);
+
+                u4 = _mm_add_epi32(u4, du4);
+                v4 = _mm_add_epi32(v4, dv4);
+            }
+            u = advance(u, du, i);
+            v = advance(v, dv, i);
+        }
+        drawRunTiledWrappedScalar(dest + i, count - i, u, v, du, dv, texels, widthShift, maskU, maskV);
+    }
+
+    /*
+        The palette entries of 4 indices, fetched one by one.
+    */
+    QUOKKA_TARGET_SSE41
+    static inline __m128i lookUp4(__m128i index, const unsigned char* indices, const TRUECOLOR* palette)
+    {
+        __m128i texel = _mm_cvtsi32_si128((int)palette[indices[_mm_cvtsi128_si32(index)]]);
+        texel = _mm_insert_epi32(texel, (int)palette[indices[_mm_extract_epi32(index, 1)]], 1);
+        texel = _mm_insert_epi32(texel, (int)palette[indices[_mm_extract_epi32(index, 2)]], 2);
+        return _mm_insert_epi32(texel, (int)palette[indices[_mm_extract_epi32(index, 3)]], 3);
+    }
+
+
+    QUOKKA_TARGET_SSE41
+    static void drawRunIndexedSSE41(TRUECOLOR* dest, int count, int u, int v, int du, int dv,
+                                    const unsigned char* indices, int textureWidth, const TRUECOLOR* palette)
+    {
+        int i = 0;
+        if (count >= 4)
+        {
+            const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+            __m128i u4 = _mm_add_epi32(_mm_set1_epi32(u), _mm_mullo_epi32(_mm_set1_epi32(du), lanes));
+            __m128i v4 = _mm_add_epi32(_mm_set1_epi32(v), _mm_mullo_epi32(_mm_set1_epi32(dv), lanes));
+            const __m128i du4 = _mm_set1_epi32(advance(0, du, 4));
+            const __m128i dv4 = _mm_set1_epi32(advance(0, dv, 4));
+            const __m128i width4 = _mm_set1_epi32(textureWidth);
+
+            for (; i + 4 <= count; i += 4)
+            {
+                __m128i index = _mm_add_epi32(_mm_mullo_epi32(_mm_srai_epi32(v4, FIXED_BITS), width4),
+                                              _mm_srai_epi32(u4, FIXED_BITS));
+                _mm_storeu_si128((__m128i*)(dest + i), lookUp4(index, indices, palette));
+
+                u4 = _mm_add_epi32(u4, du4);
+                v4 = _mm_add_epi32(v4, dv4);
+            }
+            u = advance(u, du, i);
+            v = advance(v, dv, i);
+        }
+        drawRunIndexedScalar(dest + i, count - i, u, v, du, dv, indices, textureWidth, palette);
+    }
+
+
+    QUOKKA_TARGET_SSE41
+    static void drawRunIndexedWrappedSSE41(TRUECOLOR* dest, int count, int u, int v, int du, int dv,
+                                           const unsigned char* indices, int vShift, int maskU, int maskV,
+                                           const TRUECOLOR* palette)
+    {
+        int i = 0;
+        if (count >= 4)
+        {
+            const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+            __m128i u4 = _mm_add_epi32(_mm_set1_epi32(u), _mm_mullo_epi32(_mm_set1_epi32(du), lanes));
+            __m128i v4 = _mm_add_epi32(_mm_set1_epi32(v), _mm_mullo_epi32(_mm_set1_epi32(dv), lanes));
+            const __m128i du4 = _mm_set1_epi32(advance(0, du, 4));
+            const __m128i dv4 = _mm_set1_epi32(advance(0, dv, 4));
+            const __m128i shiftV = _mm_cvtsi32_si128(vShift);
+            const __m128i maskU4 = _mm_set1_epi32(maskU);
+            const __m128i maskV4 = _mm_set1_epi32(maskV);
+
+            for (; i + 4 <= count; i += 4)
+            {
+                __m128i index = _mm_add_epi32(_mm_and_si128(_mm_sra_epi32(v4, shiftV), maskV4),
+                                              _mm_and_si128(_mm_srai_epi32(u4, FIXED_BITS), maskU4));
+                _mm_storeu_si128((__m128i*)(dest + i), lookUp4(index, indices, palette));
+
+                u4 = _mm_add_epi32(u4, du4);
+                v4 = _mm_add_epi32(v4, dv4);
+            }
+            u = advance(u, du, i);
+            v = advance(v, dv, i);
+        }
+        drawRunIndexedWrappedScalar(dest + i, count - i, u, v, du, dv, indices, vShift, maskU, maskV, palette);
+    }
+
+    /*
+        Unaligned stores of the first and last 4 pixels, and aligned ones in
+        between (overlapping them).
+    */
+    QUOKKA_TARGET_SSE41
+    static void fillRunSSE41(TRUECOLOR* dest, int count, TRUECOLOR color)
+    {
+        if (count < 4)
+        {
+            fillRunScalar(dest, count, color);
+            return;
+        }
+
+        const __m128i color4 = _mm_set1_epi32((int)color);
+        TRUECOLOR* end = dest + count;
+        _mm_storeu_si128((__m128i*)dest, color4);
+
+        TRUECOLOR* aligned = (TRUECOLOR*)(((size_t)dest + 16) & ~(size_t)15);
+        for (; aligned + 4 <= end; aligned += 4)
+            _mm_store_si128((__m128i*)aligned, color4);
+
+        _mm_storeu_si128((__m128i*)(end - 4), color4);
+    }
+
+    /*
+        Streaming stores of the aligned 4 pixel blocks, plain stores of the
+        pixels before and after them. The fence orders the streaming stores
+        before any later stores (e.g. a present from another thread).
+    */
+    QUOKKA_TARGET_SSE41
+    static void streamFillRunSSE41(TRUECOLOR* dest, int count, TRUECOLOR color)
+    {
+        TRUECOLOR* end = dest + count;
+        TRUECOLOR* aligned = (TRUECOLOR*)(((size_t)dest + 15) & ~(size_t)15);
+        if (end - aligned < 4)
+        {
+            fillRunScalar(dest, count, color);
+            return;
+        }
+
+        fillRunScalar(dest, (int)(aligned - dest), color);
+        const __m128i color4 = _mm_set1_epi32((int)color);
+        for (; aligned + 4 <= end; aligned += 4)
+            _mm_stream_si128((__m128i*)aligned, color4);
+        _mm_sfence();
+        fillRunScalar(aligned, (int)(end - aligned), color);
+    }
+
+    /*
+        4 vertices at a time, the matrix entries in registers. The divides are
+        exact (not reciprocal estimates) to match the scalar pass.
+    */
+    QUOKKA_TARGET_SSE41
+    static void transformVerticesSSE41(const VertexArrays& vertices, int count, const float matrix[3][4],
+                                       float distance, float centerX, float centerY)
+    {
+        __m128 m[3][4];
+        for (int row=0; row<3; row++)
+        {
+            for (int column=0; column<4; column++)
+                m[row][column] = _mm_set1_ps(matrix[row][column]);
+        }
+        const __m128 distance4 = _mm_set1_ps(distance);
+        const __m128 centerX4 = _mm_set1_ps(centerX);
+        const __m128 centerY4 = _mm_set1_ps(centerY);
+        const __m128 signBit = _mm_set1_ps(-0.0f);
+
+        int i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 x = _mm_loadu_ps(vertices.x + i);
+            const __m128 y = _mm_loadu_ps(vertices.y + i);
+            const __m128 z = _mm_loadu_ps(vertices.z + i);
+
+            __m128 view[3];
+            for (int row=0; row<3; row++)
+            {
+                view[row] = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m[row][0], x), _mm_mul_ps(m[row][1], y)),
+                                                  _mm_mul_ps(m[row][2], z)), m[row][3]);
+            }
+            _mm_storeu_ps(vertices.viewX + i, view[0]);
+            _mm_storeu_ps(vertices.viewY + i, view[1]);
+            _mm_storeu_ps(vertices.viewZ + i, view[2]);
+
+            const __m128 negZ = _mm_xor_ps(view[2], signBit);
+            _mm_storeu_ps(vertices.screenX + i, _mm_add_ps(_mm_div_ps(_mm_mul_ps(distance4, view[0]), negZ), centerX4));
+            _mm_storeu_ps(vertices.screenY + i, _mm_sub_ps(centerY4, _mm_div_ps(_mm_mul_ps(distance4, view[1]), negZ)));
+        }
+        transformVerticesScalar(offsetVertices(vertices, i), count - i, matrix, distance, centerX, centerY);
+    }
+#endif
+
+
+#ifdef QUOKKA_SPAN_AVX2
+    /*
+        8 pixels at a time with one gather and one store.
+    */
+    QUOKKA_TARGET_AVX2
+    static void drawRunAVX2(TRUECOLOR* dest, int count, int u, int v, int du, int dv,
+                            const TRUECOLOR* texels, int textureWidth)
+    {
+        int i = 0;
+        if (count >= 8)
+        {
+            const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+            __m256i u8 = _mm256_add_epi32(_mm256_set1_epi32(u), _mm256_mullo_epi32(_mm256_set1_epi32(du), lanes));
+            __m256i v8 = _mm256_add_epi32(_mm256_set1_epi32(v), _mm256_mullo_epi32(_mm256_set1_epi32(dv), lanes));
+            const __m256i du8 = _mm256_set1_epi32(advance(0, du, 8));
+            const __m256i dv8 = _mm256_set1_epi32(advance(0, dv, 8));
+            const __m256i width8 = _mm256_set1_epi32(textureWidth);
+
+            for (; i + 8 <= count; i += 8)
+            {
+                __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_srai_epi32(v8, FIXED_BITS), width8),
+                                                 _mm256_srai_epi32(u8, FIXED_BITS));
+                __m256i texel = _mm256_i32gather_epi32((const int*)texels, index, 4);
+                _mm256_storeu_si256((__m256i*)(dest + i), texel);
+
+                u8 = _mm256_add_epi32(u8, du8);
+                v8 = _mm256_add_epi32(v8, dv8);
+            }
+            u = advance(u, du, i);
+            v = advance(v, dv, i);
+        }
+        drawRunScalar(dest + i, count - i, u, v, du, dv, texels, textureWidth);
+    }
+
+
+    QUOKKA_TARGET_AVX2
+    static void drawRunWrappedAVX2(TRUECOLOR* dest, int count, int u, int v, int du, int dv,
+                                   const TRUECOLOR* texels, int vShift, int maskU, int maskV)
+    {
+        int i = 0;
+        if (count >= 8)
+        {
+            const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+            __m256i u8 = _mm256_add_epi32(_mm256_set1_epi32(u), _mm256_mullo_epi32(_mm256_set1_epi32(du), lanes));
+            __m256i v8 = _mm256_add_epi32(_mm256_set1_epi32(v), _mm256_mullo_epi32(_mm256_set1_epi32(dv), lanes));
+            const __m256i du8 = _mm256_set1_epi32(advance(0, du, 8));
+            const __m256i dv8 = _mm256_set1_epi32(advance(0, dv, 8));
+            const __m128i shiftV = _mm_cvtsi32_si128(vShift);
+            const __m256i maskU8 = _mm256_set1_epi32(maskU);
+            const __m256i maskV8 = _mm256_set1_epi32(maskV);
+
+            for (; i + 8 <= count; i += 8)
+            {
+                __m256i index = _mm256_add_epi32(_mm256_and_si256(_mm256_sra_epi32(v8, shiftV), maskV8),
+                                                 _mm256_and_si256(_mm256_srai_epi32(u8, FIXED_BITS), maskU8));
+                __m256i texel = _mm256_i32gather_epi32((const int*)texels, index, 4);
+                _mm256_storeu_si256((__m256i*)(dest + i), texel);
+
+                u8 = _mm256_add_epi32(u8, du8);
+                v8 = _mm256_add_epi32(v8, dv8);
+            }
+            u = advance(u, du, i);
+            v = advance(v, dv, i);
+        }
+        drawRunWrappedScalar(dest + i, count - i, u, v, du, dv, texels, vShift, maskU, maskV);
+    }
+
+    /*
+        tiledIndex for 8 texels, as tiledIndex4.
+    */
+    QUOKKA_TARGET_AVX2
+    static inline __m256i tiledIndex8(__m256i x, __m256i y, __m256i width, __m128i rowShift)
+    {
+        __m256i row = _mm256_and_si256(y, _mm256_set1_epi32(~3));
+        row = _mm256_sll_epi32(_mm256_mullo_epi32(row, width), rowShift);
+        __m256i column = _mm256_and_si256(_mm256_slli_epi32(x, 2), _mm256_set1_epi32(~15));
+        __m256i inTile = _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi32(y, 2), _mm256_set1_epi32(12)),
+                                         _mm256_and_si256(x, _mm256_set1_epi32(3)));
+        return _mm256_add_epi32(_mm256_add_epi32(row, column), inTile);
+    }
+
+
+    QUOKKA_TARGET_AVX2
+    static void drawRunTiledAVX2(TRUECOLOR* dest, int count, int u, int v, int du, int dv,
+                                 const TRUECOLOR* texels, int textureWidth)
+    {
+        int i = 0;
+        if (count >= 8)
+        {
+            const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+            __m256i u8 = _mm256_add_epi32(_mm256_set1_epi32(u), _mm256_mullo_epi32(_mm256_set1_epi32(du), lanes));
+            __m256i v8 = _mm256_add_epi32(_mm256_set1_epi32(v), _mm256_mullo_epi32(_mm256_set1_epi32(dv), lanes));
+            const __m256i du8 = _mm256_set1_epi32(advance(0, du, 8));
+            const __m256i dv8 = _mm256_set1_epi32(advance(0, dv, 8));
+            const __m256i width8 = _mm256_set1_epi32(textureWidth);
+            const __m128i noShift = _mm_setzero_si128();
+
+            for (; i + 8 <= count; i += 8)
+            {
+                __m256i index = tiledIndex8(_mm256_srai_epi32(u8, FIXED_BITS), _mm256_srai_epi32(v8, FIXED_BITS), width8, noShift);
+                __m256i texel = _mm256_i32gather_epi32((const int*)texels, index, 4);
+                _mm256_storeu_si256((__m256i*)(dest + i), texel);
+
+                u8 = _mm256_add_epi32(u8, du8);
+                v8 = _mm256_add_epi32(v8, dv8);
+            }
+            u = advance(u, du, i);
+            v = advance(v, dv, i);
+        }
+        drawRunTiledScalar(dest + i, count - i, u, v, du, dv, texels, textureWidth);
+    }
+
+
+    QUOKKA_TARGET_AVX2
+    static void drawRunTiledWrappedAVX2(TRUECOLOR* dest, int count, int u, int v, int du, int dv,
+                                        const TRUECOLOR* texels, int widthShift, int maskU, int maskV)
+    {
+        int i = 0;
+        if (count >= 8)
+        {
+            const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+            __m256i u8 = _mm256_add_epi32(_mm256_set1_epi32(u), _mm256_mullo_epi32(_mm256_set1_epi32(du), lanes));
+            __m256i v8 = _mm256_add_epi32(_mm256_set1_epi32(v), _mm256_mullo_epi32(_mm256_set1_epi32(dv), lanes));
+            const __m256i du8 = _mm256_set1_epi32(advance(0, du, 8));
+            const __m256i dv8 = _mm256_set1_epi32(advance(0, dv, 8));
+            const __m256i one8 = _mm256_set1_epi32(1);
+            const __m128i shift = _mm_cvtsi32_si128(widthShift);
+            const __m256i maskU8 = _mm256_set1_epi32(maskU);
+            const __m256i maskV8 = _mm256_set1_epi32(maskV);
+
+            for (; i + 8 <= count; i += 8)
+            {
+                __m256i index = tiledIndex8(_mm256_and_si256(_mm256_srai_epi32(u8, FIXED_BITS), maskU8),
+                                            _mm256_and_si256(_mm256_srai_epi32(v8, FIXED_BITS), maskV8), one8, shift);
+                __m256i texel = _mm256_i32gather_epi32((const int*)texels, index, 4);
+                _mm256_storeu_si256((__m256i*)(dest + i), texel);
+
+                u8 = _mm256_add_epi32(u8, du8);
+                v8 = _mm256_add_epi32(v8, dv8);
+            }
+            u = advance(u, du, i);
+            v = advance(v, dv, i);
+        }
+        drawRunTiledWrappedScalar(dest + i, count - i, u, v, du, dv, texels, widthShift, maskU, maskV);
+    }
+
+    /*
+        The palette entries of 8 indices: a gather of the words starting at the
+        indices, then one of the palette entries.
+    */
+    QUOKKA_TARGET_AVX2
+    static inline __m256i lookUp8(__m256i index, const unsigned char* indices, const TRUECOLOR* palette)
+    {
+        __m256i entry = _mm256_i32gather_epi32((const int*)indices, index, 1);
+        entry = _mm256_and_si256(entry, _mm256_set1_epi32(0xff));
+        return _mm256_i32gather_epi32((const int*)palette, entry, 4);
+    }
+
+
+    QUOKKA_TARGET_AVX2
+    static void drawRunIndexedAVX2(TRUECOLOR* dest, int count, int u, int v, int du, int dv,
+                                   const unsigned char* indices, int textureWidth, const TRUECOLOR* palette)
+    {
+        int i = 0;
+        if (count >= 8)
+        {
+            const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+            __m256i u8 = _mm256_add_epi32(_mm256_set1_epi32(u), _mm256_mullo_epi32(_mm256_set1_epi32(du), lanes));
+            __m256i v8 = _mm256_add_epi32(_mm256_set1_epi32(v), _mm256_mullo_epi32(_mm256_set1_epi32(dv), lanes));
+            const __m256i du8 = _mm256_set1_epi32(advance(0, du, 8));
+            const __m256i dv8 = _mm256_set1_epi32(advance(0, dv, 8));
+            const __m256i width8 = _mm256_set1_epi32(textureWidth);
+
+            for (; i + 8 <= count; i += 8)
+            {
+                __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_srai_epi32(v8, FIXED_BITS), width8),
+                                                 _mm256_srai_epi32(u8, FIXED_BITS));
+                _mm256_storeu_si256((__m256i*)(dest + i), lookUp8(index, indices, palette));
+
+                u8 = _mm256_add_epi32(u8, du8);
+                v8 = _mm256_add_epi32(v8, dv8);
+            }
+            u = advance(u, du, i);
+            v = advance(v, dv, i);
+        }
+        drawRunIndexedScalar(dest + i, count - i, u, v, du, dv, indices, textureWidth, palette);
+    }
+
+
+    QUOKKA_TARGET_AVX2
+    static void drawRunIndexedWrappedAVX2(TRUECOLOR* dest, int count, int u, int v, int du, int dv,
+                                          const unsigned char* indices, int vShift, int maskU, int maskV,
+                                          const TRUECOLOR* palette)
+    {
+        int i = 0;
+        if (count >= 8)
+        {
+            const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+            __m256i u8 = _mm256_add_epi32(_mm256_set1_epi32(u), _mm256_mullo_epi32(_mm256_set1_epi32(du), lanes));
+            __m256i v8 = _mm256_add_epi32(_mm256_set1_epi32(v), _mm256_mullo_epi32(_mm256_set1_epi32(dv), lanes));
+            const __m256i du8 = _mm256_set1_epi32(advance(0, du, 8));
+            const __m256i dv8 = _mm256_set1_epi32(advance(0, dv, 8));
+            const __m128i shiftV = _mm_cvtsi32_si128(vShift);
+            const __m256i maskU8 = _mm256_set1_epi32(maskU);
+            const __m256i maskV8 = _mm256_set1_epi32(maskV);
+
+            for (; i + 8 <= count; i += 8)
+            {
+                __m256i index = _mm256_add_epi32(_mm256_and_si256(_mm256_sra_epi32(v8, shiftV), maskV8),
+                                                 _mm256_and_si256(_mm256_srai_epi32(u8, FIXED_BITS), maskU8));
+                _mm256_storeu_si256((__m256i*)(dest + i), lookUp8(index, indices, palette));
+
+                u8 = _mm256_add_epi32(u8, du8);
+                v8 = _mm256_add_epi32(v8, dv8);
+            }
+            u = advance(u, du, i);
+            v = advance(v, dv, i);
+        }
+        drawRunIndexedWrappedScalar(dest + i, count - i, u, v, du, dv, indices, vShift, maskU, maskV, palette);
+    }
+
+    /*
+        As fillRunSSE41, 8 pixels (32 bytes) a store.
+    */
+    QUOKKA_TARGET_AVX2
+    static void fillRunAVX2(TRUECOLOR* dest, int count, TRUECOLOR color)
+    {
+        if (count < 8)
+        {
+            fillRunScalar(dest, count, color);
+            return;
+        }
+
+        const __m256i color8 = _mm256_set1_epi32((int)color);
+        TRUECOLOR* end = dest + count;
+        _mm256_storeu_si256((__m256i*)dest, color8);
+
+        TRUECOLOR* aligned = (TRUECOLOR*)(((size_t)dest + 32) & ~(size_t)31);
+        for (; aligned + 8 <= end; aligned += 8)
+            _mm256_store_si256((__m256i*)aligned, color8);
+
+        _mm256_storeu_si256((__m256i*)(end - 8), color8);
+    }
+
+    /*
+        As streamFillRunSSE41, 8 pixels (32 bytes) a store.
+    */
+    QUOKKA_TARGET_AVX2
+    static void streamFillRunAVX2(TRUECOLOR* dest, int count, TRUECOLOR color)
+    {
+        TRUECOLOR* end = dest + count;
+        TRUECOLOR* aligned = (TRUECOLOR*)(((size_t)dest + 31) & ~(size_t)31);
+        if (end - aligned < 8)
+        {
+            fillRunScalar(dest, count, color);
+            return;
+        }
+
+        fillRunScalar(dest, (int)(aligned - dest), color);
+        const __m256i color8 = _mm256_set1_epi32((int)color);
+        for (; aligned + 8 <= end; aligned += 8)
+            _mm256_stream_si256((__m256i*)aligned, color8);
+        _mm_sfence();
+        fillRunScalar(aligned, (int)(end - aligned), color);
+    }
+
+    /*
+        As transformVerticesSSE41, 8 vertices at a time. There are no fused
+        multiply-adds, which would round differently.
+    */
+    QUOKKA_TARGET_AVX2
+    static void transformVerticesAVX2(const VertexArrays& vertices, int count, const float matrix[3][4],
+                                      float distance, float centerX, float centerY)
+    {
+        __m256 m[3][4];
+        for (int row=0; row<3; row++)
+        {
+            for (int column=0; column<4; column++)
+                m[row][column] = _mm256_set1_ps(matrix[row][column]);
+        }
+        const __m256 distance8 = _mm256_set1_ps(distance);
+        const __m256 centerX8 = _mm256_set1_ps(centerX);
+        const __m256 centerY8 = _mm256_set1_ps(centerY);
+        const __m256 signBit = _mm256_set1_ps(-0.0f);
+
+        int i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256 x = _mm256_loadu_ps(vertices.x + i);
+            const __m256 y = _mm256_loadu_ps(vertices.y + i);
+            const __m256 z = _mm256_loadu_ps(vertices.z + i);
+
+            __m256 view[3];
+            for (int row=0; row<3; row++)
+            {
+                view[row] = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[row][0], x), _mm256_mul_ps(m[row][1], y)),
+                                                        _mm256_mul_ps(m[row][2], z)), m[row][3]);
+            }
+            _mm256_storeu_ps(vertices.viewX + i, view[0]);
+            _mm256_storeu_ps(vertices.viewY + i, view[1]);
+            _mm256_storeu_ps(vertices.viewZ + i, view[2]);
+
+            const __m256 negZ = _mm256_xor_ps(view[2], signBit);
+            _mm256_storeu_ps(vertices.screenX + i, _mm256_add_ps(_mm256_div_ps(_mm256_mul_ps(distance8, view[0]), negZ), centerX8));
+            _mm256_storeu_ps(vertices.screenY + i, _mm256_sub_ps(centerY8, _mm256_div_ps(_mm256_mul_ps(distance8, view[1]), negZ)));
+        }
+        transformVerticesScalar(offsetVertices(vertices, i), count - i, matrix, distance, centerX, centerY);
+    }
+#endif
+
+
+    static const SpanKernels spanKernelTable[SPAN_KERNEL_LEVELS] =
+    {
+        { SPAN_KERNEL_SCALAR, "scalar", drawRunScalar, drawRunWrappedScalar, drawRunTiledScalar, drawRunTiledWrappedScalar,
+          drawRunIndexedScalar, drawRunIndexedWrappedScalar, fillRunScalar, fillRunScalar, transformVerticesScalar },
+#ifdef QUOKKA_SPAN_SSE41
+        { SPAN_KERNEL_SSE41, "SSE4.1", drawRunSSE41, drawRunWrappedSSE41, drawRunTiledSSE41, drawRunTiledWrappedSSE41,
+          drawRunIndexedSSE41, drawRunIndexedWrappedSSE41, fillRunSSE41, streamFillRunSSE41, transformVerticesSSE41 },
+#else
+        { SPAN_KERNEL_SSE41, "SSE4.1", 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+#endif
+#ifdef QUOKKA_SPAN_AVX2
+        { SPAN_KERNEL_AVX2, "AVX2", drawRunAVX2, drawRunWrappedAVX2, drawRunTiledAVX2, drawRunTiledWrappedAVX2,
+          drawRunIndexedAVX2, drawRunIndexedWrappedAVX2, fillRunAVX2, streamFillRunAVX2, transformVerticesAVX2 },
+#else
+        { SPAN_KERNEL_AVX2, "AVX2", 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+#endif
+    };
+
+
+    /*
+        Asks the CPU (and, for AVX2, the OS, which must save the 256 bit
+        registers) whether the instructions of level are available.
+    */
+    static bool cpuSupports(SpanKernelLevel level)
+    {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_cpu_init();
+        if (level == SPAN_KERNEL_SSE41)
+            return __builtin_cpu_supports("sse4.1") != 0;
+        if (level == SPAN_KERNEL_AVX2)
+            return __builtin_cpu_supports("avx2") != 0;
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        int info[4];
+        __cpuid(info, 1);
+        if (level == SPAN_KERNEL_SSE41)
+            return (info[2] & (1 << 19)) != 0;
+#ifdef QUOKKA_SPAN_AVX2
+        if (level == SPAN_KERNEL_AVX2)
+        {
+            bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+            __cpuidex(info, 7, 0);
+            return osSavesYmm && (info[1] & (1 << 5)) != 0;
+        }
+#endif
+#endif
+        return level == SPAN_KERNEL_SCALAR;
+    }
+
+
+    bool isSpanKernelSupported(SpanKernelLevel level)
+    {
+        if (level < SPAN_KERNEL_SCALAR || level >= SPAN_KERNEL_LEVELS)
+            return false;
+        return spanKernelTable[level].drawRun != 0 && cpuSupports(level);
+    }
+
+
+    static SpanKernelLevel findBestSpanKernelLevel()
+    {
+        int best = SPAN_KERNEL_LEVELS - 1;
+        while (best > SPAN_KERNEL_SCALAR && !isSpanKernelSupported((SpanKernelLevel)best))
+            best--;
+        return (SpanKernelLevel)best;
+    }
+
+
+    SpanKernelLevel getBestSpanKernelLevel()
+    {
+        static const SpanKernelLevel best = findBestSpanKernelLevel();
+        return best;
+    }
+
+
+    const SpanKernels& getSpanKernels(SpanKernelLevel level)
+    {
+        SpanKernelLevel best = getBestSpanKernelLevel();
+        if (level > best)
+            level = best;
+        if (level < SPAN_KERNEL_SCALAR)
+            level = SPAN_KERNEL_SCALAR;
+        return spanKernelTable[level];
+    }
+
+
+    const SpanKernels& getSpanKernels()
+    {
+        return spanKernelTable[getBestSpanKernelLevel()];
+    }
+
+
+    static const int CHECK_RUNS = 20000;
+    static const int CHECK_MAX_COUNT = 67;
+
+
+    // A pseudo-random run for the checks
+    struct CheckRun
+    {
+        int count;
+        int u, v, du, dv;                       // between two points of the texture
+        int wrappedU, wrappedV;                 // anywhere within +-2^13 texels,
+        int wrappedDu, wrappedDv;               // stepping up to 64 texels a pixel
+    };
+
+
+    static void pickCheckRun(unsigned int& seed, int textureWidth, int textureHeight, CheckRun& run)
+    {
+        int pick[5];
+        for (int i=0; i<5; i++)
+        {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            pick[i] = (int)(seed >> 1);
+        }
+
+        run.count = 1 + pick[0] % CHECK_MAX_COUNT;
+        run.u = pick[1] % (textureWidth << FIXED_BITS);
+        run.v = pick[2] % (textureHeight << FIXED_BITS);
+        run.du = (pick[3] % (textureWidth << FIXED_BITS) - run.u) / run.count;
+        run.dv = (pick[4] % (textureHeight << FIXED_BITS) - run.v) / run.count;
+
+        run.wrappedU = pick[1] % (1 << 30) - (1 << 29);
+        run.wrappedV = pick[2] % (1 << 30) - (1 << 29);
+        run.wrappedDu = pick[3] % (1 << 23) - (1 << 22);
+        run.wrappedDv = pick[4] % (1 << 23) - (1 << 22);
+    }
+
+
+    /*
+        log2 of the texture width if both sides are powers of two, otherwise -1.
+    */
+    static int getWrapShift(int textureWidth, int textureHeight)
+    {
+        int shift = 0;
+        while ((1 << shift) < textureWidth)
+            shift++;
+        if (textureWidth != (1 << shift) || (textureHeight & (textureHeight - 1)) != 0)
+            return -1;
+        return shift;
+    }
+
+
+    static int countDifferences(const std::vector<TRUECOLOR>& expected, const std::vector<TRUECOLOR>& actual, int count)
+    {
+        int differences = 0;
+        for (int i=0; i<count; i++)
+            differences += (expected[i] != actual[i]);
+        return differences;
+    }
+
+
+    static const int CHECK_VERTEX_PASSES = 200;
+
+
+    /*
+        Pseudo-random vertices and matrices, with vertex counts around the
+        vector widths. The results are compared bit for bit.
+    */
+    static int checkTransformVertices(const SpanKernels& scalar, const SpanKernels& kernels)
+    {
+        const int size = CHECK_MAX_COUNT;
+        std::vector<float> in(3 * size);
+        std::vector<float> expected(5 * size);
+        std::vector<float> actual(5 * size);
+
+        unsigned int seed = 54321;
+        int differences = 0;
+        for (int pass=0; pass<CHECK_VERTEX_PASSES; pass++)
+        {
+            float pick[3 * CHECK_MAX_COUNT + 12];
+            for (int i=0; i<3 * size + 12; i++)
+            {
+                seed ^= seed << 13;
+                seed ^= seed >> 17;
+                seed ^= seed << 5;
+                pick[i] = (float)(int)(seed >> 8) / (1 << 23) - 1;     // -1 to 1
+            }
+
+            float matrix[3][4];
+            for (int row=0; row<3; row++)
+            {
+                for (int column=0; column<4; column++)
+                    matrix[row][column] = pick[row * 4 + column] * ((column == 3) ? 1000.0f : 1.0f);
+            }
+            for (int i=0; i<3 * size; i++)
+                in[i] = pick[12 + i] * 2000;
+
+            const int count = pass % (size + 1);
+            VertexArrays expectedArrays = { &in[0], &in[size], &in[2 * size],
+                                            &expected[0], &expected[size], &expected[2 * size],
+                                            &expected[3 * size], &expected[4 * size] };
+            VertexArrays actualArrays = { &in[0], &in[size], &in[2 * size],
+                                          &actual[0], &actual[size], &actual[2 * size],
+                                          &actual[3 * size], &actual[4 * size] };
+            scalar.transformVertices(expectedArrays, count, matrix, 400.0f, 320.0f, 240.0f);
+            kernels.transformVertices(actualArrays, count, matrix, 400.0f, 320.0f, 240.0f);
+
+            for (int i=0; i<count; i++)
+            {
+                bool same = true;
+                for (int array=0; array<5; array++)
+                    same = same && memcmp(&expected[array * size + i], &actual[array * size + i], sizeof(float)) == 0;
+                differences += !same;
+            }
+        }
+        return differences;
+    }
+
+
+    /*
+        The runs cover the lengths around the vector widths, and locations and
+        steps in both directions. For power of two textures the wrapped kernels
+        are also run with locations well outside the texture.
+    */
+    int checkSpanKernels(SpanKernelLevel level, const TRUECOLOR* texels, int textureWidth, int textureHeight)
+    {
+        if (!isSpanKernelSupported(level))
+            return 0;
+
+        const SpanKernels& scalar = spanKernelTable[SPAN_KERNEL_SCALAR];
+        const SpanKernels& kernels = spanKernelTable[level];
+
+        const int shift = getWrapShift(textureWidth, textureHeight);
+        const bool tiled = (textureWidth % 4) == 0 && (textureHeight % 4) == 0;
+
+        // room for solid runs to start anywhere in a 32 byte block, with a pixel
+        // either side
+        std::vector<TRUECOLOR> expected(CHECK_MAX_COUNT + 9);
+        std::vector<TRUECOLOR> actual(CHECK_MAX_COUNT + 9);
+
+        unsigned int seed = 12345;
+        int differences = 0;
+        for (int i=0; i<CHECK_RUNS; i++)
+        {
+            CheckRun run;
+            pickCheckRun(seed, textureWidth, textureHeight, run);
+
+            const int offset = 1 + (run.u & 7);
+            std::fill(expected.begin(), expected.end(), 0);
+            std::fill(actual.begin(), actual.end(), 0);
+            const TRUECOLOR color = (TRUECOLOR)run.v | 0xff000000;
+            scalar.fillRun(&expected[offset], run.count, color);
+            kernels.fillRun(&actual[offset], run.count, color);
+            differences += countDifferences(expected, actual, (int)expected.size());
+
+            std::fill(actual.begin(), actual.end(), 0);
+            kernels.streamFillRun(&actual[offset], run.count, color);
+            differences += countDifferences(expected, actual, (int)expected.size());
+
+            scalar.drawRun(&expected[0], run.count, run.u, run.v, run.du, run.dv, texels, textureWidth);
+            kernels.drawRun(&actual[0], run.count, run.u, run.v, run.du, run.dv, texels, textureWidth);
+            differences += countDifferences(expected, actual, run.count);
+
+            if (tiled)
+            {
+                scalar.drawRunTiled(&expected[0], run.count, run.u, run.v, run.du, run.dv, texels, textureWidth);
+                kernels.drawRunTiled(&actual[0], run.count, run.u, run.v, run.du, run.dv, texels, textureWidth);
+                differences += countDifferences(expected, actual, run.count);
+            }
+
+            if (shift >= 0)
+            {
+                const int vShift = FIXED_BITS - shift;
+                const int maskU = textureWidth - 1;
+                const int maskV = (textureHeight - 1) << shift;
+
+                scalar.drawRunWrapped(&expected[0], run.count, run.wrappedU, run.wrappedV, run.wrappedDu, run.wrappedDv,
+                                      texels, vShift, maskU, maskV);
+                kernels.drawRunWrapped(&actual[0], run.count, run.wrappedU, run.wrappedV, run.wrappedDu, run.wrappedDv,
+                                       texels, vShift, maskU, maskV);
+                differences += countDifferences(expected, actual, run.count);
+
+                if (tiled)
+                {
+                    scalar.drawRunTiledWrapped(&expected[0], run.count, run.wrappedU, run.wrappedV, run.wrappedDu, run.wrappedDv,
+                                               texels, shift, maskU, textureHeight - 1);
+                    kernels.drawRunTiledWrapped(&actual[0], run.count, run.wrappedU, run.wrappedV, run.wrappedDu, run.wrappedDv,
+                                                texels, shift, maskU, textureHeight - 1);
+                    differences += countDifferences(expected, actual, run.count);
+                }
+            }
+        }
+        return differences + checkTransformVertices(scalar, kernels);
+    }
+
+
+    int checkIndexedSpanKernels(SpanKernelLevel level, const unsigned char* indices, const TRUECOLOR* palette,
+                                int textureWidth, int textureHeight)
+    {
+        if (!isSpanKernelSupported(level))
+            return 0;
+
+        const SpanKernels& scalar = spanKernelTable[SPAN_KERNEL_SCALAR];
+        const SpanKernels& kernels = spanKernelTable[level];
+
+        const int shift = getWrapShift(textureWidth, textureHeight);
+
+        std::vector<TRUECOLOR> expected(CHECK_MAX_COUNT);
+        std::vector<TRUECOLOR> actual(CHECK_MAX_COUNT);
+
+        unsigned int seed = 12345;
+        int differences = 0;
+        for (int i=0; i<CHECK_RUNS; i++)
+        {
+            CheckRun run;
+            pickCheckRun(seed, textureWidth, textureHeight, run);
+
+            scalar.drawRunIndexed(&expected[0], run.count, run.u, run.v, run.du, run.dv, indices, textureWidth, palette);
+            kernels.drawRunIndexed(&actual[0], run.count, run.u, run.v, run.du, run.dv, indices, textureWidth, palette);
+            differences += countDifferences(expected, actual, run.count);
+
+            if (shift >= 0)
+            {
+                const int vShift = FIXED_BITS - shift;
+                const int maskU = textureWidth - 1;
+                const int maskV = (textureHeight - 1) << shift;
+
+                scalar.drawRunIndexedWrapped(&expected[0], run.count, run.wrappedU, run.wrappedV, run.wrappedDu, run.wrappedDv,
+                                             indices, vShift, maskU, maskV, palette);
+                kernels.drawRunIndexedWrapped(&actual[0], run.count, run.wrappedU, run.wrappedV, run.wrappedDu, run.wrappedDv,
+                                              indices, vShift, maskU, maskV, palette);
+                differences += countDifferences(expected, actual, run.count);
+            }
+        }
+        return differences;
+    }
+}
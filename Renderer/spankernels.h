@@ -0,0 +1,117 @@
+#ifndef SPANKERNELS_H
+#define SPANKERNELS_H
+
+#include "primitives.h"
+
+namespace Quokka3D
+{
+    // The inner loops of the textured span drawing: each draws count pixels
+    // into dest, stepping the 16.16 texture location (u, v) by (du, dv) per
+    // pixel. There are scalar, SSE4.1 and AVX2 (8 pixels per gather) versions,
+    // all giving identical results.
+
+    // Textures of any size, addressed as v * textureWidth + u. The caller keeps
+    // the location inside the texture.
+    typedef void (*TexturedRunFunc)(TRUECOLOR* dest, int count, int u, int v, int du, int dv,
+                                    const TRUECOLOR* texels, int textureWidth);
+
+    // Power of two textures, tiled: the texel is ((v >> vShift) & maskV) +
+    // ((u >> 16) & maskU), where vShift is 16 less log2 of the texture width and
+    // maskV is already shifted to the row offset.
+    typedef void (*WrappedRunFunc)(TRUECOLOR* dest, int count, int u, int v, int du, int dv,
+                                   const TRUECOLOR* texels, int vShift, int maskU, int maskV);
+
+    // Textures stored in 4x4 texel tiles (see Texture::setTiled), rows of
+    // tiles one after another: the texel is at (y & ~3) * textureWidth +
+    // (x & ~3) * 4 + (y & 3) * 4 + (x & 3). textureWidth is a multiple of 4.
+    typedef TexturedRunFunc TiledRunFunc;
+
+    // Tiled power of two textures with wrap around: x is (u >> 16) & maskU and
+    // y is (v >> 16) & maskV, and widthShift is log2 of the texture width.
+    typedef void (*TiledWrappedRunFunc)(TRUECOLOR* dest, int count, int u, int v, int du, int dv,
+                                        const TRUECOLOR* texels, int widthShift, int maskU, int maskV);
+
+    // Indexed textures, 8 bits per texel: the texel is palette[indices[i]], with
+    // i as for TexturedRunFunc and WrappedRunFunc. The 3 bytes after the last
+    // index must be readable (the AVX2 kernels fetch whole words).
+    typedef void (*IndexedRunFunc)(TRUECOLOR* dest, int count, int u, int v, int du, int dv,
+                                   const unsigned char* indices, int textureWidth, const TRUECOLOR* palette);
+    typedef void (*IndexedWrappedRunFunc)(TRUECOLOR* dest, int count, int u, int v, int du, int dv,
+                                          const unsigned char* indices, int vShift, int maskU, int maskV,
+                                          const TRUECOLOR* palette);
+
+    // Solid spans: count pixels of color.
+    typedef void (*FillRunFunc)(TRUECOLOR* dest, int count, TRUECOLOR color);
+
+    // streamFillRun is the same with non-temporal stores, which write whole
+    // cache lines straight to memory rather than reading them into the caches
+    // first and evicting other data. It is for clearing buffers bigger than the
+    // caches; the pixels are slow to read back afterwards.
+
+    // Vertices in separate x, y and z arrays (see VertexPool), with room for
+    // the results of their transform.
+    struct VertexArrays
+    {
+        const float* x;
+        const float* y;
+        const float* z;
+        float* viewX;           // moved by the matrix
+        float* viewY;
+        float* viewZ;
+        float* screenX;         // projected
+        float* screenY;
+    };
+
+    // The per frame vertex pass: count vertices are moved by matrix (the rows
+    // of a Matrix3x4) and projected as ViewWindow::project does, distance *
+    // x / -z + centerX and centerY - distance * y / -z. The screen coordinates
+    // of vertices with a view z of 0 or more are meaningless.
+    typedef void (*TransformVerticesFunc)(const VertexArrays& vertices, int count, const float matrix[3][4],
+                                          float distance, float centerX, float centerY);
+
+    enum SpanKernelLevel
+    {
+        SPAN_KERNEL_SCALAR,
+        SPAN_KERNEL_SSE41,
+        SPAN_KERNEL_AVX2,
+        SPAN_KERNEL_LEVELS
+    };
+
+    struct SpanKernels
+    {
+        SpanKernelLevel level;
+        const char* name;
+        TexturedRunFunc drawRun;
+        WrappedRunFunc drawRunWrapped;
+        TiledRunFunc drawRunTiled;
+        TiledWrappedRunFunc drawRunTiledWrapped;
+        IndexedRunFunc drawRunIndexed;
+        IndexedWrappedRunFunc drawRunIndexedWrapped;
+        FillRunFunc fillRun;
+        FillRunFunc streamFillRun;
+        TransformVerticesFunc transformVertices;
+    };
+
+    bool isSpanKernelSupported(SpanKernelLevel level);     // by this build and CPU
+    SpanKernelLevel getBestSpanKernelLevel();
+
+    // The kernels for level, or the best supported level below it.
+    const SpanKernels& getSpanKernels(SpanKernelLevel level);
+    const SpanKernels& getSpanKernels();                    // the best supported
+
+    // Draws pseudo-random runs over texels (textureWidth x textureHeight) with
+    // the kernels of level and compares the pixels with the scalar kernels'.
+    // Solid runs, plain and streamed, are checked too (including that they
+    // stay inside the run), and the vertex transform (counting differing
+    // vertices).
+    // The tiled kernels are checked too when the sides are multiples of 4 (the
+    // texels are read as tiled then). Returns the number of differing pixels
+    // (0 if level isn't supported).
+    int checkSpanKernels(SpanKernelLevel level, const TRUECOLOR* texels, int textureWidth, int textureHeight);
+
+    // The same for the indexed kernels, with a 256 entry palette.
+    int checkIndexedSpanKernels(SpanKernelLevel level, const unsigned char* indices, const TRUECOLOR* palette,
+                                int textureWidth, int textureHeight);
+}
+
+#endif  //SPANKERNELS_H
@@ -0,0 +1,233 @@
+#include "texture.h"
+#include <cstring>
+#include <vector>
+
+namespace Quokka3D
+{
+    /*
+        The average of four texels, channel by channel (alpha included) and
+        rounded. Red and blue are summed in one word, alpha and green in another.
+    */
+    static inline TRUECOLOR average4(TRUECOLOR a, TRUECOLOR b, TRUECOLOR c, TRUECOLOR d)
+    {
+        const TRUECOLOR mask = 0x00ff00ff;
+        const TRUECOLOR half = 0x00020002;
+        TRUECOLOR rb = (a & mask) + (b & mask) + (c & mask) + (d & mask) + half;
+        TRUECOLOR ag = ((a >> 8) & mask) + ((b >> 8) & mask) + ((c >> 8) & mask) + ((d >> 8) & mask) + half;
+        return ((rb >> 2) & mask) | (((ag >> 2) & mask) << 8);
+    }
+
+
+    /*
+        Of four palette indices, the one whose color is closest to the average
+        of their colors.
+    */
+    static inline unsigned char closest4(const TRUECOLOR* palette, unsigned char a, unsigned char b,
+                                         unsigned char c, unsigned char d)
+    {
+        const unsigned char candidates[4] = { a, b, c, d };
+        const TRUECOLOR average = average4(palette[a], palette[b], palette[c], palette[d]);
+
+        unsigned char best = a;
+        int bestDistance = -1;
+        for (int i=0; i<4; i++)
+        {
+            const TRUECOLOR color = palette[candidates[i]];
+            int distance = 0;
+            for (int shift=0; shift<32; shift+=8)
+            {
+                int difference = (int)((color >> shift) & 0xff) - (int)((average >> shift) & 0xff);
+                distance += difference * difference;
+            }
+            if (bestDistance < 0 || distance < bestDistance)
+            {
+                best = candidates[i];
+                bestDistance = distance;
+            }
+        }
+        return best;
+    }
+
+
+    static bool canTile(int width, int height)
+    {
+        return (width % 4) == 0 && (height % 4) == 0;
+    }
+
+
+    /*
+        Moves the texels from rows to 4x4 tiles, or back.
+    */
+    static void reorderTexels(TRUECOLOR* texels, int width, int height, bool toTiles)
+    {
+        std::vector<TRUECOLOR> copy(texels, texels + (size_t)width * height);
+        for (int y=0; y<height; y++)
+        {
+            for (int x=0; x<width; x++)
+            {
+                size_t inRows = (size_t)y * width + x;
+                size_t inTiles = (size_t)(y & ~3) * width + ((x & ~3) << 2) + ((y & 3) << 2) + (x & 3);
+                if (toTiles)
+                    texels[inTiles] = copy[inRows];
+                else
+                    texels[inRows] = copy[inTiles];
+            }
+        }
+    }
+
+
+    Texture::Texture(LPNG_Image* image, bool mipMapped)
+    {
+        m_tiled = false;
+        m_image.width = image->width;
+        m_image.height = image->height;
+        m_image.has_palette = image->has_palette;
+        m_image.palette = image->palette;
+        m_image.palette_size = image->palette_size;
+        m_image.data = image->data;
+        m_image.format = image->format;
+
+        image->palette = 0;
+        image->data = 0;
+        delete image;
+
+        if (m_image.has_palette && m_image.data != 0)
+        {
+            // any index is safe to look up, and the kernels can read whole words
+            typedef LPNG_Image::Color Color;
+            Color* fullPalette = new Color[256];
+            memset(fullPalette, 0, 256 * sizeof(Color));
+            if (m_image.palette != 0)
+                memcpy(fullPalette, m_image.palette,
+                       ((m_image.palette_size < 256) ? m_image.palette_size : 256) * sizeof(Color));
+            delete [] m_image.palette;
+            m_image.palette = fullPalette;
+            m_image.palette_size = 256;
+
+            size_t size = (size_t)m_image.width * m_image.height;
+            unsigned char* indices = new unsigned char[size + INDEX_PADDING];
+            memcpy(indices, m_image.data, size);
+            memset(indices + size, 0, INDEX_PADDING);
+            delete [] m_image.data;
+            m_image.data = indices;
+        }
+
+        if (mipMapped)
+            buildMipMaps();
+    }
+
+
+    /*
+        Box filters each level down from the one before (or for indexed
+        textures, picks the closest of the four). Odd sides drop their last
+        row or column.
+    */
+    void Texture::buildMipMaps()
+    {
+        clearMipMaps();
+        if (m_image.data == 0 || m_image.width <= 0 || m_image.height <= 0)
+            return;
+
+        // the levels are filtered in rows
+        const bool tiled = m_tiled;
+        setTiled(false);
+
+        size_t count = 0;
+        for (int w = m_image.width, h = m_image.height; w > 1 || h > 1; )
+        {
+            w = (w > 1) ? w / 2 : 1;
+            h = (h > 1) ? h / 2 : 1;
+            count += (size_t)w * h;
+        }
+        if (m_image.has_palette)
+            m_mipIndices.resize(count + INDEX_PADDING);
+        else
+            m_mipTexels.resize(count);
+
+        Level level = getLevel(0);
+        m_levels.push_back(level);
+
+        TRUECOLOR* dest = m_mipTexels.empty() ? 0 : &m_mipTexels[0];
+        unsigned char* destIndex = m_mipIndices.empty() ? 0 : &m_mipIndices[0];
+        while (level.width > 1 || level.height > 1)
+        {
+            const Level& source = m_levels.back();
+            level.texels = m_image.has_palette ? 0 : dest;
+            level.indices = m_image.has_palette ? destIndex : 0;
+            level.width = (source.width > 1) ? source.width / 2 : 1;
+            level.height = (source.height > 1) ? source.height / 2 : 1;
+
+            // a side that is already 1 texel averages that texel with itself
+            const int stepX = (source.width > 1) ? 1 : 0;
+            const int stepY = (source.height > 1) ? source.width : 0;
+            for (int y=0; y<level.height; y++)
+            {
+                const size_t row = (size_t)(y * 2) * source.width;
+                for (int x=0; x<level.width; x++)
+                {
+                    if (m_image.has_palette)
+                    {
+                        const unsigned char* s = source.indices + row + x * 2;
+                        *destIndex++ = closest4(m_image.palette, s[0], s[stepX], s[stepY], s[stepY + stepX]);
+                    }
+                    else
+                    {
+                        const TRUECOLOR* s = source.texels + row + x * 2;
+                        *dest++ = average4(s[0], s[stepX], s[stepY], s[stepY + stepX]);
+                    }
+                }
+            }
+            m_levels.push_back(level);
+        }
+
+        setTiled(tiled);
+    }
+
+
+    void Texture::clearMipMaps()
+    {
+        m_levels.clear();
+        std::vector<TRUECOLOR>().swap(m_mipTexels);
+        std::vector<unsigned char>().swap(m_mipIndices);
+    }
+
+
+    void Texture::setTiled(bool tiled)
+    {
+        if (tiled == m_tiled || m_image.data == 0 || m_image.has_palette)
+            return;
+
+        if (canTile(m_image.width, m_image.height))
+            reorderTexels((TRUECOLOR*)m_image.data, m_image.width, m_image.height, tiled);
+        for (size_t i=0; i<m_levels.size(); i++)
+        {
+            Level& level = m_levels[i];
+            if (!canTile(level.width, level.height))
+                continue;
+            if (i > 0)
+                reorderTexels((TRUECOLOR*)level.texels, level.width, level.height, tiled);
+            level.tiled = tiled;
+        }
+        m_tiled = tiled;
+    }
+
+
+    Texture::Level Texture::getLevel(int level) const
+    {
+        if (level > 0 && level < (int)m_levels.size())
+            return m_levels[level];
+
+        Level top = { m_image.has_palette ? 0 : (const TRUECOLOR*)m_image.data,
+                      m_image.has_palette ? m_image.data : 0,
+                      m_image.width, m_image.height, m_tiled && canTile(m_image.width, m_image.height) };
+        return top;
+    }
+
+
+    size_t Texture::getBytes() const
+    {
+        if (m_image.has_palette)
+            return (size_t)m_image.width * m_image.height + m_mipIndices.size() + m_image.palette_size * PITCH;
+        return ((size_t)m_image.width * m_image.height + m_mipTexels.size()) * PITCH;
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef TEXTURE_H
+#define TEXTURE_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "primitives.h"
+#include "LightPng/LightPng.h"
+
+namespace Quokka3D
+{
+    // A decoded texture (32-bit texels in the MAKE_RGB32 layout) with its mip
+    // maps. Level 0 is the image itself; each further level halves both sides
+    // (down to 1) by averaging 2x2 texels, ending at 1x1. The levels past 0
+    // are stored one after another in a single block.
+    //
+    // The texels are in rows, or optionally in 4x4 tiles (64 bytes, a cache
+    // line each) with the tiles in rows. Tiles keep texels that are close
+    // vertically close in memory too, so walking through the texture at an
+    // angle touches fewer cache lines. Only levels whose sides are multiples of
+    // 4 are tiled.
+    //
+    // A palettized texture (isIndexed) can instead keep 8 bit palette
+    // indices, a quarter of the memory and bandwidth. Its palette has 256
+    // entries in the texel layout, and each level's mip texels are the one of
+    // the four whose color is closest to their average. Indexed textures stay
+    // in rows, and each level is followed by INDEX_PADDING spare bytes for the
+    // span kernels.
+    //
+    // The texels are only read through getLevel, so they stay in step with
+    // the mip levels and the tiled layout.
+    class Texture
+    {
+    public:
+        struct Level
+        {
+            const TRUECOLOR* texels;        // null for indexed textures
+            const unsigned char* indices;   // palette indices, null for others
+            int width;
+            int height;
+            bool tiled;             // in 4x4 tiles, see spankernels.h for the addressing
+        };
+
+        static const int INDEX_PADDING = 3;
+
+        Texture() : m_tiled(false) {}
+        // Takes over the image's texels (and palette) and deletes image. If it
+        // has a palette, the data must be 8 bit indices.
+        explicit Texture(LPNG_Image* image, bool mipMapped = true);
+
+        void buildMipMaps();        // after the texels change
+        void clearMipMaps();        // leaves level 0 only
+
+        void setTiled(bool tiled);  // converts the texels to tiles or back to rows
+        bool isTiled() const { return m_tiled; }
+
+        int getWidth() const { return m_image.width; }
+        int getHeight() const { return m_image.height; }
+        bool isIndexed() const { return m_image.has_palette; }
+        const TRUECOLOR* getPalette() const { return m_image.palette; }     // 256 entries if indexed
+
+        int getNumLevels() const { return m_levels.empty() ? 1 : (int)m_levels.size(); }
+        Level getLevel(int level) const;
+        size_t getBytes() const;    // texel bytes of all the levels
+
+    private:
+        Texture(const Texture&);                // not copyable
+        Texture& operator=(const Texture&);
+
+        LPNG_Image m_image;                     // level 0, and the palette
+        std::vector<Level> m_levels;            // all levels, empty if not mip mapped
+        std::vector<TRUECOLOR> m_mipTexels;     // levels 1 and up
+        std::vector<unsigned char> m_mipIndices;    // levels 1 and up of indexed textures
+        bool m_tiled;
+    };
+
+
+    // A texture shared between renderers and polygons. The texture is freed
+    // when the last handle goes away.
+    typedef std::shared_ptr<Texture> TextureHandle;
+}
+
+#endif  //TEXTURE_H
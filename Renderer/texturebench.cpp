@@ -0,0 +1,127 @@
+// texturebench.cpp : Measures the fill rate of a textured wall rolling through
+// half a turn in front of the camera, with the texture stored in rows and in
+// 4x4 tiles. Usage: texturebench [texture.png]
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <vector>
+#include "vector3d.h"
+#include "primitives.h"
+#include "framebuffer.h"
+#include "viewwindow.h"
+#include "texture.h"
+#include "texturecache.h"
+#include "texturedpolygon3d.h"
+#include "SimpleTexturedPolygonRenderer.h"
+
+using namespace Quokka3D;
+
+const int width = 640;
+const int height = 480;
+
+
+// A texture of pseudo-random texels, too big for the caches
+static TextureHandle createTexture(int size)
+{
+    LPNG_Image* image = new LPNG_Image();
+    image->width = size;
+    image->height = size;
+    image->format = LPNG_Format_XRGB32;
+    image->data = new unsigned char[size * size * PITCH];
+
+    TRUECOLOR* texels = (TRUECOLOR*)image->data;
+    unsigned int seed = 12345;
+    for (int i=0; i<size*size; i++)
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        texels[i] = seed | 0xff000000;     // never the cleared screen's 0
+    }
+    return TextureHandle(new Texture(image));
+}
+
+
+// Draws the wall frames times, three times over, and returns the best rate
+// in pixels drawn per second
+static double measureFillRate(SimpleTexturedPolygonRenderer& renderer, const TexturedPolygon3D& wall, int frames)
+{
+    renderer.startFrame();
+    TexturedPolygon3D poly = wall;
+    renderer.draw(&poly);
+
+    const FrameBuffer& frameBuffer = renderer.getFrameBuffer();
+    int covered = 0;
+    for (int y=0; y<frameBuffer.getHeight(); y++)
+        for (int x=0; x<frameBuffer.getWidth(); x++)
+            covered += (frameBuffer.getRow(y)[x] != 0);
+
+    double best = 0;
+    for (int repeat=0; repeat<3; repeat++)
+    {
+        clock_t before = clock();
+        for (int i=0; i<frames; i++)
+        {
+            renderer.startFrame();
+            poly = wall;
+            renderer.draw(&poly);
+        }
+        double seconds = (double)(clock() - before) / CLOCKS_PER_SEC;
+
+        if (seconds > 0 && (double)covered * frames / seconds > best)
+            best = (double)covered * frames / seconds;
+    }
+    return best;
+}
+
+
+int main(int argc, char* argv[])
+{
+    TextureHandle texture = (argc > 1) ? TextureCache::getDefault().get(argv[1]) : createTexture(2048);
+    if (!texture)
+    {
+        fprintf(stderr, "Error loading %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    MemoryFrameBuffer frameBuffer(width, height);      // drawn to, never shown
+    ViewWindow view(0, 0, width, height, DegToRad(75));
+    Transform3D camera(0, 0, 0);
+    SimpleTexturedPolygonRenderer renderer(frameBuffer, camera, view, texture);
+    renderer.setMipMapping(false);      // the full size texture, one texel or more a pixel
+
+    // a wall somewhat bigger than the screen
+    float size = (float)texture->getWidth();
+    float distance = size * 0.4f;
+    TexturedPolygon3D wall(Vector3D(-size/2, size/2, -distance),
+                           Vector3D(-size/2, -size/2, -distance),
+                           Vector3D(size/2, -size/2, -distance),
+                           Vector3D(size/2, size/2, -distance));
+
+    const int frames = 100;
+    printf("%dx%d texture, %s kernels, %d frames per angle\n",
+           texture->getWidth(), texture->getHeight(), getSpanKernels().name, frames);
+    printf("angle   rows Mpix/s  tiles Mpix/s  tiles/rows\n");
+
+    double totalRows = 0;
+    double totalTiles = 0;
+    for (int degrees=0; degrees<=180; degrees+=15)
+    {
+        renderer.getCamera().setAngle(0, 0, DegToRad((float)degrees));
+
+        texture->setTiled(false);
+        double rows = measureFillRate(renderer, wall, frames) / 1e6;
+        texture->setTiled(true);
+        double tiles = measureFillRate(renderer, wall, frames) / 1e6;
+
+        printf("%5d %13.1f %13.1f %11.2f\n", degrees, rows, tiles, (rows > 0) ? tiles / rows : 0);
+        totalRows += rows;
+        totalTiles += tiles;
+    }
+    printf("mean  %13.1f %13.1f %11.2f\n", totalRows / 13, totalTiles / 13, totalTiles / totalRows);
+
+    return 0;
+}
@@ -0,0 +1,191 @@
+#include "texturecache.h"
+#include "textureloader.h"
+#include "primitives.h"
+#include "mappedfile.h"
+#include <cstring>
+
+namespace Quokka3D
+{
+    /*
+        A 64 bit hash of the file contents, 8 bytes at a time. Combined with the
+        size it identifies a texture file.
+    */
+    static unsigned long long hashData(const unsigned char* data, size_t size)
+    {
+        const unsigned long long prime = 0x100000001b3ULL;
+        unsigned long long hash = 0xcbf29ce484222325ULL;
+
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8)
+        {
+            unsigned long long word;
+            memcpy(&word, data + i, 8);
+            hash = (hash ^ word) * prime;
+            hash ^= hash >> 29;
+        }
+        for (; i < size; i++)
+            hash = (hash ^ data[i]) * prime;
+
+        return hash ^ (hash >> 32);
+    }
+
+
+    TextureCache::TextureCache(size_t budget)
+    {
+        m_budget = budget;
+        m_keepPalettes = false;
+        m_env = LZ_NewEnv();
+        resetStats();
+        m_stats.numTextures = 0;
+        m_stats.bytesResident = 0;
+    }
+
+
+    /*
+        Textures still in use stay valid; their handles free them.
+    */
+    TextureCache::~TextureCache()
+    {
+        LZ_DeleteEnv(m_env);
+    }
+
+
+    /*
+        Looks the texture up by path, then by contents, and decodes it only if
+        neither is cached.
+    */
+    TextureHandle TextureCache::get(const std::string& fileName)
+    {
+        std::map<std::string, EntryList::iterator>::iterator found = m_byFileName.find(fileName);
+        if (found != m_byFileName.end())
+        {
+            m_stats.hits++;
+            touch(found->second);
+            return found->second->texture;
+        }
+
+        Entry entry;
+        entry.hasContentKey = false;
+        LPNG_Image* image;
+
+        MappedFile mapping;
+        if (mapping.open(fileName))
+        {
+            entry.hasContentKey = true;
+            entry.contentKey.first = hashData(mapping.getData(), mapping.getSize());
+            entry.contentKey.second = mapping.getSize();
+
+            std::map<std::pair<unsigned long long, size_t>, EntryList::iterator>::iterator same =
+                m_byContent.find(entry.contentKey);
+            if (same != m_byContent.end())
+            {
+                // another path to a file already loaded
+                m_stats.hits++;
+                same->second->fileNames.push_back(fileName);
+                m_byFileName[fileName] = same->second;
+                touch(same->second);
+                return same->second->texture;
+            }
+
+            image = decodeTexture(mapping.getData(), mapping.getSize(), m_env, m_keepPalettes);
+        }
+        else
+        {
+            image = loadTextureFile(fileName, m_env, m_keepPalettes);
+        }
+
+        m_stats.misses++;
+        if (image == 0)
+            return TextureHandle();
+
+        entry.texture = TextureHandle(new Texture(image));
+        entry.bytes = entry.texture->getBytes();
+        entry.fileNames.push_back(fileName);
+
+        m_entries.push_front(entry);
+        m_byFileName[fileName] = m_entries.begin();
+        if (entry.hasContentKey)
+            m_byContent[entry.contentKey] = m_entries.begin();
+        m_stats.numTextures++;
+        m_stats.bytesResident += entry.bytes;
+
+        // the new texture is held by entry, so it is never evicted here
+        trim();
+
+        return entry.texture;
+    }
+
+
+    void TextureCache::setBudget(size_t budget)
+    {
+        m_budget = budget;
+        trim();
+    }
+
+
+    void TextureCache::trim()
+    {
+        if (m_budget > 0)
+            evictUnused(m_budget);
+    }
+
+
+    void TextureCache::clear()
+    {
+        evictUnused(0);
+    }
+
+
+    void TextureCache::resetStats()
+    {
+        m_stats.hits = 0;
+        m_stats.misses = 0;
+        m_stats.evictions = 0;
+    }
+
+
+    TextureCache& TextureCache::getDefault()
+    {
+        static TextureCache cache;
+        return cache;
+    }
+
+
+    /*
+        Moves the entry to the front of the LRU list.
+    */
+    void TextureCache::touch(EntryList::iterator entry)
+    {
+        m_entries.splice(m_entries.begin(), m_entries, entry);
+    }
+
+
+    void TextureCache::evict(EntryList::iterator entry)
+    {
+        for (size_t i=0; i<entry->fileNames.size(); i++)
+            m_byFileName.erase(entry->fileNames[i]);
+        if (entry->hasContentKey)
+            m_byContent.erase(entry->contentKey);
+
+        m_stats.evictions++;
+        m_stats.numTextures--;
+        m_stats.bytesResident -= entry->bytes;
+        m_entries.erase(entry);
+    }
+
+
+    /*
+        Evicts the least recently used textures that only the cache holds until
+        no more than limit bytes are resident (or nothing more can be evicted).
+    */
+    void TextureCache::evictUnused(size_t limit)
+    {
+        EntryList::iterator entry = m_entries.end();
+        while (m_stats.bytesResident > limit && entry != m_entries.begin())
+        {
+            --entry;
+            if (entry->texture.use_count() == 1)
+                evict(entry++);
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef TEXTURECACHE_H
+#define TEXTURECACHE_H
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "texture.h"
+#include "LightPng/LightPng.h"
+#include "LightPng/LightZ.h"
+
+namespace Quokka3D
+{
+    // Loads each texture once and hands out shared handles to it. Textures are
+    // found by path, and files with identical contents under different paths
+    // share one decoded copy, mip mapped as it is loaded. Textures nobody else
+    // holds a handle to are kept for reuse and evicted least recently used
+    // first once the cache is over its budget. Not thread safe.
+    class TextureCache
+    {
+    public:
+        struct Stats
+        {
+            int hits;               // textures found without decoding
+            int misses;             // textures decoded
+            int evictions;          // textures dropped to stay within the budget
+            int numTextures;        // textures in the cache
+            size_t bytesResident;   // texel bytes of the textures (and mip maps) in the cache
+        };
+
+        explicit TextureCache(size_t budget = 0);       // budget in bytes, 0 = no limit
+        ~TextureCache();
+
+        // Returns the texture, loading it if it isn't cached. Null on error.
+        TextureHandle get(const std::string& fileName);
+
+        void setBudget(size_t budget);
+        size_t getBudget() const { return m_budget; }
+
+        // Palettized textures loaded from now on keep their 8 bit indices
+        // instead of being expanded (see Texture). Off by default.
+        void setKeepPalettes(bool keep) { m_keepPalettes = keep; }
+        bool getKeepPalettes() const { return m_keepPalettes; }
+
+        void trim();                // evicts textures not in use until within the budget
+        void clear();               // evicts all textures not in use
+
+        const Stats& getStats() const { return m_stats; }
+        void resetStats();          // clears the hit/miss/eviction counts
+
+        static TextureCache& getDefault();      // the cache shared by the renderers
+
+    private:
+        TextureCache(const TextureCache&);              // not copyable
+        TextureCache& operator=(const TextureCache&);
+
+        struct Entry
+        {
+            TextureHandle texture;
+            size_t bytes;
+            bool hasContentKey;
+            std::pair<unsigned long long, size_t> contentKey;   // hash and size of the file
+            std::vector<std::string> fileNames;                 // paths that refer to it
+        };
+        typedef std::list<Entry> EntryList;
+
+        void touch(EntryList::iterator entry);
+        void evict(EntryList::iterator entry);
+        void evictUnused(size_t limit);
+
+        EntryList m_entries;        // most recently used first
+        std::map<std::string, EntryList::iterator> m_byFileName;
+        std::map<std::pair<unsigned long long, size_t>, EntryList::iterator> m_byContent;
+        size_t m_budget;
+        bool m_keepPalettes;
+        Stats m_stats;
+        LightZ_Env* m_env;
+    };
+}
+
+#endif  //TEXTURECACHE_H
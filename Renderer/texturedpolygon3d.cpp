@@ -0,0 +1,51 @@
+#include "texturedpolygon3d.h"
+
+using namespace Quokka3D;
+
+/*
+        Sets the texture and calculates the texture bounds from the
+        polygon's vertices.
+*/
+void TexturedPolygon3D::setTexture(const TextureHandle& texture)
+{
+    m_texture = texture;
+    calcTextureBounds();
+}
+
+
+/*
+        Sets the texture and the rectangle it is mapped to.
+*/
+void TexturedPolygon3D::setTexture(const TextureHandle& texture, const Rectangle3D& bounds)
+{
+    m_texture = texture;
+    m_textureBounds = bounds;
+}
+
+
+/*
+        Puts the texture's top left corner on the first vertex, with U
+        pointing toward the last vertex and V toward the second, one
+        texel per unit.
+*/
+void TexturedPolygon3D::calcTextureBounds()
+{
+    if (getNumVertices() < 3)
+        return;
+    m_textureBounds = calcTextureBounds(*this, m_texture);
+}
+
+
+Rectangle3D TexturedPolygon3D::calcTextureBounds(const Polygon3D& poly, const TextureHandle& texture)
+{
+    int last = poly.getNumVertices() - 1;
+
+    Vector3D directionU = poly[last];
+    directionU -= poly[0];
+    Vector3D directionV = poly[1];
+    directionV -= poly[0];
+
+    float width = texture ? (float)texture->getWidth() : 0.0f;
+    float height = texture ? (float)texture->getHeight() : 0.0f;
+    return Rectangle3D(poly[0], directionU, directionV, width, height);
+}
@@ -0,0 +1,50 @@
+#ifndef texturedpolygon3d_h
+#define texturedpolygon3d_h
+
+#include "vector3d.h"
+#include "polygon3D.h"
+#include "rectangle3D.h"
+#include "texture.h"
+
+
+namespace Quokka3D
+{
+    // A polygon with a texture and the rectangle (texture bounds) that maps the
+    // texture onto its plane. The bounds are worked out once when the texture is
+    // set, so drawing only has to transform them by the camera.
+    class TexturedPolygon3D : public Polygon3D
+    {
+    public:
+        TexturedPolygon3D() : Polygon3D() {}
+        TexturedPolygon3D(const Vector3D& v0, const Vector3D& v1, const Vector3D& v2) : Polygon3D(v0, v1, v2) { calcTextureBounds(); }
+        TexturedPolygon3D(const Vector3D& v0, const Vector3D& v1, const Vector3D& v2, const Vector3D& v3) : Polygon3D(v0, v1, v2, v3) { calcTextureBounds(); }
+        TexturedPolygon3D(const Vec3DArray& v) : Polygon3D(v) { calcTextureBounds(); }
+
+        // Sets the texture (null draws the renderer's texture), with bounds from
+        // calcTextureBounds.
+        void setTexture(const TextureHandle& texture);
+        void setTexture(const TextureHandle& texture, const Rectangle3D& bounds);
+
+        const TextureHandle& getTexture() const { return m_texture; }
+        Rectangle3D& getTextureBounds() { return m_textureBounds; }
+        const Rectangle3D& getTextureBounds() const { return m_textureBounds; }
+
+        // Puts the texture's top left corner on the first vertex, its top edge
+        // toward the last vertex and its left edge toward the second. Call again
+        // after moving the vertices.
+        void calcTextureBounds();
+
+        // The same bounds for any polygon of 3 or more vertices, e.g. a plain
+        // Polygon3D drawn with a renderer's texture
+        static Rectangle3D calcTextureBounds(const Polygon3D& poly, const TextureHandle& texture);
+
+    protected:
+    private:
+        TextureHandle m_texture;            // null to use the renderer's texture
+        Rectangle3D m_textureBounds;        // in the polygon's (object) space
+
+    };
+
+}
+
+#endif // texturedpolygon3d_h
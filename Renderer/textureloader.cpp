@@ -0,0 +1,208 @@
+#include "textureloader.h"
+#include "primitives.h"
+#include "mappedfile.h"
+#include <cstdio>
+#include <cstring>
+
+namespace Quokka3D
+{
+    /*
+        Receives the texture rows from the png stream (user is the texture
+        being built). The texture's has_palette is set beforehand if palettized
+        images are to keep their 8 bit indices.
+    */
+    static void storeTextureRow(void* user, const LPNG_Image* info, int y, const unsigned char* row)
+    {
+        LPNG_Image* texture = (LPNG_Image*)user;
+        if (texture->data == 0)
+        {
+            texture->width = info->width;
+            texture->height = info->height;
+            texture->format = info->format;
+            texture->has_palette = texture->has_palette && info->has_palette;
+            if (texture->has_palette)
+            {
+                texture->palette_size = info->palette_size;
+                texture->palette = new LPNG_Image::Color[info->palette_size];
+                memcpy(texture->palette, info->palette, info->palette_size * sizeof(LPNG_Image::Color));
+                texture->data = new unsigned char[info->width * info->height];
+            }
+            else
+            {
+                texture->data = new unsigned char[info->width * info->height * PITCH];
+            }
+        }
+
+        if (texture->has_palette)
+        {
+            memcpy(texture->data + y * texture->width, row, texture->width);
+            return;
+        }
+
+        TRUECOLOR* dest = (TRUECOLOR*)texture->data + y * texture->width;
+        if (info->has_palette)
+        {
+            // palette entries are 0xAARRGGBB, the same layout as the texels
+            for (int x=0; x<info->width; x++)
+                dest[x] = info->palette[row[x]];
+        }
+        else
+        {
+            memcpy(dest, row, info->width * PITCH);
+        }
+    }
+
+
+    LPNG_Image* decodeTexture(const unsigned char* data, size_t size, LightZ_Env* env, bool keepPalette)
+    {
+        // Decode the png straight into the frame buffer's 32-bit XRGB layout.
+        // Besides the texture itself only a couple of rows and the inflate window
+        // are held in memory.
+        LPNG_Image* texture = new LPNG_Image();
+        texture->has_palette = keepPalette;
+        LPNG_Stream* stream = LPNG_NewStream(storeTextureRow, texture, LPNG_Format_XRGB32, env);
+        bool ok = (stream != 0);
+
+        while (ok && size > 0)
+        {
+            int len = (size < (1u << 30)) ? (int)size : (1 << 30);
+            ok = LPNG_StreamFeed(stream, data, len);
+            data += len;
+            size -= len;
+        }
+        ok = ok && LPNG_StreamDone(stream);
+
+        LPNG_DeleteStream(stream);
+
+        if (!ok)
+        {
+            delete texture;
+            return 0;
+        }
+        return texture;
+    }
+
+
+    LPNG_Image* loadTextureFile(const std::string& fileName, LightZ_Env* env, bool keepPalette)
+    {
+        // The compressed data is inflated straight from a read-only mapping of the
+        // file. If the file can't be mapped, it is read and decoded in pieces.
+        MappedFile mapping;
+        if (mapping.open(fileName))
+            return decodeTexture(mapping.getData(), mapping.getSize(), env, keepPalette);
+
+        LPNG_Image* texture = new LPNG_Image();
+        texture->has_palette = keepPalette;
+        LPNG_Stream* stream = LPNG_NewStream(storeTextureRow, texture, LPNG_Format_XRGB32, env);
+        bool ok = (stream != 0);
+
+        FILE* f = fopen(fileName.c_str(), "rb");
+        ok = ok && (f != 0);
+
+        std::vector<char> buffer(64 * 1024);
+        size_t len;
+        while (ok && (len = fread(&buffer[0], 1, buffer.size(), f)) > 0)
+        {
+            ok = LPNG_StreamFeed(stream, &buffer[0], (int)len);
+        }
+        if (f != 0)
+            fclose(f);
+        ok = ok && LPNG_StreamDone(stream);
+
+        LPNG_DeleteStream(stream);
+
+        if (!ok)
+        {
+            delete texture;
+            return 0;
+        }
+        return texture;
+    }
+
+
+    /*
+        Starts the worker threads.
+    */
+    TextureLoader::TextureLoader(int numThreads)
+    {
+        m_quit = false;
+
+        if (numThreads <= 0)
+            numThreads = (int)std::thread::hardware_concurrency();
+        if (numThreads <= 0)
+            numThreads = 1;
+
+        for (int i=0; i<numThreads; i++)
+            m_threads.push_back(std::thread(&TextureLoader::work, this));
+    }
+
+
+    /*
+        Lets the workers finish the queued loads and stops them.
+    */
+    TextureLoader::~TextureLoader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_quit = true;
+        }
+        m_jobAdded.notify_all();
+
+        for (size_t i=0; i<m_threads.size(); i++)
+            m_threads[i].join();
+    }
+
+
+    std::future<TextureHandle> TextureLoader::load(const std::string& fileName, bool keepPalette)
+    {
+        Job job;
+        job.fileName = fileName;
+        job.keepPalette = keepPalette;
+        std::future<TextureHandle> texture = job.texture.get_future();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.push_back(std::move(job));
+        }
+        m_jobAdded.notify_one();
+
+        return texture;
+    }
+
+
+    /*
+        The worker thread: decodes and mip maps queued textures, with its own
+        LightZ environment, until told to quit and the queue is empty.
+    */
+    void TextureLoader::work()
+    {
+        LightZ_Env* env = LZ_NewEnv();
+
+        for (;;)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                while (m_jobs.empty() && !m_quit)
+                    m_jobAdded.wait(lock);
+                if (m_jobs.empty())
+                    break;
+
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+            }
+
+            try
+            {
+                LPNG_Image* image = loadTextureFile(job.fileName, env, job.keepPalette);
+                job.texture.set_value(image ? TextureHandle(new Texture(image)) : TextureHandle());
+            }
+            catch (...)
+            {
+                job.texture.set_exception(std::current_exception());
+            }
+        }
+
+        LZ_DeleteEnv(env);
+    }
+}
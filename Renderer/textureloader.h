@@ -0,0 +1,63 @@
+#ifndef TEXTURELOADER_H
+#define TEXTURELOADER_H
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "texture.h"
+#include "LightPng/LightPng.h"
+#include "LightPng/LightZ.h"
+
+namespace Quokka3D
+{
+    // Decodes a png file into a texture in the frame buffer's 32-bit XRGB layout.
+    // Palettized images are expanded, unless keepPalette is set: then they keep
+    // their 8 bit indices and palette (see Texture). env is the LightZ
+    // environment to use; it must not be in use by another thread. Returns null
+    // on error; the caller owns the texture.
+    LPNG_Image* loadTextureFile(const std::string& fileName, LightZ_Env* env = 0, bool keepPalette = false);
+
+    // Same as loadTextureFile, for a png already in memory.
+    LPNG_Image* decodeTexture(const unsigned char* data, size_t size, LightZ_Env* env = 0, bool keepPalette = false);
+
+
+    // Decodes textures on a pool of worker threads, each with its own LightZ
+    // environment, so that loading many textures scales with the core count.
+    class TextureLoader
+    {
+    public:
+        explicit TextureLoader(int numThreads = 0);     // 0 = one per hardware thread
+        ~TextureLoader();                               // finishes the queued loads
+
+        // Queues a texture for loading. The future yields the texture, mip mapped
+        // on the worker thread, or null on error.
+        std::future<TextureHandle> load(const std::string& fileName, bool keepPalette = false);
+
+        int getNumThreads() const { return (int)m_threads.size(); }
+
+    private:
+        TextureLoader(const TextureLoader&);            // not copyable
+        TextureLoader& operator=(const TextureLoader&);
+
+        struct Job
+        {
+            std::string fileName;
+            bool keepPalette;
+            std::promise<TextureHandle> texture;
+        };
+
+        void work();
+
+        std::vector<std::thread> m_threads;
+        std::deque<Job> m_jobs;
+        std::mutex m_mutex;                 // guards m_jobs and m_quit
+        std::condition_variable m_jobAdded;
+        bool m_quit;
+    };
+}
+
+#endif  //TEXTURELOADER_H
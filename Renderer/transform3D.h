@@ -1,171 +1,334 @@
-#ifndef Transform3D_h
-#define Transform3D_h
-
-#include "vector3d.h"
-
-namespace Quokka3D
-{
-    //*****************************************************************
-    //
-    // The Transform3D class represents a rotation and translation
-    //
-    //*****************************************************************
-    class Transform3D
-    {
-    public:
-        Transform3D() { m_location = Vector3D(0.0f, 0.0f, 0.0f); setAngle(0.0f, 0.0f, 0.0f); };
-        Transform3D(float x, float y, float z) { m_location = Vector3D(x, y, z); setAngle(0.0f, 0.0f, 0.0f); }
-
-        // default copy ctor and assignment should be ok as no pointers are used
-
-        Vector3D& getLocation();
-        void setLocation(const Vector3D& v);
-
-        float getCosAngleX() const;
-        float getSinAngleX() const;
-        float getCosAngleY() const;
-        float getSinAngleY() const;
-        float getCosAngleZ() const;
-        float getSinAngleZ() const;
-        
-        float getAngleX() const;
-        float getAngleY() const;
-        float getAngleZ() const;
-
-        void setAngleX(float angleX);
-        void setAngleY(float angleY);
-        void setAngleZ(float angleZ);
-        void setAngle(float angleX, float angleY, float angleZ);
-
-        void rotateAngleX(float angle);
-        void rotateAngleY(float angle);
-        void rotateAngleZ(float angle);
-        void rotateAngle(float angleX, float angleY, float angleZ);
-
-    protected:
-        Vector3D m_location;
-
-    private:
-        float m_cosAngleX;
-        float m_sinAngleX;
-        float m_cosAngleY;
-        float m_sinAngleY;
-        float m_cosAngleZ;
-        float m_sinAngleZ;
-
-    }; // Transform3D
-
-
-    //*****************************************************************
-    //
-    // Inline functions of the Transform3D class 
-    //
-    //*****************************************************************
-    inline Vector3D& Transform3D::getLocation()
-    { 
-        return m_location; 
-    }
-
-    inline void Transform3D::setLocation(const Vector3D& v) 
-    { 
-        m_location = v; 
-    } 
-
-    inline float Transform3D::getCosAngleX() const 
-    { 
-        return m_cosAngleX; 
-    }
-
-    inline float Transform3D::getSinAngleX() const 
-    { 
-        return m_sinAngleX; 
-    }
-
-    inline float Transform3D::getCosAngleY() const 
-    { 
-        return m_cosAngleY; 
-    }
-
-    inline float Transform3D::getSinAngleY() const 
-    { 
-        return m_sinAngleY; 
-    }
-
-    inline float Transform3D::getCosAngleZ() const 
-    { 
-        return m_cosAngleZ; 
-    }
-
-    inline float Transform3D::getSinAngleZ() const 
-    { 
-        return m_sinAngleZ; 
-    }
-
-    inline float Transform3D::getAngleX() const 
-    { 
-        return atan2(m_sinAngleX, m_cosAngleX); 
-    }
-
-    inline float Transform3D::getAngleY() const 
-    { 
-        return atan2(m_sinAngleY, m_cosAngleY); 
-    }
-
-    inline float Transform3D::getAngleZ() const 
-    { 
-        return atan2(m_sinAngleZ, m_cosAngleZ); 
-    }
-
-    inline void Transform3D::setAngleX(float angleX) 
-    { 
-        m_cosAngleX = cos(angleX); 
-        m_sinAngleX = sin(angleX); 
-    }
-
-    inline void Transform3D::setAngleY(float angleY) 
-    { 
-        m_cosAngleY = cos(angleY); 
-        m_sinAngleY = sin(angleY); 
-    }
-
-    inline void Transform3D::setAngleZ(float angleZ) 
-    { 
-        m_cosAngleZ = cos(angleZ); 
-        m_sinAngleZ = sin(angleZ); 
-    }
-
-    inline void Transform3D::setAngle(float angleX, float angleY, float angleZ) 
-    { 
-        setAngleX(angleX); 
-        setAngleY(angleY); 
-        setAngleZ(angleZ); 
-    }
-
-    inline void Transform3D::rotateAngleX(float angle) 
-    { 
-        if (!float_equals(angle, 0.0f)) 
-            setAngleX(getAngleX() + angle); 
-    }
-
-    inline void Transform3D::rotateAngleY(float angle) 
-    { 
-        if (!float_equals(angle, 0.0f)) 
-            setAngleY(getAngleY() + angle); 
-    }
-
-    inline void Transform3D::rotateAngleZ(float angle) 
-    { 
-        if (!float_equals(angle, 0.0f)) 
-            setAngleZ(getAngleZ() + angle); 
-    }
-
-    inline void Transform3D::rotateAngle(float angleX, float angleY, float angleZ)
-    {
-        rotateAngleX(angleX);
-        rotateAngleY(angleY);
-        rotateAngleZ(angleZ);
-    }
-
-} // Quokka3D
-
+#ifndef Transform3D_h
+#define Transform3D_h
+
+#include "vector3d.h"
+
+namespace Quokka3D
+{
+    //*****************************************************************
+    //
+    // A 3x4 matrix: a rotation (the left 3 columns) followed by a
+    // translation (the last column)
+    //
+    //*****************************************************************
+    struct Matrix3x4
+    {
+        float m[3][4];
+
+        void transform(Vector3D& v) const;      // rotates, then translates
+        void rotate(Vector3D& v) const;         // rotates only (directions, normals)
+        void inverseTransform(Vector3D& v) const;   // undoes transform, if the rotation part is a rotation
+
+        void multiply(const Matrix3x4& a, const Matrix3x4& b);  // makes this b, then a (neither is this)
+    };
+
+
+    //*****************************************************************
+    //
+    // The Transform3D class represents a rotation and translation
+    //
+    //*****************************************************************
+    class Transform3D
+    {
+    public:
+        Transform3D() { m_location = Vector3D(0.0f, 0.0f, 0.0f); setAngle(0.0f, 0.0f, 0.0f); }
+        Transform3D(float x, float y, float z) { m_location = Vector3D(x, y, z); setAngle(0.0f, 0.0f, 0.0f); }
+
+        // default copy ctor and assignment should be ok as no pointers are used
+
+        Vector3D& getLocation();
+        void setLocation(const Vector3D& v);
+
+        float getCosAngleX() const;
+        float getSinAngleX() const;
+        float getCosAngleY() const;
+        float getSinAngleY() const;
+        float getCosAngleZ() const;
+        float getSinAngleZ() const;
+        
+        float getAngleX() const;
+        float getAngleY() const;
+        float getAngleZ() const;
+
+        void setAngleX(float angleX);
+        void setAngleY(float angleY);
+        void setAngleZ(float angleZ);
+        void setAngle(float angleX, float angleY, float angleZ);
+
+        void rotateAngleX(float angle);
+        void rotateAngleY(float angle);
+        void rotateAngleZ(float angle);
+        void rotateAngle(float angleX, float angleY, float angleZ);
+
+        // The transform as matrices, rotating about the x, then z, then y axis:
+        // getMatrix moves points the way add does, and getInverseMatrix the way
+        // subtract does. They are rebuilt when asked for after the angles or
+        // the location change (the location is compared, as getLocation lets
+        // it be changed in place), so a transform used by several threads at
+        // once must have them built first.
+        const Matrix3x4& getMatrix() const;
+        const Matrix3x4& getInverseMatrix() const;
+
+    protected:
+        Vector3D m_location;
+
+    private:
+        float m_cosAngleX;
+        float m_sinAngleX;
+        float m_cosAngleY;
+        float m_sinAngleY;
+        float m_cosAngleZ;
+        float m_sinAngleZ;
+
+        void updateMatrices() const;
+        void addAngle(float& cosAngle, float& sinAngle, float angle);
+
+        mutable Matrix3x4 m_matrix;             // caches of the matrices
+        mutable Matrix3x4 m_inverseMatrix;
+        mutable Vector3D m_matrixLocation;      // the location they were built for
+        mutable bool m_rotationValid;           // false after the angles change
+
+    }; // Transform3D
+
+
+    //*****************************************************************
+    //
+    // Inline functions of the Matrix3x4 struct
+    //
+    //*****************************************************************
+    inline void Matrix3x4::transform(Vector3D& v) const
+    {
+        float x = m[0][0]*v.x + m[0][1]*v.y + m[0][2]*v.z + m[0][3];
+        float y = m[1][0]*v.x + m[1][1]*v.y + m[1][2]*v.z + m[1][3];
+        float z = m[2][0]*v.x + m[2][1]*v.y + m[2][2]*v.z + m[2][3];
+        v.x = x;
+        v.y = y;
+        v.z = z;
+    }
+
+    inline void Matrix3x4::rotate(Vector3D& v) const
+    {
+        float x = m[0][0]*v.x + m[0][1]*v.y + m[0][2]*v.z;
+        float y = m[1][0]*v.x + m[1][1]*v.y + m[1][2]*v.z;
+        float z = m[2][0]*v.x + m[2][1]*v.y + m[2][2]*v.z;
+        v.x = x;
+        v.y = y;
+        v.z = z;
+    }
+
+    // takes off the translation and rotates by the transpose, the inverse of
+    // a rotation
+    inline void Matrix3x4::inverseTransform(Vector3D& v) const
+    {
+        float dx = v.x - m[0][3];
+        float dy = v.y - m[1][3];
+        float dz = v.z - m[2][3];
+        v.x = m[0][0]*dx + m[1][0]*dy + m[2][0]*dz;
+        v.y = m[0][1]*dx + m[1][1]*dy + m[2][1]*dz;
+        v.z = m[0][2]*dx + m[1][2]*dy + m[2][2]*dz;
+    }
+
+    inline void Matrix3x4::multiply(const Matrix3x4& a, const Matrix3x4& b)
+    {
+        for (int i=0; i<3; i++)
+        {
+            for (int j=0; j<4; j++)
+            {
+                m[i][j] = a.m[i][0]*b.m[0][j] + a.m[i][1]*b.m[1][j] + a.m[i][2]*b.m[2][j];
+            }
+            m[i][3] += a.m[i][3];
+        }
+    }
+
+
+    //*****************************************************************
+    //
+    // Inline functions of the Transform3D class 
+    //
+    //*****************************************************************
+    inline Vector3D& Transform3D::getLocation()
+    { 
+        return m_location; 
+    }
+
+    inline void Transform3D::setLocation(const Vector3D& v) 
+    { 
+        m_location = v; 
+    } 
+
+    inline float Transform3D::getCosAngleX() const 
+    { 
+        return m_cosAngleX; 
+    }
+
+    inline float Transform3D::getSinAngleX() const 
+    { 
+        return m_sinAngleX; 
+    }
+
+    inline float Transform3D::getCosAngleY() const 
+    { 
+        return m_cosAngleY; 
+    }
+
+    inline float Transform3D::getSinAngleY() const 
+    { 
+        return m_sinAngleY; 
+    }
+
+    inline float Transform3D::getCosAngleZ() const 
+    { 
+        return m_cosAngleZ; 
+    }
+
+    inline float Transform3D::getSinAngleZ() const 
+    { 
+        return m_sinAngleZ; 
+    }
+
+    inline float Transform3D::getAngleX() const 
+    { 
+        return atan2(m_sinAngleX, m_cosAngleX); 
+    }
+
+    inline float Transform3D::getAngleY() const 
+    { 
+        return atan2(m_sinAngleY, m_cosAngleY); 
+    }
+
+    inline float Transform3D::getAngleZ() const 
+    { 
+        return atan2(m_sinAngleZ, m_cosAngleZ); 
+    }
+
+    inline void Transform3D::setAngleX(float angleX) 
+    { 
+        m_cosAngleX = cos(angleX); 
+        m_sinAngleX = sin(angleX); 
+        m_rotationValid = false;
+    }
+
+    inline void Transform3D::setAngleY(float angleY) 
+    { 
+        m_cosAngleY = cos(angleY); 
+        m_sinAngleY = sin(angleY); 
+        m_rotationValid = false;
+    }
+
+    inline void Transform3D::setAngleZ(float angleZ) 
+    { 
+        m_cosAngleZ = cos(angleZ); 
+        m_sinAngleZ = sin(angleZ); 
+        m_rotationValid = false;
+    }
+
+    inline void Transform3D::setAngle(float angleX, float angleY, float angleZ) 
+    { 
+        setAngleX(angleX); 
+        setAngleY(angleY); 
+        setAngleZ(angleZ); 
+    }
+
+    inline void Transform3D::rotateAngleX(float angle) 
+    { 
+        addAngle(m_cosAngleX, m_sinAngleX, angle);
+    }
+
+    inline void Transform3D::rotateAngleY(float angle) 
+    { 
+        addAngle(m_cosAngleY, m_sinAngleY, angle);
+    }
+
+    inline void Transform3D::rotateAngleZ(float angle) 
+    { 
+        addAngle(m_cosAngleZ, m_sinAngleZ, angle);
+    }
+
+    inline void Transform3D::rotateAngle(float angleX, float angleY, float angleZ)
+    {
+        rotateAngleX(angleX);
+        rotateAngleY(angleY);
+        rotateAngleZ(angleZ);
+    }
+
+    /*
+        Adds angle to the angle of cosAngle and sinAngle with the angle sum
+        formulas (no atan2 to get the angle back), rescaling them to length 1
+        so rounding errors don't build up.
+    */
+    inline void Transform3D::addAngle(float& cosAngle, float& sinAngle, float angle)
+    {
+        if (float_equals(angle, 0.0f))
+            return;
+
+        float cosDelta = cos(angle);
+        float sinDelta = sin(angle);
+        float newCos = cosAngle*cosDelta - sinAngle*sinDelta;
+        float newSin = sinAngle*cosDelta + cosAngle*sinDelta;
+        float scale = 1.0f / sqrt(newCos*newCos + newSin*newSin);
+        cosAngle = newCos * scale;
+        sinAngle = newSin * scale;
+        m_rotationValid = false;
+    }
+
+    inline const Matrix3x4& Transform3D::getMatrix() const
+    {
+        if (!m_rotationValid || m_location.x != m_matrixLocation.x ||
+            m_location.y != m_matrixLocation.y || m_location.z != m_matrixLocation.z)
+            updateMatrices();
+        return m_matrix;
+    }
+
+    inline const Matrix3x4& Transform3D::getInverseMatrix() const
+    {
+        if (!m_rotationValid || m_location.x != m_matrixLocation.x ||
+            m_location.y != m_matrixLocation.y || m_location.z != m_matrixLocation.z)
+            updateMatrices();
+        return m_inverseMatrix;
+    }
+
+    /*
+        The rotation is Ry * Rz * Rx, as Vector3D::addRotation applies them,
+        and its inverse is its transpose. add translates after rotating, and
+        subtract before, so the inverse's translation is the rotated
+        -location.
+    */
+    inline void Transform3D::updateMatrices() const
+    {
+        if (!m_rotationValid)
+        {
+            const float cx = m_cosAngleX, sx = m_sinAngleX;
+            const float cy = m_cosAngleY, sy = m_sinAngleY;
+            const float cz = m_cosAngleZ, sz = m_sinAngleZ;
+
+            float r[3][3] = {
+                { cy*cz, sy*sx - cy*sz*cx, sy*cx + cy*sz*sx },
+                { sz,    cz*cx,            -cz*sx           },
+                { -sy*cz, cy*sx + sy*sz*cx, cy*cx - sy*sz*sx }
+            };
+            for (int i=0; i<3; i++)
+            {
+                for (int j=0; j<3; j++)
+                {
+                    m_matrix.m[i][j] = r[i][j];
+                    m_inverseMatrix.m[i][j] = r[j][i];
+                }
+            }
+            m_rotationValid = true;
+        }
+
+        m_matrixLocation = m_location;
+        m_matrix.m[0][3] = m_location.x;
+        m_matrix.m[1][3] = m_location.y;
+        m_matrix.m[2][3] = m_location.z;
+        for (int i=0; i<3; i++)
+        {
+            m_inverseMatrix.m[i][3] = -(m_inverseMatrix.m[i][0]*m_location.x +
+                                        m_inverseMatrix.m[i][1]*m_location.y +
+                                        m_inverseMatrix.m[i][2]*m_location.z);
+        }
+    }
+
+} // Quokka3D
+
 #endif // Transform3D_h
\ No newline at end of file
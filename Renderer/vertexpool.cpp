@@ -0,0 +1,62 @@
+#include "vertexpool.h"
+#include "transform3D.h"
+#include "viewwindow.h"
+
+namespace Quokka3D
+{
+    int VertexPool::add(const Vector3D& v)
+    {
+        m_x.push_back(v.x);
+        m_y.push_back(v.y);
+        m_z.push_back(v.z);
+        return size() - 1;
+    }
+
+
+    void VertexPool::reserve(int count)
+    {
+        m_x.reserve(count);
+        m_y.reserve(count);
+        m_z.reserve(count);
+    }
+
+
+    void VertexPool::clear()
+    {
+        m_x.clear();
+        m_y.clear();
+        m_z.clear();
+    }
+
+
+    void VertexPool::transform(const Transform3D& camera, const ViewWindow& view)
+    {
+        transform(camera.getInverseMatrix(), view);
+    }
+
+
+    /*
+        The output arrays grow with the pool, so after the first frame a
+        transform only runs the kernel. The center of the view is where
+        ViewWindow::project puts view coordinates of 0.
+    */
+    void VertexPool::transform(const Matrix3x4& toCamera, const ViewWindow& view)
+    {
+        const size_t count = m_x.size();
+        if (m_viewX.size() != count)
+        {
+            m_viewX.resize(count);
+            m_viewY.resize(count);
+            m_viewZ.resize(count);
+            m_screenX.resize(count);
+            m_screenY.resize(count);
+        }
+        if (count == 0)
+            return;
+
+        VertexArrays vertices = { &m_x[0], &m_y[0], &m_z[0], &m_viewX[0], &m_viewY[0], &m_viewZ[0],
+                                  &m_screenX[0], &m_screenY[0] };
+        m_spanKernels->transformVertices(vertices, (int)count, toCamera.m, view.getDistance(),
+                                         view.convertFromViewXToScreenX(0.0f), view.convertFromViewYToScreenY(0.0f));
+    }
+}
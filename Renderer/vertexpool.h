@@ -0,0 +1,61 @@
+#ifndef VERTEXPOOL_H
+#define VERTEXPOOL_H
+
+#include <vector>
+#include "vector3d.h"
+#include "spankernels.h"
+
+namespace Quokka3D
+{
+    class ViewWindow;
+    struct Matrix3x4;
+
+    // Vertices shared between polygons, kept in separate x, y and z arrays so
+    // that the camera transform and projection run over all of them in one pass
+    // a frame, 4 or 8 vertices at a time with the SIMD span kernels. A vertex
+    // is transformed once however many polygons use it.
+    //
+    // Polygons refer to the vertices by index (Polygon3D::setIndices) and are
+    // drawn with PolygonRenderer::draw(poly, pool) after transform.
+    class VertexPool
+    {
+    public:
+        VertexPool() : m_spanKernels(&getSpanKernels()) {}
+
+        int add(const Vector3D& v);     // returns the new vertex's index
+        Vector3D get(int index) const { return Vector3D(m_x[index], m_y[index], m_z[index]); }
+        void set(int index, const Vector3D& v) { m_x[index] = v.x; m_y[index] = v.y; m_z[index] = v.z; }
+        int size() const { return (int)m_x.size(); }
+        void reserve(int count);
+        void clear();
+
+        // Moves all the vertices into camera space and projects them onto view,
+        // for the renderer with that camera and view window. Again whenever the
+        // camera or the vertices move.
+        void transform(const Transform3D& camera, const ViewWindow& view);
+        void transform(const Matrix3x4& toCamera, const ViewWindow& view);     // from the pool's own space
+
+        // The results of the last transform. The screen coordinates are only
+        // meaningful for vertices in front of the camera (view z below 0).
+        Vector3D getViewVertex(int index) const { return Vector3D(m_viewX[index], m_viewY[index], m_viewZ[index]); }
+        float getViewZ(int index) const { return m_viewZ[index]; }
+        float getScreenX(int index) const { return m_screenX[index]; }
+        float getScreenY(int index) const { return m_screenY[index]; }
+
+        void setSpanKernelLevel(SpanKernelLevel level) { m_spanKernels = &getSpanKernels(level); }
+        SpanKernelLevel getSpanKernelLevel() const { return m_spanKernels->level; }
+
+    private:
+        std::vector<float> m_x;                 // in world space
+        std::vector<float> m_y;
+        std::vector<float> m_z;
+        std::vector<float> m_viewX;             // in camera space, from transform
+        std::vector<float> m_viewY;
+        std::vector<float> m_viewZ;
+        std::vector<float> m_screenX;           // projected, from transform
+        std::vector<float> m_screenY;
+        const SpanKernels* m_spanKernels;       // the vertex pass in use
+    };
+}
+
+#endif  //VERTEXPOOL_H
@@ -1,44 +1,93 @@
-#include <cmath>
-#include "viewwindow.h"
-
-namespace Quokka3D
-{
-    /*
-        Creates a new ViewWindow with the specified bounds on the
-        screen and horizontal view angle.
-    */
-    ViewWindow::ViewWindow(int left, int top, int width, int height, float angle)
-    {
-        m_angle = angle;
-        setBounds(left, top, width, height);
-    }
-
-
-    /*
-        Sets the bounds for this ViewWindow on the screen.
-    */
-    void ViewWindow::setBounds(int left, int top, int width, int height)
-    {
-        m_bounds.x = left;
-        m_bounds.y = top;
-        m_bounds.width = width;
-        m_bounds.height = height;
-        m_distanceToCamera = (m_bounds.width/2) / tan(m_angle/2.0f);
-    }
-
- 
-    /*
-        Projects the specified vector to the screen.
-    */
-    void ViewWindow::project(Vector3D& v) const
-    {
-        // project to view window
-        v.x = m_distanceToCamera * v.x / -v.z;
-        v.y = m_distanceToCamera * v.y / -v.z;
-
-        // convert to screen coordinates
-        v.x = convertFromViewXToScreenX(v.x);
-        v.y = convertFromViewYToScreenY(v.y);
-    }
-
+#include <cmath>
+#include "viewwindow.h"
+
+namespace Quokka3D
+{
+    /*
+        Creates a new ViewWindow with the specified bounds on the
+        screen and horizontal view angle.
+    */
+    ViewWindow::ViewWindow(int left, int top, int width, int height, float angle)
+    {
+        m_angle = angle;
+        setBounds(left, top, width, height);
+    }
+
+
+    /*
+        Sets the bounds for this ViewWindow on the screen.
+    */
+    void ViewWindow::setBounds(int left, int top, int width, int height)
+    {
+        m_bounds.x = left;
+        m_bounds.y = top;
+        m_bounds.width = width;
+        m_bounds.height = height;
+        m_distanceToCamera = (m_bounds.width/2) / tan(m_angle/2.0f);
+        calcFrustum();
+    }
+
+
+    /*
+        A point is inside the right side if distance * x <= halfWidth * -z,
+        where it projects left of the window's edge, so the side's normal is
+        along (distance, 0, halfWidth), and likewise for the others.
+    */
+    void ViewWindow::calcFrustum()
+    {
+        const float halfWidth = m_bounds.width / 2.0f;
+        const float halfHeight = m_bounds.height / 2.0f;
+        const float sideLength = sqrt(m_distanceToCamera * m_distanceToCamera + halfWidth * halfWidth);
+        const float topLength = sqrt(m_distanceToCamera * m_distanceToCamera + halfHeight * halfHeight);
+
+        m_sideNormalX = (sideLength > 0.0f) ? m_distanceToCamera / sideLength : 0.0f;
+        m_sideNormalZ = (sideLength > 0.0f) ? halfWidth / sideLength : 0.0f;
+        m_topNormalY = (topLength > 0.0f) ? m_distanceToCamera / topLength : 0.0f;
+        m_topNormalZ = (topLength > 0.0f) ? halfHeight / topLength : 0.0f;
+    }
+
+
+    /*
+        The sphere is outside if its center is further than radius outside any
+        of the planes, and inside if it is at least radius inside all of them.
+    */
+    ViewWindow::Containment ViewWindow::testSphere(const Vector3D& center, float radius, float clipZ) const
+    {
+        const float sideZ = m_sideNormalZ * center.z;
+        const float topZ = m_topNormalZ * center.z;
+        const float distances[5] =
+        {
+            center.z - clipZ,                       // near
+            m_sideNormalX * center.x + sideZ,       // right
+            -m_sideNormalX * center.x + sideZ,      // left
+            m_topNormalY * center.y + topZ,         // top
+            -m_topNormalY * center.y + topZ         // bottom
+        };
+
+        Containment containment = INSIDE;
+        for (int i=0; i<5; i++)
+        {
+            if (distances[i] > radius)
+                return OUTSIDE;
+            if (distances[i] > -radius)
+                containment = INTERSECTS;
+        }
+        return containment;
+    }
+
+ 
+    /*
+        Projects the specified vector to the screen.
+    */
+    void ViewWindow::project(Vector3D& v) const
+    {
+        // project to view window
+        v.x = m_distanceToCamera * v.x / -v.z;
+        v.y = m_distanceToCamera * v.y / -v.z;
+
+        // convert to screen coordinates
+        v.x = convertFromViewXToScreenX(v.x);
+        v.y = convertFromViewYToScreenY(v.y);
+    }
+
 }
\ No newline at end of file
@@ -1,34 +1,53 @@
-#ifndef VIEWWINDOW_H
-#define VIEWWINDOW_H
-
-#include "vector3d.h"
-
-namespace Quokka3D 
-{
-    class ViewWindow
-    {
-    public:
-        ViewWindow() {m_angle = m_distanceToCamera = 0.0f; }
-        ViewWindow(int left, int top, int width, int height, float angle);
-        void setBounds(int left, int top, int width, int height);
-        void setAngle(float angle) { m_angle = angle; m_distanceToCamera = (m_bounds.width/2) / tan(m_angle/2.0f); }
-        float getAngle() const { return m_angle; }
-        int getWidth() const { return m_bounds.width; }
-        int getHeight() const { return m_bounds.height; }
-        int getTopOffset() const {  return m_bounds.y; }
-        int getLeftOffset() const {  return m_bounds.x; }
-        float getDistance() const { return m_distanceToCamera; }
-        float convertFromViewXToScreenX(float x) const { return x + m_bounds.x + m_bounds.width/2; }   
-        float convertFromViewYToScreenY(float y) const { return -y + m_bounds.y + m_bounds.height/2; }   
-        float convertFromScreenXToViewX(float x) const { return x - m_bounds.x - m_bounds.width/2; }
-        float convertFromScreenYToViewY(float y) const { return -y + m_bounds.y + m_bounds.height/2; }
-        void project(Vector3D&) const; // projects the specified vector to the screen
-
-    private:
-        Rectangle m_bounds;         // rectangular bounds for the view window on the screen
-        float m_angle;              // horizontal view angle
-        float m_distanceToCamera;   // distance from camera to view window
-    };
-}
-
+#ifndef VIEWWINDOW_H
+#define VIEWWINDOW_H
+
+#include "vector3d.h"
+
+namespace Quokka3D 
+{
+    class ViewWindow
+    {
+    public:
+        // Where a sphere lies against the view frustum
+        enum Containment
+        {
+            OUTSIDE,            // nothing of it can be seen
+            INTERSECTS,         // crosses a side of the frustum
+            INSIDE              // all of it is in view
+        };
+
+        ViewWindow() {m_angle = m_distanceToCamera = 0.0f; m_sideNormalX = m_sideNormalZ = m_topNormalY = m_topNormalZ = 0.0f; }
+        ViewWindow(int left, int top, int width, int height, float angle);
+        void setBounds(int left, int top, int width, int height);
+        void setAngle(float angle) { m_angle = angle; m_distanceToCamera = (m_bounds.width/2) / tan(m_angle/2.0f); calcFrustum(); }
+        float getAngle() const { return m_angle; }
+        int getWidth() const { return m_bounds.width; }
+        int getHeight() const { return m_bounds.height; }
+        int getTopOffset() const {  return m_bounds.y; }
+        int getLeftOffset() const {  return m_bounds.x; }
+        float getDistance() const { return m_distanceToCamera; }
+        float convertFromViewXToScreenX(float x) const { return x + m_bounds.x + m_bounds.width/2; }   
+        float convertFromViewYToScreenY(float y) const { return -y + m_bounds.y + m_bounds.height/2; }   
+        float convertFromScreenXToViewX(float x) const { return x - m_bounds.x - m_bounds.width/2; }
+        float convertFromScreenYToViewY(float y) const { return -y + m_bounds.y + m_bounds.height/2; }
+        void project(Vector3D&) const; // projects the specified vector to the screen
+
+        // Tests a sphere in camera space against the frustum of the four planes
+        // through the camera and the view window's edges, cut off at the near
+        // clip plane z = clipZ.
+        Containment testSphere(const Vector3D& center, float radius, float clipZ) const;
+
+    private:
+        void calcFrustum();
+
+        Rectangle m_bounds;         // rectangular bounds for the view window on the screen
+        float m_angle;              // horizontal view angle
+        float m_distanceToCamera;   // distance from camera to view window
+        float m_sideNormalX;        // the unit normals of the frustum's sides, pointing out:
+        float m_sideNormalZ;        //   (+-m_sideNormalX, 0, m_sideNormalZ) for right and left,
+        float m_topNormalY;         //   (0, +-m_topNormalY, m_topNormalZ) for top and bottom
+        float m_topNormalZ;
+    };
+}
+
 #endif  //VIEWWINDOW_H
\ No newline at end of file